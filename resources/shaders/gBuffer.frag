@@ -8,8 +8,10 @@ layout (location = 3) out vec3 gEffects;
 in vec3 viewPos;
 in vec2 TexCoords;
 in vec3 normal;
+in vec4 tangent;
 in vec4 fragPosition;
 in vec4 fragPrevPosition;
+flat in float fragLodFade;
 
 const float nearPlane = 1.0f;
 const float farPlane = 1000.0f;
@@ -17,31 +19,51 @@ const float farPlane = 1000.0f;
 uniform vec3 albedoColor;
 uniform sampler2D texAlbedo;
 uniform sampler2D texNormal;
-uniform sampler2D texRoughness;
-uniform sampler2D texMetalness;
 uniform sampler2D texAO;
+uniform sampler2D texRoughMetal;
 
 float LinearizeDepth(float depth);
-vec3 computeTexNormal(vec3 viewNormal, vec3 texNormal);
+vec3 computeTexNormal(vec3 viewNormal, vec4 viewTangent, vec3 texNormal);
+bool isLodDithered(float lodFade);
 
 
 void main()
 {
-    vec3 texNormal = normalize(texture(texNormal, TexCoords).rgb * 2.0f - 1.0f);
+    // Normal maps are stored as two channels (BC5), Z is rebuilt from X and Y
+    vec2 texNormalXY = texture(texNormal, TexCoords).rg * 2.0f - 1.0f;
+    vec3 texNormal = normalize(vec3(texNormalXY, sqrt(max(1.0f - dot(texNormalXY, texNormalXY), 0.0f))));
     texNormal.g = -texNormal.g;   // In case the normal map was made with DX3D coordinates system in mind
 
     vec2 fragPosA = (fragPosition.xy / fragPosition.w) * 0.5f + 0.5f;
     vec2 fragPosB = (fragPrevPosition.xy / fragPrevPosition.w) * 0.5f + 0.5f;
 
+    // Occlusion is a mask of its own (BC4), roughness and metalness come packed in two channels (BC5)
+    float occlusion = texture(texAO, TexCoords).r;
+    vec2 roughMetal = texture(texRoughMetal, TexCoords).rg;
+
     gPosition = vec4(viewPos, LinearizeDepth(gl_FragCoord.z));
     gAlbedo.rgb = vec3(texture(texAlbedo, TexCoords));
 //    gAlbedo.rgb = vec3(albedoColor);
-    gAlbedo.a =  vec3(texture(texRoughness, TexCoords)).r;
-    gNormal.rgb = computeTexNormal(normal, texNormal);
+    gAlbedo.a = roughMetal.r;
+    gNormal.rgb = computeTexNormal(normal, tangent, texNormal);
 //    gNormal.rgb = normalize(normal);
-    gNormal.a = vec3(texture(texMetalness, TexCoords)).r;
-    gEffects.r = vec3(texture(texAO, TexCoords)).r;
+    gNormal.a = roughMetal.g;
+    gEffects.r = occlusion;
     gEffects.gb = fragPosA - fragPosB;
+
+    // Cross-fading levels of detail split the pixels between them, after the texture fetches so derivatives stay defined
+    if (isLodDithered(fragLodFade))
+        discard;
+}
+
+
+
+bool isLodDithered(float lodFade)
+{
+    // Interleaved gradient noise, the finer level keeps the pixels above the fade and the coarser one the rest
+    float noise = fract(52.9829189f * fract(dot(gl_FragCoord.xy, vec2(0.06711056f, 0.00583715f))));
+
+    return lodFade > 0.0f ? noise < lodFade : (lodFade < 0.0f && noise >= -lodFade);
 }
 
 
@@ -53,16 +75,12 @@ float LinearizeDepth(float depth)
 }
 
 
-vec3 computeTexNormal(vec3 viewNormal, vec3 texNormal)
+vec3 computeTexNormal(vec3 viewNormal, vec4 viewTangent, vec3 texNormal)
 {
-    vec3 dPosX  = dFdx(viewPos);
-    vec3 dPosY  = dFdy(viewPos);
-    vec2 dTexX = dFdx(TexCoords);
-    vec2 dTexY = dFdy(TexCoords);
-
+    // Interpolated per-vertex frame, the tangent is made orthogonal again and the bitangent rebuilt on its side
     vec3 normal = normalize(viewNormal);
-    vec3 tangent = normalize(dPosX * dTexY.t - dPosY * dTexX.t);
-    vec3 binormal = -normalize(cross(normal, tangent));
+    vec3 tangent = normalize(viewTangent.xyz - normal * dot(normal, viewTangent.xyz));
+    vec3 binormal = cross(normal, tangent) * viewTangent.w;
     mat3 TBN = mat3(tangent, binormal, normal);
 
     return normalize(TBN * texNormal);
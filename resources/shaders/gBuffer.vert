@@ -1,24 +1,49 @@
 #version 400 core
 
-layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 Normal;
-layout (location = 2) in vec2 texCoords;
+// Quantized vertices (PackedVertex in mesh.h), the mesh sets the dequantization constants
+layout (location = 0) in vec4 quantizedPosition;
+layout (location = 1) in vec2 octahedralNormal;
+layout (location = 2) in vec2 octahedralTangent;
+layout (location = 3) in vec2 quantizedTexCoords;
+layout (location = 4) in vec3 positionOffset;
+layout (location = 5) in vec3 positionScale;
+layout (location = 6) in vec4 texCoordTransform;
+layout (location = 7) in float lodFade;
 
 out vec3 viewPos;
 out vec2 TexCoords;
 out vec3 normal;
+out vec4 tangent;
 out vec4 fragPosition;
 out vec4 fragPrevPosition;
+flat out float fragLodFade;
+
+#include "uniformBlocks.glsl"
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform mat4 projViewModel;
 uniform mat4 prevProjViewModel;
 
 
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 n = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = max(-n.z, 0.0f);
+    n.xy += vec2(n.x >= 0.0f ? -t : t, n.y >= 0.0f ? -t : t);
+
+    return normalize(n);
+}
+
+
 void main()
 {
+    vec3 position = positionOffset + quantizedPosition.xyz * positionScale;
+    vec3 Normal = decodeOctahedral(clamp(octahedralNormal / 32767.0f, -1.0f, 1.0f));
+    vec3 Tangent = decodeOctahedral(clamp(octahedralTangent / 32767.0f, -1.0f, 1.0f));
+    float handedness = quantizedPosition.w > 0.5f ? -1.0f : 1.0f;
+    vec2 texCoords = texCoordTransform.xy + quantizedTexCoords * texCoordTransform.zw;
+    fragLodFade = lodFade;
+
     // View Space
     vec4 viewFragPos = view * model * vec4(position, 1.0f);
     viewPos = viewFragPos.xyz;
@@ -27,6 +52,7 @@ void main()
 
     mat3 normalMatrix = transpose(inverse(mat3(view * model)));
     normal = normalMatrix * Normal;
+    tangent = vec4(mat3(view * model) * Tangent, handedness);   // Tangents follow the surface, not its normal
 
     fragPosition = projViewModel * vec4(position, 1.0f);
     fragPrevPosition = prevProjViewModel * vec4(position, 1.0f);
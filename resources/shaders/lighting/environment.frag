@@ -42,7 +42,7 @@ void main()
 {
     // Retrieve G-Buffer informations
     vec3 viewPos = texture(gPosition, TexCoords).rgb;
-    vec3 albedo = colorLinear(texture(gAlbedo, TexCoords).rgb);
+    vec3 albedo = texture(gAlbedo, TexCoords).rgb;     // sRGB target, decoded to linear by the sampler
     vec3 normal = texture(gNormal, TexCoords).rgb;
     float roughness = texture(gAlbedo, TexCoords).a;
     float metalness = texture(gNormal, TexCoords).a;
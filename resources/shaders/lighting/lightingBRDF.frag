@@ -5,6 +5,16 @@ in vec3 envMapCoords;
 out vec4 colorOutput;
 
 
+// Variant defines, injected by Shader::setVariant: POINT_LIGHTS, DIRECTIONAL_LIGHTS,
+// IBL, ATTENUATION_MODE <1-2> and GBUFFER_VIEW <1-9>
+#ifndef GBUFFER_VIEW
+#define GBUFFER_VIEW 1
+#endif
+
+#ifndef ATTENUATION_MODE
+#define ATTENUATION_MODE 2
+#endif
+
 const float PI = 3.14159265359f;
 const float prefilterLODLevel = 4.0f;
 
@@ -34,16 +44,12 @@ uniform samplerCube envMapIrradiance;
 uniform samplerCube envMapPrefilter;
 uniform sampler2D envMapLUT;
 
-uniform int gBufferView;
-uniform bool pointMode;
-uniform bool directionalMode;
-uniform bool iblMode;
-uniform int attenuationMode;
+#include "../uniformBlocks.glsl"
+
 uniform float materialRoughness;
 uniform float materialMetallicity;
 uniform float ambientIntensity;
 uniform vec3 materialF0;
-uniform mat4 view;
 
 vec3 colorLinear(vec3 colorVector);
 float saturate(float f);
@@ -60,7 +66,7 @@ void main()
 {
     // Retrieve G-Buffer informations
     vec3 viewPos = texture(gPosition, TexCoords).rgb;
-    vec3 albedo = colorLinear(texture(gAlbedo, TexCoords).rgb);
+    vec3 albedo = texture(gAlbedo, TexCoords).rgb;     // sRGB target, decoded to linear by the sampler
     vec3 normal = texture(gNormal, TexCoords).rgb;
     float roughness = texture(gAlbedo, TexCoords).a;
     float metalness = texture(gNormal, TexCoords).a;
@@ -71,6 +77,7 @@ void main()
     float sao = texture(sao, TexCoords).r;
     vec3 envColor = texture(envMap, getSphericalCoord(normalize(envMapCoords))).rgb;
 
+#if GBUFFER_VIEW == 1
     vec3 color = vec3(0.0f);
     vec3 diffuse = vec3(0.0f);
     vec3 specular = vec3(0.0f);
@@ -97,7 +104,7 @@ void main()
         vec3 kD = vec3(1.0f) - kS;
         kD *= 1.0f - metalness;
 
-        if (pointMode)
+#ifdef POINT_LIGHTS
         {
             // Point light(s) computation
             for (int i = 0; i < lightPointCounter; i++)
@@ -109,10 +116,11 @@ void main()
                 float distanceL = length(lightPointArray[i].position - viewPos);
                 float attenuation;
 
-                if(attenuationMode == 1)
-                    attenuation = 1.0f / (distanceL * distanceL); // Quadratic attenuation
-                else if(attenuationMode == 2)
-                    attenuation = pow(saturate(1 - pow(distanceL / lightPointArray[i].radius, 4)), 2) / (distanceL * distanceL + 1); // UE4 attenuation
+#if ATTENUATION_MODE == 1
+                attenuation = 1.0f / (distanceL * distanceL); // Quadratic attenuation
+#elif ATTENUATION_MODE == 2
+                attenuation = pow(saturate(1 - pow(distanceL / lightPointArray[i].radius, 4)), 2) / (distanceL * distanceL + 1); // UE4 attenuation
+#endif
 
                 // Light source dependent BRDF term(s)
                 float NdotL = saturate(dot(N, L));
@@ -138,8 +146,9 @@ void main()
                 color += (diffuse * kD + specular) * kRadiance * NdotL;
             }
         }
+#endif
 
-        if (directionalMode)
+#ifdef DIRECTIONAL_LIGHTS
         {
             for (int i = 0; i < lightDirectionalCounter; i++)
             {
@@ -169,8 +178,9 @@ void main()
                 color += (diffuse * kD + specular) * lightColor * NdotL;
             }
         }
+#endif
 
-        if (iblMode)
+#ifdef IBL
         {
             F = computeFresnelSchlickRoughness(NdotV, F0, roughness);
 
@@ -192,47 +202,48 @@ void main()
 
             color += ambientIBL;
         }
+#endif
 
         color *= ao;
     }
 
 
-    // Switching between the different buffers
+    // Switching between the different buffers, only the selected one is compiled
     // Final buffer
-    if(gBufferView == 1)
-        colorOutput = vec4(color, 1.0f);
+    colorOutput = vec4(color, 1.0f);
 
     // Position buffer
-    else if (gBufferView == 2)
-        colorOutput = vec4(viewPos, 1.0f);
+#elif GBUFFER_VIEW == 2
+    colorOutput = vec4(viewPos, 1.0f);
 
     // View Normal buffer
-    else if (gBufferView == 3)
-        colorOutput = vec4(normal, 1.0f);
+#elif GBUFFER_VIEW == 3
+    colorOutput = vec4(normal, 1.0f);
 
     // Color buffer
-    else if (gBufferView == 4)
-        colorOutput = vec4(albedo, 1.0f);
+#elif GBUFFER_VIEW == 4
+    colorOutput = vec4(albedo, 1.0f);
 
     // Roughness buffer
-    else if (gBufferView == 5)
-        colorOutput = vec4(vec3(roughness), 1.0f);
+#elif GBUFFER_VIEW == 5
+    colorOutput = vec4(vec3(roughness), 1.0f);
 
     // Metalness buffer
-    else if (gBufferView == 6)
-        colorOutput = vec4(vec3(metalness), 1.0f);
+#elif GBUFFER_VIEW == 6
+    colorOutput = vec4(vec3(metalness), 1.0f);
 
     // Depth buffer
-    else if (gBufferView == 7)
-        colorOutput = vec4(vec3(depth/1000.0f), 1.0f);
+#elif GBUFFER_VIEW == 7
+    colorOutput = vec4(vec3(depth/1000.0f), 1.0f);
 
     // SAO buffer
-    else if (gBufferView == 8)
-        colorOutput = vec4(vec3(sao), 1.0f);
+#elif GBUFFER_VIEW == 8
+    colorOutput = vec4(vec3(sao), 1.0f);
 
     // Velocity buffer
-    else if (gBufferView == 9)
-        colorOutput = vec4(velocity, 0.0f, 1.0f);
+#elif GBUFFER_VIEW == 9
+    colorOutput = vec4(velocity, 0.0f, 1.0f);
+#endif
 }
 
 
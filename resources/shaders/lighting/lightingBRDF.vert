@@ -6,8 +6,7 @@ layout (location = 1) in vec2 texCoords;
 out vec2 TexCoords;
 out vec3 envMapCoords;
 
-uniform mat4 inverseView;
-uniform mat4 inverseProj;
+#include "../uniformBlocks.glsl"
 
 void main()
 {
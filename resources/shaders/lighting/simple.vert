@@ -2,9 +2,9 @@
 
 layout (location = 0) in vec3 position;
 
+#include "../uniformBlocks.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 
 void main()
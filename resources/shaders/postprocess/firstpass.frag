@@ -3,6 +3,14 @@
 in vec2 TexCoords;
 out vec4 colorOutput;
 
+// Variant defines, injected by Shader::setVariant: FXAA, MOTION_BLUR, SAO,
+// TONEMAPPING_MODE <1-3>, DEBUG_VIEW when a G-Buffer view other than the final one is shown,
+// COLOR_VIEW when that view holds colours rather than data, and SRGB_FRAMEBUFFER when the
+// output target encodes to sRGB itself
+#ifndef TONEMAPPING_MODE
+#define TONEMAPPING_MODE 1
+#endif
+
 float FXAA_SPAN_MAX = 8.0f;
 float FXAA_REDUCE_MUL = 1.0f/8.0f;
 float FXAA_REDUCE_MIN = 1.0f/128.0f;
@@ -12,17 +20,7 @@ uniform sampler2D screenTexture;
 uniform sampler2D sao;
 uniform sampler2D gEffects;
 
-uniform int gBufferView;
-uniform int motionBlurMaxSamples;
-uniform int tonemappingMode;
-uniform bool saoMode;
-uniform bool fxaaMode;
-uniform bool motionBlurMode;
-uniform float cameraAperture;
-uniform float cameraShutterSpeed;
-uniform float cameraISO;
-uniform float motionBlurScale;
-uniform vec2 screenTextureSize;
+#include "../uniformBlocks.glsl"
 
 
 vec3 colorLinear(vec3 colorVector);
@@ -39,40 +37,43 @@ void main()
 {
     vec3 color;
 
-    if(gBufferView == 1)
+#ifndef DEBUG_VIEW
     {
         // FXAA computation
-        if(fxaaMode)
-            color = computeFxaa();  // Don't know if applying FXAA first is a good idea, especially with effects such as motion blur and DoF...
-        else
-            color = texture(screenTexture, TexCoords).rgb;
+#ifdef FXAA
+        color = computeFxaa();  // Don't know if applying FXAA first is a good idea, especially with effects such as motion blur and DoF...
+#else
+        color = texture(screenTexture, TexCoords).rgb;
+#endif
 
         // Motion Blur computation
-        if(motionBlurMode)
-            color = computeMotionBlur(color);
+#ifdef MOTION_BLUR
+        color = computeMotionBlur(color);
+#endif
 
         // SAO computation
-        if(saoMode)
+#ifdef SAO
         {
             float sao = texture(sao, TexCoords).r;
             color *= sao;
         }
+#endif
 
         // Exposure computation
         color *= computeSOBExposure(cameraAperture, cameraShutterSpeed, cameraISO);
 
         // Tonemapping computation
-        if(tonemappingMode == 1)
+#if TONEMAPPING_MODE == 1
         {
             color = ReinhardTM(color);
             colorOutput = vec4(colorSRGB(color), 1.0f);
         }
-        else if(tonemappingMode == 2)
+#elif TONEMAPPING_MODE == 2
         {
             color = FilmicTM(color);
             colorOutput = vec4(color, 1.0f);
         }
-        else if(tonemappingMode == 3)
+#elif TONEMAPPING_MODE == 3
         {
             float W = 11.2f;
             color = UnchartedTM(color);
@@ -81,20 +82,26 @@ void main()
             color *= whiteScale;
             colorOutput = vec4(colorSRGB(color), 1.0f);
         }
+#endif
     }
 
-    else    // No tonemapping or linear/sRGB conversion if we want to visualize the different buffers
+#else    // No tonemapping if we want to visualize the different buffers, only the colour ones are sRGB encoded
     {
         color = texture(screenTexture, TexCoords).rgb;
+#ifdef COLOR_VIEW
+        colorOutput = vec4(colorSRGB(color), 1.0f);
+#else
         colorOutput = vec4(color, 1.0f);
+#endif
     }
+#endif
 }
 
 
 
 vec3 computeFxaa()
 {
-    vec2 screenTextureOffset = screenTextureSize;
+    vec2 screenTextureOffset = texelSize;
     vec3 luma = vec3(0.299f, 0.587f, 0.114f);
 
     vec3 offsetNW = texture(screenTexture, TexCoords.xy + (vec2(-1.0f, -1.0f) * screenTextureOffset)).xyz;
@@ -163,9 +170,16 @@ vec3 colorLinear(vec3 colorVector)
 
 vec3 colorSRGB(vec3 colorVector)
 {
-  vec3 srgbColor = pow(colorVector.rgb, vec3(1.0f / 2.2f));
-
-  return srgbColor;
+#ifdef SRGB_FRAMEBUFFER
+  // Encoded on write by the framebuffer
+  return colorVector;
+#else
+  // Same curve as the sRGB framebuffer, for the targets without one
+  vec3 srgbLow = colorVector * 12.92f;
+  vec3 srgbHigh = 1.055f * pow(colorVector, vec3(1.0f / 2.4f)) - 0.055f;
+
+  return mix(srgbHigh, srgbLow, vec3(lessThanEqual(colorVector, vec3(0.0031308f))));
+#endif
 }
 
 
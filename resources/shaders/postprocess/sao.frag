@@ -10,14 +10,7 @@ float saoEpsilon = 0.01f;
 uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 
-uniform int viewportWidth;
-uniform int viewportHeight;
-uniform int saoSamples;
-uniform int saoTurns;
-uniform float saoRadius;
-uniform float saoBias;
-uniform float saoScale;
-uniform float saoContrast;
+#include "../uniformBlocks.glsl"
 
 
 void main(void){
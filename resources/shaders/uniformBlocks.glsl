@@ -0,0 +1,31 @@
+// Blocks shared by every program, mirrored by the std140 structs in uniformbuffer.h
+
+
+// Camera, exposure and motion blur, uploaded once per frame. GUI modes are
+// compiled into shader variants rather than read from here.
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 inverseView;
+    mat4 inverseProj;
+    vec2 viewportSize;
+    vec2 texelSize;
+    float cameraAperture;
+    float cameraShutterSpeed;
+    float cameraISO;
+    float motionBlurScale;
+    int motionBlurMaxSamples;
+};
+
+
+// SAO pass parameters
+layout (std140) uniform SAOData
+{
+    int saoSamples;
+    int saoTurns;
+    float saoRadius;
+    float saoBias;
+    float saoScale;
+    float saoContrast;
+};
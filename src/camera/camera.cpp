@@ -90,6 +90,16 @@ void Camera::scrollCall(GLfloat yoffset)
         this->cameraFOV = glm::radians(45.0f);
 }
 
+// Place the camera directly (used by scripted camera paths)
+void Camera::setCamera(glm::vec3 position, GLfloat yaw, GLfloat pitch)
+{
+    this->cameraPosition = position;
+    this->cameraYaw = yaw;
+    this->cameraPitch = pitch;
+
+    this->updateCameraVectors();
+}
+
 // Recalculates the camera vectors (front, right, and up) based on the current yaw and pitch
 void Camera::updateCameraVectors()
 {
@@ -44,6 +44,7 @@ class Camera
         void keyboardCall(Camera_Movement direction, GLfloat deltaTime);
         void mouseCall(GLfloat xoffset, GLfloat yoffset, GLboolean constrainPitch = true);
         void scrollCall(GLfloat yoffset);
+        void setCamera(glm::vec3 position, GLfloat yaw, GLfloat pitch);
 
     private:
         void updateCameraVectors();
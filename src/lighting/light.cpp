@@ -42,6 +42,12 @@ void Light::setLight(glm::vec3 position, glm::vec4 color, float radius, bool isM
         this->lightMesh.setShapeScale(glm::vec3(0.15f, 0.15f, 0.15f));
     }
 
+    // Uniform names of this light's element in the shader array
+    std::string arrayElement = "lightPointArray[" + std::to_string(this->lightPointID) + "]";
+    this->lightUniformNames[0] = arrayElement + ".position";
+    this->lightUniformNames[1] = arrayElement + ".color";
+    this->lightUniformNames[2] = arrayElement + ".radius";
+
     lightPointCount = ++lightPointCount;   // Increment the point light count
     lightPointList.push_back(*this);       // Add this light to the list of point lights
 }
@@ -54,6 +60,11 @@ void Light::setLight(glm::vec3 direction, glm::vec4 color)
     this->lightColor = color;              // Set light color
     this->lightDirectionalID = lightDirectionalCount; // Assign ID based on the current count
 
+    // Uniform names of this light's element in the shader array
+    std::string arrayElement = "lightDirectionalArray[" + std::to_string(this->lightDirectionalID) + "]";
+    this->lightUniformNames[0] = arrayElement + ".direction";
+    this->lightUniformNames[1] = arrayElement + ".color";
+
     lightDirectionalCount = ++lightDirectionalCount; // Increment the directional light count
     lightDirectionalList.push_back(*this);           // Add this light to the list of directional lights
 }
@@ -63,44 +74,24 @@ void Light::renderToShader(Shader& shader, Camera& camera)
 {
     shader.useShader(); // Activate the shader program
 
-    // Cache the uniform locations to avoid multiple lookups
-    GLint lightPositionLoc = -1;
-    GLint lightColorLoc = -1;
-    GLint lightRadiusLoc = -1;
-    GLint lightDirectionLoc = -1;
-
     if (this->lightType == "point")
     {
         // Compute the light's position in view space
         glm::vec3 lightPositionViewSpace = glm::vec3(camera.GetViewMatrix() * glm::vec4(this->lightPosition, 1.0f));
 
-        // Cache uniform locations if not already cached
-        if (lightPositionLoc == -1)
-            lightPositionLoc = glGetUniformLocation(shader.Program, ("lightPointArray[" + std::to_string(this->lightPointID) + "].position").c_str());
-        if (lightColorLoc == -1)
-            lightColorLoc = glGetUniformLocation(shader.Program, ("lightPointArray[" + std::to_string(this->lightPointID) + "].color").c_str());
-        if (lightRadiusLoc == -1)
-            lightRadiusLoc = glGetUniformLocation(shader.Program, ("lightPointArray[" + std::to_string(this->lightPointID) + "].radius").c_str());
-
-        // Set point light uniforms in the shader
-        glUniform3f(lightPositionLoc, lightPositionViewSpace.x, lightPositionViewSpace.y, lightPositionViewSpace.z);
-        glUniform4f(lightColorLoc, this->lightColor.r, this->lightColor.g, this->lightColor.b, this->lightColor.a);
-        glUniform1f(lightRadiusLoc, this->lightRadius);
+        // Set point light uniforms in the shader, unchanged values are not uploaded again
+        shader.setVec3(this->lightUniformNames[0], lightPositionViewSpace);
+        shader.setVec4(this->lightUniformNames[1], this->lightColor);
+        shader.setFloat(this->lightUniformNames[2], this->lightRadius);
     }
     else if (this->lightType == "directional")
     {
         // Compute the light's direction in view space
         glm::vec3 lightDirectionViewSpace = glm::vec3(camera.GetViewMatrix() * glm::vec4(this->lightDirection, 0.0f));
 
-        // Cache uniform locations if not already cached
-        if (lightDirectionLoc == -1)
-            lightDirectionLoc = glGetUniformLocation(shader.Program, ("lightDirectionalArray[" + std::to_string(this->lightDirectionalID) + "].direction").c_str());
-        if (lightColorLoc == -1)
-            lightColorLoc = glGetUniformLocation(shader.Program, ("lightDirectionalArray[" + std::to_string(this->lightDirectionalID) + "].color").c_str());
-
         // Set directional light uniforms in the shader
-        glUniform3f(lightDirectionLoc, lightDirectionViewSpace.x, lightDirectionViewSpace.y, lightDirectionViewSpace.z);
-        glUniform4f(lightColorLoc, this->lightColor.r, this->lightColor.g, this->lightColor.b, this->lightColor.a);
+        shader.setVec3(this->lightUniformNames[0], lightDirectionViewSpace);
+        shader.setVec4(this->lightUniformNames[1], this->lightColor);
     }
 }
 
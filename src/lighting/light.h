@@ -29,6 +29,7 @@ class Light
         glm::vec3 lightDirection;
         glm::vec4 lightColor;
         Shape lightMesh;
+        std::string lightUniformNames[3];   // Array element uniforms, built once when the light is set
 
         Light();
         ~Light();
@@ -3,20 +3,72 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <cmath>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "mesh.h"
+#include "resourceregistry.h"
 
 
-Mesh::Mesh(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+// Quantized value of a coordinate within [offset, offset + 65535 * scale]
+static GLushort quantizeUnorm(GLfloat value, GLfloat offset, GLfloat scale)
 {
-    this->vertices = vertices;
-    this->indices = indices;
+    if (scale <= 0.0f)
+        return 0;
 
-    this->setupMesh();
+    return (GLushort)std::floor(glm::clamp((value - offset) / scale, 0.0f, 65535.0f) + 0.5f);
+}
+
+
+static GLshort quantizeSnorm(GLfloat value)
+{
+    return (GLshort)std::floor(glm::clamp(value, -1.0f, 1.0f) * 32767.0f + 0.5f);
+}
+
+
+// Octahedral: project onto the octahedron, then fold the lower half over the diagonals
+static void encodeOctahedral(glm::vec3 direction, GLshort encoded[2])
+{
+    GLfloat directionL1 = std::fabs(direction.x) + std::fabs(direction.y) + std::fabs(direction.z);
+    direction = directionL1 > 0.0f ? direction / directionL1 : glm::vec3(0.0f, 0.0f, 1.0f);
+
+    glm::vec2 octahedral(direction.x, direction.y);
+
+    if (direction.z < 0.0f)
+    {
+        octahedral.x = (1.0f - std::fabs(direction.y)) * (direction.x >= 0.0f ? 1.0f : -1.0f);
+        octahedral.y = (1.0f - std::fabs(direction.x)) * (direction.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    encoded[0] = quantizeSnorm(octahedral.x);
+    encoded[1] = quantizeSnorm(octahedral.y);
+}
+
+
+// The next coarser level starts fading in once its error drops under this many times the threshold
+static const GLfloat LOD_FADE_RANGE = 1.5f;
+
+
+// The vertex and index data is only read during the upload, it can point into a mapped mesh cache
+Mesh::Mesh(const PackedVertex* vertices, GLuint vertexCount, const void* indices, GLuint indexCount, GLenum indexType, const VertexQuantization& quantization)
+{
+    this->vertexCount = vertexCount;
+    this->indexCount = indexCount;
+    this->indexType = indexType;
+    this->quantization = quantization;
+    this->lodLevel = 0;
+    this->lodFade = 0.0f;
+
+    MeshLod fullLod;
+    fullLod.indexOffset = 0;
+    fullLod.indexCount = indexCount;
+    fullLod.lodError = 0.0f;
+    this->lods.push_back(fullLod);
+
+    this->setupMesh(vertices, indices);
 }
 
 Mesh::~Mesh()
@@ -29,12 +81,153 @@ void Mesh::Draw()
 {
     glActiveTexture(GL_TEXTURE0);
 
+    // Dequantization is per mesh, it goes in through the current values of attributes no buffer feeds
+    glVertexAttrib3fv(4, &this->quantization.positionOffset[0]);
+    glVertexAttrib3fv(5, &this->quantization.positionScale[0]);
+    glVertexAttrib4f(6, this->quantization.texCoordOffset.x, this->quantization.texCoordOffset.y, this->quantization.texCoordScale.x, this->quantization.texCoordScale.y);
+
     glBindVertexArray(this->VAO);
-    glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
+
+    // While the next level fades in both are drawn, each one discarding the pixels the other keeps
+    if (this->lodFade > 0.0f && this->lodLevel + 1 < this->lods.size())
+    {
+        this->drawLod(this->lodLevel, this->lodFade);
+        this->drawLod(this->lodLevel + 1, -this->lodFade);
+    }
+    else
+        this->drawLod(this->lodLevel, 0.0f);
+
     glBindVertexArray(0);
 }
 
-void Mesh::setupMesh()
+
+void Mesh::drawLod(GLuint level, GLfloat fade)
+{
+    const MeshLod& lod = this->lods[level];
+
+    glVertexAttrib1f(7, fade);
+    glDrawElements(GL_TRIANGLES, lod.indexCount, this->indexType, (GLvoid*)((size_t)lod.indexOffset * getIndexBytes(this->indexType)));
+}
+
+
+void Mesh::selectLod(GLfloat pixelsPerUnit, GLfloat errorPixels, bool crossFade)
+{
+    this->resetLod();
+
+    // Without a projection every error would pass, the full mesh is the only safe choice
+    if (pixelsPerUnit <= 0.0f)
+        return;
+
+    // Coarsest level whose error covers less than the threshold on screen
+    for (GLuint level = 1; level < this->lods.size(); ++level)
+    {
+        if (this->lods[level].lodError * pixelsPerUnit > errorPixels)
+            break;
+
+        this->lodLevel = level;
+    }
+
+    if (!crossFade || this->lodLevel + 1 >= this->lods.size())
+        return;
+
+    // Fades in linearly so the swap to the next level happens once it already covers every pixel
+    GLfloat nextError = this->lods[this->lodLevel + 1].lodError * pixelsPerUnit;
+    GLfloat fadeStart = errorPixels * LOD_FADE_RANGE;
+
+    if (nextError < fadeStart)
+        this->lodFade = glm::clamp((fadeStart - nextError) / (fadeStart - errorPixels), 0.0f, 1.0f);
+}
+
+
+void Mesh::resetLod()
+{
+    this->lodLevel = 0;
+    this->lodFade = 0.0f;
+}
+
+
+GLuint Mesh::getDrawnTriangles() const
+{
+    GLuint drawnTriangles = this->lods[this->lodLevel].indexCount / 3;
+
+    if (this->lodFade > 0.0f && this->lodLevel + 1 < this->lods.size())
+        drawnTriangles += this->lods[this->lodLevel + 1].indexCount / 3;
+
+    return drawnTriangles;
+}
+
+
+void Mesh::releaseMesh()
+{
+    // Meshes are copied around by value, so the GL objects are released explicitly by the owning model
+    glDeleteVertexArrays(1, &this->VAO);
+    glDeleteBuffers(1, &this->VBO);
+    glDeleteBuffers(1, &this->EBO);
+
+    ResourceRegistry::removeResource(RESOURCE_BUFFER, this->VBO);
+    ResourceRegistry::removeResource(RESOURCE_BUFFER, this->EBO);
+
+    this->VAO = 0;
+    this->VBO = 0;
+    this->EBO = 0;
+}
+
+VertexQuantization Mesh::getQuantization(const Vertex* vertices, GLuint vertexCount)
+{
+    VertexQuantization quantization;
+    glm::vec3 positionMin(0.0f), positionMax(0.0f);
+    glm::vec2 texCoordMin(0.0f), texCoordMax(0.0f);
+
+    for (GLuint i = 0; i < vertexCount; ++i)
+    {
+        positionMin = i == 0 ? vertices[i].Position : glm::min(positionMin, vertices[i].Position);
+        positionMax = i == 0 ? vertices[i].Position : glm::max(positionMax, vertices[i].Position);
+        texCoordMin = i == 0 ? vertices[i].TexCoords : glm::min(texCoordMin, vertices[i].TexCoords);
+        texCoordMax = i == 0 ? vertices[i].TexCoords : glm::max(texCoordMax, vertices[i].TexCoords);
+    }
+
+    // 16 bits over the extent of every axis, a flat axis keeps its single value in the offset
+    quantization.positionOffset = positionMin;
+    quantization.positionScale = (positionMax - positionMin) / 65535.0f;
+    quantization.texCoordOffset = texCoordMin;
+    quantization.texCoordScale = (texCoordMax - texCoordMin) / 65535.0f;
+
+    return quantization;
+}
+
+
+PackedVertex Mesh::packVertex(const Vertex& vertex, const VertexQuantization& quantization)
+{
+    PackedVertex packed;
+
+    for (GLuint c = 0; c < 3; ++c)
+        packed.Position[c] = quantizeUnorm(vertex.Position[c], quantization.positionOffset[c], quantization.positionScale[c]);
+
+    packed.Position[3] = vertex.Tangent.w < 0.0f ? 1 : 0;
+
+    encodeOctahedral(vertex.Normal, packed.Normal);
+    encodeOctahedral(glm::vec3(vertex.Tangent), packed.Tangent);
+
+    for (GLuint c = 0; c < 2; ++c)
+        packed.TexCoords[c] = quantizeUnorm(vertex.TexCoords[c], quantization.texCoordOffset[c], quantization.texCoordScale[c]);
+
+    return packed;
+}
+
+
+GLenum Mesh::getIndexType(GLuint vertexCount)
+{
+    return vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+
+GLuint Mesh::getIndexBytes(GLenum indexType)
+{
+    return indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+}
+
+
+void Mesh::setupMesh(const PackedVertex* vertices, const void* indices)
 {
     // Generate and bind VAO, VBO, and EBO
     glGenVertexArrays(1, &this->VAO);
@@ -44,20 +237,29 @@ void Mesh::setupMesh()
     glBindVertexArray(this->VAO);
 
     // Bind VBO and upload vertex data
+    GLuint64 vertexBytes = (GLuint64)this->vertexCount * sizeof(PackedVertex);
+    GLuint64 indexBytes = (GLuint64)this->indexCount * getIndexBytes(this->indexType);
+
     glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(Vertex), &this->vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW);
 
     // Bind EBO and upload index data
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint), &this->indices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
+
+    // No host copy is kept, the buffers are the only place the geometry lives after loading
+    ResourceRegistry::addBuffer(this->VBO, GL_ARRAY_BUFFER, vertexBytes, 0);
+    ResourceRegistry::addBuffer(this->EBO, GL_ELEMENT_ARRAY_BUFFER, indexBytes, 0);
 
-    // Set vertex attribute pointers
+    // Set vertex attribute pointers, integers converted to float as they are, the shader applies the scales
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)0); // Position
+    glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(PackedVertex), (GLvoid*)0); // Position and Handedness
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, Normal)); // Normal
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (GLvoid*)offsetof(PackedVertex, Normal)); // Normal
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, TexCoords)); // Texture Coordinates
+    glVertexAttribPointer(2, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (GLvoid*)offsetof(PackedVertex, Tangent)); // Tangent
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(PackedVertex), (GLvoid*)offsetof(PackedVertex, TexCoords)); // Texture Coordinates
 
     // Unbind VAO
     glBindVertexArray(0);
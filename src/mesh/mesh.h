@@ -11,26 +11,68 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 
+// Imported vertex, full floats
 struct Vertex {
         glm::vec3 Position;
         glm::vec3 Normal;
         glm::vec2 TexCoords;
+        glm::vec4 Tangent;          // Along +U, orthogonal to the normal, w is the handedness of the bitangent
 };
 
 
+// Vertex as the buffers store it, 20 bytes instead of 48. Decoded by gBuffer.vert
+struct PackedVertex {
+        GLushort Position[4];       // Quantized within the mesh bounds, the fourth is the tangent handedness, 1 when mirrored
+        GLshort Normal[2];          // Octahedral
+        GLshort Tangent[2];         // Octahedral
+        GLushort TexCoords[2];      // Quantized within the mesh UV bounds
+};
+
+
+// Turns quantized positions and UVs back into object space and texture space, offset + value * scale
+struct VertexQuantization {
+        glm::vec3 positionOffset, positionScale;
+        glm::vec2 texCoordOffset, texCoordScale;
+};
+
+
+// One level of detail, a range of the index buffer over the shared vertices
+struct MeshLod {
+        GLuint indexOffset, indexCount;
+        GLfloat lodError;                       // Object space distance to the full mesh, at most
+};
+
+
+static const GLuint MAX_MESH_LODS = 6;
+
+
 class Mesh {
     public:
-        std::vector<Vertex> vertices;
-        std::vector<GLuint> indices;
+        GLuint vertexCount, indexCount;
+        GLenum indexType;                       // GL_UNSIGNED_SHORT whenever every vertex can be addressed with it
+        VertexQuantization quantization;
+        std::vector<MeshLod> lods;              // Finest first, the full mesh when there is no chain
+        GLuint lodLevel;                        // Selected for the next draws
+        GLfloat lodFade;                        // How far the next coarser level has dithered in
 
-        Mesh(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+        Mesh(const PackedVertex* vertices, GLuint vertexCount, const void* indices, GLuint indexCount, GLenum indexType, const VertexQuantization& quantization);
         ~Mesh();
         void Draw();
+        void releaseMesh();
+        void selectLod(GLfloat pixelsPerUnit, GLfloat errorPixels, bool crossFade);
+        void resetLod();
+        GLuint getDrawnTriangles() const;
+
+        static VertexQuantization getQuantization(const Vertex* vertices, GLuint vertexCount);
+        static PackedVertex packVertex(const Vertex& vertex, const VertexQuantization& quantization);
+        static GLenum getIndexType(GLuint vertexCount);
+        static GLuint getIndexBytes(GLenum indexType);
 
     private:
         GLuint VAO, VBO, EBO;
 
-        void setupMesh();
+        void setupMesh(const PackedVertex* vertices, const void* indices);
+        void drawLod(GLuint level, GLfloat fade);
 };
 
 
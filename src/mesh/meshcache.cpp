@@ -0,0 +1,363 @@
+#include <string>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "meshcache.h"
+
+
+// Header of a .lmesh file, the mesh table follows it
+struct CacheHeader
+{
+    GLuint meshMagic, meshVersion;
+    GLuint meshCount;
+    GLuint vertexStride;                    // Caches cooked for another packed vertex layout are imported again
+    GLuint64 sourceHash;
+    GLuint64 fileSize;                      // Of the .lmesh itself, a truncated copy is rejected up front
+    GLfloat boundsMin[3], boundsMax[3];
+};
+
+
+struct CacheMesh
+{
+    GLuint64 vertexOffset, indexOffset;     // From the start of the file
+    GLuint vertexCount, indexCount;
+    GLuint indexType;
+    GLfloat boundsMin[3], boundsMax[3];
+    GLfloat positionOffset[3], positionScale[3];
+    GLfloat texCoordOffset[2], texCoordScale[2];
+    GLuint lodCount;                        // Levels are ranges of the index blob, the full mesh first
+    GLuint lodIndexOffset[MAX_MESH_LODS], lodIndexCount[MAX_MESH_LODS];
+    GLfloat lodError[MAX_MESH_LODS];
+};
+
+
+static const GLuint CACHE_MAGIC = 0x48534D4C;               // "LMSH"
+static const GLuint CACHE_VERSION = 6;                      // 2: welded and reordered on import, 3: quantized, 4: LOD chains, 5: tangents, 6: LOD collapse checks
+static const GLuint CACHE_ALIGNMENT = 64;                   // Every blob starts on a cache line
+static const GLuint CACHE_MAX_MESHES = 65536;
+
+
+static GLuint64 alignOffset(GLuint64 offset)
+{
+    return (offset + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+}
+
+
+CookedMesh::CookedMesh()
+    : mappedVertices(NULL), mappedIndices(NULL), vertexCount(0), indexCount(0), indexType(GL_UNSIGNED_INT), boundsMin(0.0f), boundsMax(0.0f)
+{
+    this->quantization.positionOffset = glm::vec3(0.0f);
+    this->quantization.positionScale = glm::vec3(0.0f);
+    this->quantization.texCoordOffset = glm::vec2(0.0f);
+    this->quantization.texCoordScale = glm::vec2(0.0f);
+}
+
+
+const PackedVertex* CookedMesh::getVertices() const
+{
+    return this->packedVertices.empty() ? this->mappedVertices : &this->packedVertices[0];
+}
+
+
+const unsigned char* CookedMesh::getIndices() const
+{
+    return this->packedIndices.empty() ? this->mappedIndices : &this->packedIndices[0];
+}
+
+
+GLuint64 CookedMesh::getIndexBytes() const
+{
+    return (GLuint64)this->indexCount * Mesh::getIndexBytes(this->indexType);
+}
+
+
+std::string MeshCache::getCachePath(const std::string& modelPath)
+{
+    // resources/models/statue/statue.obj -> resources/models/statue/statue.lmesh
+    size_t extension = modelPath.find_last_of('.');
+    size_t directory = modelPath.find_last_of("/\\");
+
+    if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+        return modelPath + ".lmesh";
+
+    return modelPath.substr(0, extension) + ".lmesh";
+}
+
+
+bool MeshCache::hashFile(const std::string& filePath, GLuint64& fileHash)
+{
+    // FNV-1a over the whole source, timestamps change on checkout while the contents do not
+    FileMapping mapping;
+
+    if (!mapping.mapFile(filePath))
+        return false;
+
+    const unsigned char* fileData = mapping.getData();
+    GLuint64 hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < mapping.getSize(); ++i)
+    {
+        hash ^= fileData[i];
+        hash *= 1099511628211ULL;
+    }
+
+    // The size goes in too, so an empty source does not hash like a missing one
+    fileHash = hash ^ (GLuint64)mapping.getSize();
+
+    return true;
+}
+
+
+bool MeshCache::loadCache(const std::string& cachePath, bool checkSource, GLuint64 sourceHash, CookedModel& model)
+{
+    std::shared_ptr<FileMapping> mapping = std::make_shared<FileMapping>();
+
+    if (!mapping->mapFile(cachePath) || mapping->getSize() < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+
+    // Cooked from another version of the source, by another layout, or cut short
+    if (header.meshMagic != CACHE_MAGIC || header.meshVersion != CACHE_VERSION || header.vertexStride != sizeof(PackedVertex) ||
+        header.meshCount == 0 || header.meshCount > CACHE_MAX_MESHES || header.fileSize != mapping->getSize() ||
+        (checkSource && header.sourceHash != sourceHash) || mapping->getSize() < sizeof(header) + header.meshCount * sizeof(CacheMesh))
+        return false;
+
+    std::vector<CacheMesh> entries(header.meshCount);
+    std::memcpy(&entries[0], mapping->getData() + sizeof(header), entries.size() * sizeof(CacheMesh));
+
+    model.meshes.clear();
+    model.meshes.resize(entries.size());
+
+    // Uploads read the blobs in place, any offset outside the file means the file is not ours to trust
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const CacheMesh& entry = entries[i];
+        GLuint64 vertexEnd = entry.vertexOffset + (GLuint64)entry.vertexCount * sizeof(PackedVertex);
+        GLuint64 indexEnd = entry.indexOffset + (GLuint64)entry.indexCount * Mesh::getIndexBytes(entry.indexType);
+
+        // Empty meshes are zero-length entries, but indices without vertices are not
+        if ((entry.vertexCount == 0 && entry.indexCount != 0) || entry.vertexOffset % CACHE_ALIGNMENT != 0 || entry.indexOffset % CACHE_ALIGNMENT != 0 ||
+            vertexEnd > mapping->getSize() || indexEnd > mapping->getSize() || entry.indexType != Mesh::getIndexType(entry.vertexCount) ||
+            entry.lodCount == 0 || entry.lodCount > MAX_MESH_LODS)
+        {
+            model.meshes.clear();
+            return false;
+        }
+
+        CookedMesh& mesh = model.meshes[i];
+
+        for (GLuint level = 0; level < entry.lodCount; ++level)
+        {
+            if ((entry.lodIndexCount[level] == 0 && entry.indexCount != 0) || (GLuint64)entry.lodIndexOffset[level] + entry.lodIndexCount[level] > entry.indexCount)
+            {
+                model.meshes.clear();
+                return false;
+            }
+
+            MeshLod lod;
+            lod.indexOffset = entry.lodIndexOffset[level];
+            lod.indexCount = entry.lodIndexCount[level];
+            lod.lodError = entry.lodError[level];
+            mesh.lods.push_back(lod);
+        }
+
+        mesh.mappedVertices = (const PackedVertex*)(mapping->getData() + entry.vertexOffset);
+        mesh.mappedIndices = mapping->getData() + entry.indexOffset;
+        mesh.vertexCount = entry.vertexCount;
+        mesh.indexCount = entry.indexCount;
+        mesh.indexType = entry.indexType;
+        mesh.quantization.positionOffset = glm::vec3(entry.positionOffset[0], entry.positionOffset[1], entry.positionOffset[2]);
+        mesh.quantization.positionScale = glm::vec3(entry.positionScale[0], entry.positionScale[1], entry.positionScale[2]);
+        mesh.quantization.texCoordOffset = glm::vec2(entry.texCoordOffset[0], entry.texCoordOffset[1]);
+        mesh.quantization.texCoordScale = glm::vec2(entry.texCoordScale[0], entry.texCoordScale[1]);
+        mesh.boundsMin = glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+        mesh.boundsMax = glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+    }
+
+    model.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    model.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    model.mapping = mapping;
+
+    return true;
+}
+
+
+bool MeshCache::saveCache(const std::string& cachePath, GLuint64 sourceHash, const CookedModel& model)
+{
+    if (model.meshes.empty() || model.meshes.size() > CACHE_MAX_MESHES)
+        return false;
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.meshMagic = CACHE_MAGIC;
+    header.meshVersion = CACHE_VERSION;
+    header.meshCount = model.meshes.size();
+    header.vertexStride = sizeof(PackedVertex);
+    header.sourceHash = sourceHash;
+    std::memcpy(header.boundsMin, &model.boundsMin[0], sizeof(header.boundsMin));
+    std::memcpy(header.boundsMax, &model.boundsMax[0], sizeof(header.boundsMax));
+
+    std::vector<CacheMesh> entries(header.meshCount);
+    std::memset(&entries[0], 0, entries.size() * sizeof(CacheMesh));
+    GLuint64 blobOffset = alignOffset(sizeof(header) + entries.size() * sizeof(CacheMesh));
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const CookedMesh& mesh = model.meshes[i];
+
+        // Empty meshes are written as zero-length entries, so the table still matches the source's meshes
+        if ((mesh.vertexCount != 0 && mesh.getVertices() == NULL) || (mesh.indexCount != 0 && (mesh.vertexCount == 0 || mesh.getIndices() == NULL)) ||
+            mesh.lods.empty() || mesh.lods.size() > MAX_MESH_LODS)
+            return false;
+
+        entries[i].vertexOffset = blobOffset;
+        entries[i].vertexCount = mesh.vertexCount;
+        blobOffset = alignOffset(blobOffset + (GLuint64)mesh.vertexCount * sizeof(PackedVertex));
+
+        entries[i].indexOffset = blobOffset;
+        entries[i].indexCount = mesh.indexCount;
+        entries[i].indexType = mesh.indexType;
+        blobOffset = alignOffset(blobOffset + mesh.getIndexBytes());
+
+        std::memcpy(entries[i].boundsMin, &mesh.boundsMin[0], sizeof(entries[i].boundsMin));
+        std::memcpy(entries[i].boundsMax, &mesh.boundsMax[0], sizeof(entries[i].boundsMax));
+        std::memcpy(entries[i].positionOffset, &mesh.quantization.positionOffset[0], sizeof(entries[i].positionOffset));
+        std::memcpy(entries[i].positionScale, &mesh.quantization.positionScale[0], sizeof(entries[i].positionScale));
+        std::memcpy(entries[i].texCoordOffset, &mesh.quantization.texCoordOffset[0], sizeof(entries[i].texCoordOffset));
+        std::memcpy(entries[i].texCoordScale, &mesh.quantization.texCoordScale[0], sizeof(entries[i].texCoordScale));
+        entries[i].lodCount = mesh.lods.size();
+
+        for (GLuint level = 0; level < mesh.lods.size(); ++level)
+        {
+            entries[i].lodIndexOffset[level] = mesh.lods[level].indexOffset;
+            entries[i].lodIndexCount[level] = mesh.lods[level].indexCount;
+            entries[i].lodError[level] = mesh.lods[level].lodError;
+        }
+    }
+
+    header.fileSize = blobOffset;
+
+    // Written aside and renamed over the old one, a model still mapped from it keeps its pages
+    std::string tempPath = cachePath + ".tmp";
+    std::ofstream cacheFile(tempPath.c_str(), std::ios::binary);
+
+    if (!cacheFile.is_open())
+        return false;
+
+    std::vector<char> padding(CACHE_ALIGNMENT, 0);
+    GLuint64 fileOffset = sizeof(header) + entries.size() * sizeof(CacheMesh);
+
+    cacheFile.write((const char*)&header, sizeof(header));
+    cacheFile.write((const char*)&entries[0], entries.size() * sizeof(CacheMesh));
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const CookedMesh& mesh = model.meshes[i];
+
+        cacheFile.write(&padding[0], entries[i].vertexOffset - fileOffset);
+
+        if (mesh.vertexCount > 0)
+            cacheFile.write((const char*)mesh.getVertices(), (GLuint64)mesh.vertexCount * sizeof(PackedVertex));
+
+        fileOffset = entries[i].vertexOffset + (GLuint64)mesh.vertexCount * sizeof(PackedVertex);
+
+        cacheFile.write(&padding[0], entries[i].indexOffset - fileOffset);
+
+        if (mesh.indexCount > 0)
+            cacheFile.write((const char*)mesh.getIndices(), mesh.getIndexBytes());
+
+        fileOffset = entries[i].indexOffset + mesh.getIndexBytes();
+    }
+
+    cacheFile.write(&padding[0], header.fileSize - fileOffset);
+    cacheFile.close();
+
+    if (!cacheFile)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(cachePath.c_str());
+#endif
+
+    return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+}
+
+
+void MeshCache::computeBounds(CookedModel& model)
+{
+    model.boundsMin = glm::vec3(0.0f);
+    model.boundsMax = glm::vec3(0.0f);
+    bool boundsSet = false;
+
+    for (size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        CookedMesh& mesh = model.meshes[i];
+        const std::vector<Vertex>& vertices = mesh.vertices;
+
+        if (vertices.empty())
+            continue;
+
+        mesh.boundsMin = mesh.boundsMax = vertices[0].Position;
+
+        for (size_t v = 1; v < vertices.size(); ++v)
+        {
+            mesh.boundsMin = glm::min(mesh.boundsMin, vertices[v].Position);
+            mesh.boundsMax = glm::max(mesh.boundsMax, vertices[v].Position);
+        }
+
+        model.boundsMin = boundsSet ? glm::min(model.boundsMin, mesh.boundsMin) : mesh.boundsMin;
+        model.boundsMax = boundsSet ? glm::max(model.boundsMax, mesh.boundsMax) : mesh.boundsMax;
+        boundsSet = true;
+    }
+}
+
+
+void MeshCache::packMesh(CookedMesh& mesh)
+{
+    // Imported floats to the layout the buffers take, the full precision lists are released afterwards
+    mesh.vertexCount = mesh.vertices.size();
+    mesh.indexCount = mesh.indices.size();
+
+    if (mesh.lods.empty())
+    {
+        MeshLod fullLod;
+        fullLod.indexOffset = 0;
+        fullLod.indexCount = mesh.indexCount;
+        fullLod.lodError = 0.0f;
+        mesh.lods.push_back(fullLod);
+    }
+
+    mesh.indexType = Mesh::getIndexType(mesh.vertexCount);
+    mesh.quantization = Mesh::getQuantization(mesh.vertices.empty() ? NULL : &mesh.vertices[0], mesh.vertexCount);
+
+    mesh.packedVertices.resize(mesh.vertexCount);
+
+    for (GLuint v = 0; v < mesh.vertexCount; ++v)
+        mesh.packedVertices[v] = Mesh::packVertex(mesh.vertices[v], mesh.quantization);
+
+    mesh.packedIndices.resize(mesh.getIndexBytes());
+
+    if (mesh.indexType == GL_UNSIGNED_SHORT)
+    {
+        GLushort* shortIndices = (GLushort*)(mesh.packedIndices.empty() ? NULL : &mesh.packedIndices[0]);
+
+        for (GLuint i = 0; i < mesh.indexCount; ++i)
+            shortIndices[i] = (GLushort)mesh.indices[i];
+    }
+    else if (mesh.indexCount > 0)
+        std::memcpy(&mesh.packedIndices[0], &mesh.indices[0], mesh.getIndexBytes());
+
+    std::vector<Vertex>().swap(mesh.vertices);
+    std::vector<GLuint>().swap(mesh.indices);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "filemapping.h"
+
+
+// Geometry of one mesh ready to upload, either gathered by the importer or read straight from the mapped .lmesh
+struct CookedMesh
+{
+    std::vector<Vertex> vertices;               // Imported, full floats
+    std::vector<GLuint> indices;
+    std::vector<PackedVertex> packedVertices;   // What the buffers take, every list stays empty when mapped
+    std::vector<unsigned char> packedIndices;
+    const PackedVertex* mappedVertices;         // Inside the mapping
+    const unsigned char* mappedIndices;
+    GLuint vertexCount, indexCount;
+    GLenum indexType;
+    VertexQuantization quantization;
+    std::vector<MeshLod> lods;                  // Ranges of the index list, the full mesh first
+    glm::vec3 boundsMin, boundsMax;
+
+    CookedMesh();
+    const PackedVertex* getVertices() const;
+    const unsigned char* getIndices() const;
+    GLuint64 getIndexBytes() const;
+};
+
+
+struct CookedModel
+{
+    std::vector<CookedMesh> meshes;
+    glm::vec3 boundsMin, boundsMax;
+    std::shared_ptr<FileMapping> mapping;   // Keeps mapped meshes readable until they are uploaded
+};
+
+
+// .lmesh files: a small header with the hash of the source and the model bounds, a table
+// of meshes, then for every mesh its quantized vertices and its 16 or 32 bit indices in
+// the exact layout the vertex and element buffers take them. Loading one is a file mapping and
+// two buffer uploads per mesh, Assimp only runs when the source is new or was edited.
+// They are written next to their source when it is first imported.
+class MeshCache
+{
+    public:
+        static std::string getCachePath(const std::string& modelPath);
+        static bool hashFile(const std::string& filePath, GLuint64& fileHash);
+        static bool loadCache(const std::string& cachePath, bool checkSource, GLuint64 sourceHash, CookedModel& model);
+        static bool saveCache(const std::string& cachePath, GLuint64 sourceHash, const CookedModel& model);
+        static void computeBounds(CookedModel& model);
+        static void packMesh(CookedMesh& mesh);
+};
@@ -0,0 +1,398 @@
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "meshoptimizer.h"
+
+
+// Vertices are welded only when every attribute matches bit for bit, so the mesh renders exactly as imported
+struct VertexHash
+{
+    size_t operator()(const Vertex& vertex) const
+    {
+        const unsigned char* vertexBytes = (const unsigned char*)&vertex;
+        size_t hash = 2166136261u;
+
+        for (size_t i = 0; i < sizeof(Vertex); ++i)
+            hash = (hash ^ vertexBytes[i]) * 16777619u;
+
+        return hash;
+    }
+};
+
+
+struct VertexEqual
+{
+    bool operator()(const Vertex& a, const Vertex& b) const
+    {
+        return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+    }
+};
+
+
+// A vertex is in the FIFO cache while fewer than CACHE_SIZE vertices were fetched after it,
+// moving the timestamp CACHE_SIZE ahead flushes the whole cache
+static GLuint fetchVertex(GLuint vertex, std::vector<GLuint>& cacheTime, GLuint& timestamp)
+{
+    if (timestamp - cacheTime[vertex] <= MeshOptimizer::CACHE_SIZE)
+        return 0;
+
+    cacheTime[vertex] = timestamp++;
+
+    return 1;
+}
+
+
+VertexCacheStats::VertexCacheStats()
+    : triangleCount(0), vertexCount(0), missCount(0)
+{
+}
+
+
+void VertexCacheStats::addStats(const VertexCacheStats& stats)
+{
+    this->triangleCount += stats.triangleCount;
+    this->vertexCount += stats.vertexCount;
+    this->missCount += stats.missCount;
+}
+
+
+GLfloat VertexCacheStats::getACMR() const
+{
+    return this->triangleCount > 0 ? (GLfloat)this->missCount / this->triangleCount : 0.0f;
+}
+
+
+GLfloat VertexCacheStats::getATVR() const
+{
+    return this->vertexCount > 0 ? (GLfloat)this->missCount / this->vertexCount : 0.0f;
+}
+
+
+void MeshOptimizer::optimizeMesh(CookedMesh& mesh, VertexCacheStats& statsBefore, VertexCacheStats& statsAfter)
+{
+    statsBefore = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+    weldVertices(mesh.vertices, mesh.indices);
+
+    // Points and lines left by the triangulation keep their order
+    if (!mesh.indices.empty() && mesh.indices.size() % 3 == 0)
+    {
+        std::vector<GLuint> clusters;
+        optimizeVertexCache(mesh.indices, mesh.vertices.size(), clusters);
+        optimizeOverdraw(mesh.vertices, mesh.indices, clusters, 1.05f);
+    }
+
+    optimizeVertexFetch(mesh.vertices, mesh.indices);
+
+    mesh.vertexCount = mesh.vertices.size();
+    mesh.indexCount = mesh.indices.size();
+    statsAfter = analyzeVertexCache(mesh.indices, mesh.vertexCount);
+}
+
+
+void MeshOptimizer::weldVertices(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+    // OBJ faces reference positions, normals and UVs separately, every corner comes out of the importer as its own vertex
+    std::unordered_map<Vertex, GLuint, VertexHash, VertexEqual> uniqueVertices;
+    std::vector<GLuint> remap(vertices.size());
+    std::vector<Vertex> welded;
+
+    uniqueVertices.reserve(vertices.size());
+    welded.reserve(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        std::pair<std::unordered_map<Vertex, GLuint, VertexHash, VertexEqual>::iterator, bool> inserted =
+            uniqueVertices.insert(std::make_pair(vertices[i], (GLuint)welded.size()));
+
+        if (inserted.second)
+            welded.push_back(vertices[i]);
+
+        remap[i] = inserted.first->second;
+    }
+
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = remap[indices[i]];
+
+    vertices.swap(welded);
+}
+
+
+void MeshOptimizer::optimizeVertexCache(std::vector<GLuint>& indices, GLuint vertexCount, std::vector<GLuint>& clusters)
+{
+    // Tipsify (Sander, Nehab, Barczak 2007): emit every remaining triangle around a fanning vertex,
+    // then move on to the neighbour that will still be in the cache once its own triangles are emitted
+    GLuint triangleCount = indices.size() / 3;
+
+    // Triangles around every vertex
+    std::vector<GLuint> adjacencyOffsets(vertexCount + 1, 0);
+    std::vector<GLuint> adjacency(triangleCount * 3);
+
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacencyOffsets[indices[i] + 1]++;
+
+    for (GLuint v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+    std::vector<GLuint> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[adjacencyFill[indices[i]]++] = i / 3;
+
+    std::vector<GLuint> liveTriangles(vertexCount);
+
+    for (GLuint v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+
+    std::vector<GLuint> cacheTime(vertexCount, 0);
+    std::vector<bool> triangleEmitted(triangleCount, false);
+    std::vector<GLuint> deadEnd, candidates, optimized;
+    GLuint timestamp = CACHE_SIZE + 1;
+    GLuint scanCursor = 0;
+    GLint fanningVertex = -1;
+
+    deadEnd.reserve(indices.size());
+    optimized.reserve(indices.size());
+    clusters.clear();
+
+    while (true)
+    {
+        // Dead end: fall back to the most recently fetched vertex with triangles left, then to the next one in
+        // index order. The cache is cold from here, so a new cluster starts for the overdraw pass
+        if (fanningVertex < 0)
+        {
+            while (!deadEnd.empty() && fanningVertex < 0)
+            {
+                GLuint vertex = deadEnd.back();
+                deadEnd.pop_back();
+
+                if (liveTriangles[vertex] > 0)
+                    fanningVertex = vertex;
+            }
+
+            while (fanningVertex < 0 && scanCursor < vertexCount)
+            {
+                if (liveTriangles[scanCursor] > 0)
+                    fanningVertex = scanCursor;
+
+                scanCursor++;
+            }
+
+            if (fanningVertex < 0)
+                break;
+
+            clusters.push_back(optimized.size() / 3);
+        }
+
+        candidates.clear();
+
+        for (GLuint a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a)
+        {
+            GLuint triangle = adjacency[a];
+
+            if (triangleEmitted[triangle])
+                continue;
+
+            for (GLuint corner = 0; corner < 3; ++corner)
+            {
+                GLuint vertex = indices[triangle * 3 + corner];
+
+                optimized.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                fetchVertex(vertex, cacheTime, timestamp);
+            }
+
+            triangleEmitted[triangle] = true;
+        }
+
+        // Prefer the oldest candidate that stays cached while its remaining triangles are emitted
+        GLint bestPriority = -1;
+        fanningVertex = -1;
+
+        for (size_t c = 0; c < candidates.size(); ++c)
+        {
+            GLuint vertex = candidates[c];
+
+            if (liveTriangles[vertex] == 0)
+                continue;
+
+            GLint priority = 0;
+
+            if (timestamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= CACHE_SIZE)
+                priority = timestamp - cacheTime[vertex];
+
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanningVertex = vertex;
+            }
+        }
+    }
+
+    indices.swap(optimized);
+}
+
+
+void MeshOptimizer::optimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const std::vector<GLuint>& clusters, GLfloat threshold)
+{
+    // Reordering whole clusters keeps the cache order inside them. Clusters are split further where the
+    // triangles so far already reach the cluster's ACMR within the threshold, then sorted so the ones
+    // facing away from the mesh centre, the likely occluders, draw first and early depth rejects the rest
+    GLuint triangleCount = indices.size() / 3;
+
+    if (clusters.empty() || triangleCount == 0)
+        return;
+
+    std::vector<GLuint> cacheTime(vertices.size(), 0);
+    std::vector<GLuint> softClusters;
+    GLuint timestamp = CACHE_SIZE + 1;
+
+    for (size_t h = 0; h < clusters.size(); ++h)
+    {
+        GLuint clusterStart = clusters[h];
+        GLuint clusterEnd = h + 1 < clusters.size() ? clusters[h + 1] : triangleCount;
+        GLuint clusterMisses = 0;
+
+        timestamp += CACHE_SIZE + 1;
+
+        for (GLuint t = clusterStart; t < clusterEnd; ++t)
+        {
+            for (GLuint corner = 0; corner < 3; ++corner)
+                clusterMisses += fetchVertex(indices[t * 3 + corner], cacheTime, timestamp);
+        }
+
+        GLfloat clusterThreshold = threshold * clusterMisses / (clusterEnd - clusterStart);
+        GLuint softStart = clusterStart, softMisses = 0;
+
+        timestamp += CACHE_SIZE + 1;
+        softClusters.push_back(clusterStart);
+
+        for (GLuint t = clusterStart; t < clusterEnd; ++t)
+        {
+            for (GLuint corner = 0; corner < 3; ++corner)
+                softMisses += fetchVertex(indices[t * 3 + corner], cacheTime, timestamp);
+
+            if (t + 1 < clusterEnd && softMisses <= (t - softStart + 1) * clusterThreshold)
+            {
+                softClusters.push_back(t + 1);
+                softStart = t + 1;
+                softMisses = 0;
+                timestamp += CACHE_SIZE + 1;
+            }
+        }
+    }
+
+    // Area weighted centroid and normal of every cluster, and of the whole mesh
+    std::vector<glm::vec3> clusterCentroids(softClusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(softClusters.size(), glm::vec3(0.0f));
+    std::vector<GLfloat> clusterAreas(softClusters.size(), 0.0f);
+    glm::vec3 meshCentroid(0.0f);
+    GLfloat meshArea = 0.0f;
+
+    for (size_t c = 0; c < softClusters.size(); ++c)
+    {
+        GLuint clusterEnd = c + 1 < softClusters.size() ? softClusters[c + 1] : triangleCount;
+
+        for (GLuint t = softClusters[c]; t < clusterEnd; ++t)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].Position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+            GLfloat faceArea = glm::length(faceNormal);
+
+            clusterCentroids[c] += (p0 + p1 + p2) * (faceArea / 3.0f);
+            clusterNormals[c] += faceNormal;
+            clusterAreas[c] += faceArea;
+        }
+
+        meshCentroid += clusterCentroids[c];
+        meshArea += clusterAreas[c];
+    }
+
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    std::vector<std::pair<GLfloat, GLuint> > clusterKeys(softClusters.size());
+
+    for (size_t c = 0; c < softClusters.size(); ++c)
+    {
+        GLfloat normalLength = glm::length(clusterNormals[c]);
+        GLfloat facing = 0.0f;
+
+        if (clusterAreas[c] > 0.0f && normalLength > 0.0f)
+            facing = glm::dot(clusterCentroids[c] / clusterAreas[c] - meshCentroid, clusterNormals[c] / normalLength);
+
+        clusterKeys[c] = std::make_pair(-facing, (GLuint)c);
+    }
+
+    // Ties keep the cache order
+    std::stable_sort(clusterKeys.begin(), clusterKeys.end());
+
+    std::vector<GLuint> sorted;
+    sorted.reserve(indices.size());
+
+    for (size_t k = 0; k < clusterKeys.size(); ++k)
+    {
+        GLuint c = clusterKeys[k].second;
+        GLuint clusterEnd = c + 1 < softClusters.size() ? softClusters[c + 1] : triangleCount;
+
+        sorted.insert(sorted.end(), indices.begin() + softClusters[c] * 3, indices.begin() + clusterEnd * 3);
+    }
+
+    indices.swap(sorted);
+}
+
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+    // Vertices are renumbered in the order the triangles first use them, unused ones are dropped
+    std::vector<GLuint> remap(vertices.size(), ~0u);
+    std::vector<Vertex> fetched;
+
+    fetched.reserve(vertices.size());
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        if (remap[indices[i]] == ~0u)
+        {
+            remap[indices[i]] = fetched.size();
+            fetched.push_back(vertices[indices[i]]);
+        }
+
+        indices[i] = remap[indices[i]];
+    }
+
+    vertices.swap(fetched);
+}
+
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<GLuint>& indices, GLuint vertexCount)
+{
+    VertexCacheStats stats;
+    std::vector<GLuint> cacheTime(vertexCount, 0);
+    std::vector<bool> vertexUsed(vertexCount, false);
+    GLuint timestamp = CACHE_SIZE + 1;
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        stats.missCount += fetchVertex(indices[i], cacheTime, timestamp);
+
+        if (!vertexUsed[indices[i]])
+        {
+            vertexUsed[indices[i]] = true;
+            stats.vertexCount++;
+        }
+    }
+
+    stats.triangleCount = indices.size() / 3;
+
+    return stats;
+}
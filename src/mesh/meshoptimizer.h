@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "mesh.h"
+#include "meshcache.h"
+
+
+// Post-transform cache behaviour of an index buffer, replayed through a FIFO cache
+struct VertexCacheStats
+{
+    GLuint64 triangleCount, vertexCount, missCount;
+
+    VertexCacheStats();
+    void addStats(const VertexCacheStats& stats);
+    GLfloat getACMR() const;        // Vertex shader runs per triangle, 0.5 at best on a regular grid, 3 without any reuse
+    GLfloat getATVR() const;        // Vertex shader runs per unique vertex, 1 at best
+};
+
+
+// Import-time geometry optimisation, run once before a model is cooked into its cache.
+// Identical vertices are welded, triangles are reordered for the post-transform vertex
+// cache (Tipsify) and then cluster by cluster so likely occluders draw first, and the
+// vertices are renumbered in the order the triangles first fetch them.
+class MeshOptimizer
+{
+    public:
+        static const GLuint CACHE_SIZE = 16;
+
+        static void optimizeMesh(CookedMesh& mesh, VertexCacheStats& statsBefore, VertexCacheStats& statsAfter);
+        static void weldVertices(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+        static void optimizeVertexCache(std::vector<GLuint>& indices, GLuint vertexCount, std::vector<GLuint>& clusters);
+        static void optimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const std::vector<GLuint>& clusters, GLfloat threshold);
+        static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+        static VertexCacheStats analyzeVertexCache(const std::vector<GLuint>& indices, GLuint vertexCount);
+};
@@ -0,0 +1,410 @@
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "meshsimplifier.h"
+#include "meshoptimizer.h"
+
+
+// Sum of squared distances to a set of planes, as the symmetric 4x4 matrix of Garland and Heckbert
+struct Quadric
+{
+    double a2, b2, c2, ab, ac, bc, ad, bd, cd, d2;
+
+    Quadric()
+        : a2(0.0), b2(0.0), c2(0.0), ab(0.0), ac(0.0), bc(0.0), ad(0.0), bd(0.0), cd(0.0), d2(0.0)
+    {
+    }
+
+    void addPlane(const glm::dvec3& normal, double distance)
+    {
+        this->a2 += normal.x * normal.x;
+        this->b2 += normal.y * normal.y;
+        this->c2 += normal.z * normal.z;
+        this->ab += normal.x * normal.y;
+        this->ac += normal.x * normal.z;
+        this->bc += normal.y * normal.z;
+        this->ad += normal.x * distance;
+        this->bd += normal.y * distance;
+        this->cd += normal.z * distance;
+        this->d2 += distance * distance;
+    }
+
+    void addQuadric(const Quadric& q)
+    {
+        this->a2 += q.a2; this->b2 += q.b2; this->c2 += q.c2;
+        this->ab += q.ab; this->ac += q.ac; this->bc += q.bc;
+        this->ad += q.ad; this->bd += q.bd; this->cd += q.cd;
+        this->d2 += q.d2;
+    }
+
+    double getError(const glm::vec3& p) const
+    {
+        double error = this->a2 * p.x * p.x + this->b2 * p.y * p.y + this->c2 * p.z * p.z +
+                       2.0 * (this->ab * p.x * p.y + this->ac * p.x * p.z + this->bc * p.y * p.z) +
+                       2.0 * (this->ad * p.x + this->bd * p.y + this->cd * p.z) + this->d2;
+
+        return std::max(error, 0.0);
+    }
+};
+
+
+struct PositionHash
+{
+    size_t operator()(const glm::vec3& position) const
+    {
+        GLuint bits[3];
+        std::memcpy(bits, &position[0], sizeof(bits));
+
+        return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    }
+};
+
+
+struct PositionEqual
+{
+    bool operator()(const glm::vec3& a, const glm::vec3& b) const
+    {
+        return std::memcmp(&a[0], &b[0], sizeof(glm::vec3)) == 0;
+    }
+};
+
+
+struct EdgeCollapse
+{
+    GLuint source, target;      // The source vertex moves onto the target
+    double collapseError;
+
+    bool operator<(const EdgeCollapse& other) const
+    {
+        return this->collapseError < other.collapseError;
+    }
+};
+
+
+void MeshSimplifier::generateLods(CookedMesh& mesh)
+{
+    // Every level halves the triangles of the previous one, until the locked vertices stop the simplification
+    std::vector<GLuint> baseIndices = mesh.indices;
+    std::vector<GLuint> lodIndices;
+    GLfloat lodError = 0.0f;
+
+    mesh.lods.clear();
+
+    MeshLod baseLod;
+    baseLod.indexOffset = 0;
+    baseLod.indexCount = baseIndices.size();
+    baseLod.lodError = 0.0f;
+    mesh.lods.push_back(baseLod);
+
+    if (baseIndices.size() % 3 != 0 || mesh.vertices.empty())
+        return;
+
+    // A level off by a quarter of the mesh size would only be selected once the whole mesh covers a pixel or so
+    glm::vec3 boundsMin = mesh.vertices[0].Position, boundsMax = boundsMin;
+
+    for (size_t v = 1; v < mesh.vertices.size(); ++v)
+    {
+        boundsMin = glm::min(boundsMin, mesh.vertices[v].Position);
+        boundsMax = glm::max(boundsMax, mesh.vertices[v].Position);
+    }
+
+    GLfloat maxLodError = glm::length(boundsMax - boundsMin) * 0.25f;
+    GLuint previousCount = baseIndices.size();
+
+    while (mesh.lods.size() < MAX_MESH_LODS && previousCount / 3 >= MIN_LOD_TRIANGLES * 2)
+    {
+        lodIndices = baseIndices;
+        GLfloat simplifyError = simplifyMesh(mesh.vertices, lodIndices, previousCount / 6 * 3);
+
+        // Barely simpler than the previous level, drawing it would save nothing
+        if (lodIndices.empty() || lodIndices.size() > previousCount * 3 / 4 || simplifyError > maxLodError)
+            break;
+
+        std::vector<GLuint> clusters;
+        MeshOptimizer::optimizeVertexCache(lodIndices, mesh.vertices.size(), clusters);
+
+        // Errors only grow along the chain, selection walks it from the finest level
+        lodError = std::max(lodError, simplifyError);
+
+        MeshLod lod;
+        lod.indexOffset = mesh.indices.size();
+        lod.indexCount = lodIndices.size();
+        lod.lodError = lodError;
+        mesh.lods.push_back(lod);
+
+        mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.end());
+        previousCount = lodIndices.size();
+    }
+
+    mesh.indexCount = mesh.indices.size();
+}
+
+
+GLfloat MeshSimplifier::simplifyMesh(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, GLuint targetIndexCount)
+{
+    GLuint vertexCount = vertices.size();
+
+    // Vertices split for their UVs or normals share a position, they mark seams and hard edges
+    std::unordered_map<glm::vec3, GLuint, PositionHash, PositionEqual> positionIDs;
+    std::vector<GLuint> positionOf(vertexCount), positionUses;
+
+    positionIDs.reserve(vertexCount);
+
+    for (GLuint v = 0; v < vertexCount; ++v)
+    {
+        std::pair<std::unordered_map<glm::vec3, GLuint, PositionHash, PositionEqual>::iterator, bool> inserted =
+            positionIDs.insert(std::make_pair(vertices[v].Position, (GLuint)positionUses.size()));
+
+        if (inserted.second)
+            positionUses.push_back(0);
+
+        positionOf[v] = inserted.first->second;
+        positionUses[positionOf[v]]++;
+    }
+
+    std::vector<bool> vertexLocked(vertexCount, false);
+
+    for (GLuint v = 0; v < vertexCount; ++v)
+        vertexLocked[v] = positionUses[positionOf[v]] > 1;
+
+    // Open borders: an edge between two positions used by a single triangle
+    std::unordered_map<GLuint64, GLuint> edgeUses;
+    edgeUses.reserve(indices.size());
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        for (GLuint e = 0; e < 3; ++e)
+        {
+            GLuint64 p0 = positionOf[indices[t + e]], p1 = positionOf[indices[t + (e + 1) % 3]];
+            edgeUses[p0 < p1 ? (p0 << 32 | p1) : (p1 << 32 | p0)]++;
+        }
+    }
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        for (GLuint e = 0; e < 3; ++e)
+        {
+            GLuint v0 = indices[t + e], v1 = indices[t + (e + 1) % 3];
+            GLuint64 p0 = positionOf[v0], p1 = positionOf[v1];
+
+            if (edgeUses[p0 < p1 ? (p0 << 32 | p1) : (p1 << 32 | p0)] == 1)
+                vertexLocked[v0] = vertexLocked[v1] = true;
+        }
+    }
+
+    // Plane of every triangle, accumulated on its corners
+    std::vector<Quadric> vertexQuadrics(vertexCount);
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        glm::dvec3 p0 = glm::dvec3(vertices[indices[t + 0]].Position);
+        glm::dvec3 p1 = glm::dvec3(vertices[indices[t + 1]].Position);
+        glm::dvec3 p2 = glm::dvec3(vertices[indices[t + 2]].Position);
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double normalLength = glm::length(normal);
+
+        if (normalLength <= 0.0)
+            continue;
+
+        normal /= normalLength;
+
+        Quadric plane;
+        plane.addPlane(normal, -glm::dot(normal, p0));
+
+        for (GLuint c = 0; c < 3; ++c)
+            vertexQuadrics[indices[t + c]].addQuadric(plane);
+    }
+
+    std::vector<GLuint> adjacencyOffsets, adjacency, remap(vertexCount);
+    std::vector<GLuint> sourceRing, targetRing, edgeOpposites, ringShared;
+    std::vector<bool> vertexTouched(vertexCount);
+    std::vector<EdgeCollapse> collapses;
+    double maxError = 0.0;
+
+    while (indices.size() > targetIndexCount)
+    {
+        GLuint triangleCount = indices.size() / 3;
+
+        // Triangles around every vertex, rebuilt after each pass of collapses
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        adjacency.resize(indices.size());
+
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacencyOffsets[indices[i] + 1]++;
+
+        for (GLuint v = 0; v < vertexCount; ++v)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+        std::vector<GLuint> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[adjacencyFill[indices[i]]++] = i / 3;
+
+        // Cheapest collapse of every free vertex onto one of its neighbours
+        collapses.clear();
+
+        for (GLuint v = 0; v < vertexCount; ++v)
+        {
+            if (vertexLocked[v] || adjacencyOffsets[v] == adjacencyOffsets[v + 1])
+                continue;
+
+            EdgeCollapse best;
+            best.source = v;
+            best.target = v;
+            best.collapseError = 0.0;
+
+            for (GLuint a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; ++a)
+            {
+                for (GLuint c = 0; c < 3; ++c)
+                {
+                    GLuint neighbour = indices[adjacency[a] * 3 + c];
+
+                    if (neighbour == v)
+                        continue;
+
+                    // The merged vertex carries the planes of both ends, so it is measured against all of them
+                    Quadric merged = vertexQuadrics[v];
+                    merged.addQuadric(vertexQuadrics[neighbour]);
+
+                    double error = merged.getError(vertices[neighbour].Position);
+
+                    if (best.target == v || error < best.collapseError)
+                    {
+                        best.target = neighbour;
+                        best.collapseError = error;
+                    }
+                }
+            }
+
+            if (best.target != v)
+                collapses.push_back(best);
+        }
+
+        std::sort(collapses.begin(), collapses.end());
+
+        // Collapses in one pass never share a triangle, so each one is checked against final positions
+        for (GLuint v = 0; v < vertexCount; ++v)
+            remap[v] = v;
+
+        vertexTouched.assign(vertexCount, false);
+
+        GLuint removedTriangles = 0, collapseCount = 0;
+        GLuint targetRemoved = triangleCount - targetIndexCount / 3;
+
+        for (size_t c = 0; c < collapses.size() && removedTriangles < targetRemoved; ++c)
+        {
+            const EdgeCollapse& collapse = collapses[c];
+
+            if (vertexTouched[collapse.source] || vertexTouched[collapse.target])
+                continue;
+
+            // Moving the source must not flip any triangle that survives the collapse, or squash it flat
+            const glm::vec3& target = vertices[collapse.target].Position;
+            bool collapseFlips = false;
+            GLuint sharedTriangles = 0;
+
+            sourceRing.clear();
+            targetRing.clear();
+            edgeOpposites.clear();
+
+            for (GLuint a = adjacencyOffsets[collapse.source]; a < adjacencyOffsets[collapse.source + 1] && !collapseFlips; ++a)
+            {
+                const GLuint* triangle = &indices[adjacency[a] * 3];
+
+                for (GLuint k = 0; k < 3; ++k)
+                {
+                    if (triangle[k] != collapse.source)
+                        sourceRing.push_back(triangle[k]);
+                }
+
+                if (triangle[0] == collapse.target || triangle[1] == collapse.target || triangle[2] == collapse.target)
+                {
+                    edgeOpposites.push_back(triangle[0] + triangle[1] + triangle[2] - collapse.source - collapse.target);
+                    sharedTriangles++;
+                    continue;
+                }
+
+                GLuint corner = triangle[0] == collapse.source ? 0 : triangle[1] == collapse.source ? 1 : 2;
+                const glm::vec3& p1 = vertices[triangle[(corner + 1) % 3]].Position;
+                const glm::vec3& p2 = vertices[triangle[(corner + 2) % 3]].Position;
+                const glm::vec3& p0 = vertices[collapse.source].Position;
+
+                glm::vec3 normalBefore = glm::cross(p1 - p0, p2 - p0);
+                glm::vec3 normalAfter = glm::cross(p1 - target, p2 - target);
+
+                if (glm::dot(normalBefore, normalAfter) <= 0.25f * glm::length(normalBefore) * glm::length(normalAfter))
+                    collapseFlips = true;
+            }
+
+            if (collapseFlips)
+                continue;
+
+            // Link condition: the only vertices both ends share are the ones opposite their edge, otherwise
+            // the collapse pinches the surface into duplicate triangles or a non-manifold edge
+            for (GLuint a = adjacencyOffsets[collapse.target]; a < adjacencyOffsets[collapse.target + 1]; ++a)
+            {
+                for (GLuint k = 0; k < 3; ++k)
+                {
+                    if (indices[adjacency[a] * 3 + k] != collapse.target)
+                        targetRing.push_back(indices[adjacency[a] * 3 + k]);
+                }
+            }
+
+            std::sort(sourceRing.begin(), sourceRing.end());
+            std::sort(targetRing.begin(), targetRing.end());
+            std::sort(edgeOpposites.begin(), edgeOpposites.end());
+            sourceRing.erase(std::unique(sourceRing.begin(), sourceRing.end()), sourceRing.end());
+            targetRing.erase(std::unique(targetRing.begin(), targetRing.end()), targetRing.end());
+            edgeOpposites.erase(std::unique(edgeOpposites.begin(), edgeOpposites.end()), edgeOpposites.end());
+
+            ringShared.clear();
+            std::set_intersection(sourceRing.begin(), sourceRing.end(), targetRing.begin(), targetRing.end(), std::back_inserter(ringShared));
+
+            if (ringShared != edgeOpposites || edgeOpposites.size() != sharedTriangles)
+                continue;
+
+            remap[collapse.source] = collapse.target;
+            vertexQuadrics[collapse.target].addQuadric(vertexQuadrics[collapse.source]);
+            maxError = std::max(maxError, collapse.collapseError);
+            removedTriangles += sharedTriangles;
+            collapseCount++;
+
+            // Every vertex around the source now sees a moved corner
+            for (GLuint a = adjacencyOffsets[collapse.source]; a < adjacencyOffsets[collapse.source + 1]; ++a)
+            {
+                for (GLuint k = 0; k < 3; ++k)
+                    vertexTouched[indices[adjacency[a] * 3 + k]] = true;
+            }
+        }
+
+        if (collapseCount == 0)
+            break;
+
+        // Triangles that lost an edge to a collapse are dropped
+        size_t kept = 0;
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            GLuint i0 = remap[indices[t]], i1 = remap[indices[t + 1]], i2 = remap[indices[t + 2]];
+
+            if (i0 == i1 || i1 == i2 || i0 == i2)
+                continue;
+
+            indices[kept++] = i0;
+            indices[kept++] = i1;
+            indices[kept++] = i2;
+        }
+
+        indices.resize(kept);
+    }
+
+    // Squared distances to the original planes, back to object space units
+    return (GLfloat)std::sqrt(maxError);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "mesh.h"
+#include "meshcache.h"
+
+
+// Import-time LOD chain generation. Every level is simplified from the full mesh by edge
+// collapses ordered by quadric error (Garland and Heckbert 1997), onto existing vertices
+// so the levels share the vertex buffer and only add indices. UV seams, hard edges and
+// open borders are locked, so the silhouette and the texture mapping stay in place.
+// Collapses that would flip or flatten a triangle, or break the link condition, are skipped.
+class MeshSimplifier
+{
+    public:
+        static const GLuint MIN_LOD_TRIANGLES = 32;
+
+        static void generateLods(CookedMesh& mesh);
+        static GLfloat simplifyMesh(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, GLuint targetIndexCount);
+};
@@ -6,6 +6,10 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -18,8 +22,20 @@
 
 #include "model.h"
 #include "mesh.h"
+#include "meshcache.h"
+#include "meshoptimizer.h"
+#include "meshsimplifier.h"
+#include "profiler.h"
+#include "startupreport.h"
+#include "resourceregistry.h"
+
+bool Model::lodEnabled = true;
+bool Model::lodCrossFade = true;
+GLfloat Model::lodErrorPixels = 1.0f;
+
 
 Model::Model()
+    : boundsMin(0.0f), boundsMax(0.0f)
 {
 }
 
@@ -27,25 +43,244 @@ Model::~Model()
 {
 }
 
-// Function to load a model from a file using Assimp
+// Function to load a model from its cooked .lmesh, or from the source file using Assimp
 void Model::loadModel(std::string path)
+{
+    ProfilerZone modelZone("loadModel " + path);
+    ResourceOwner modelOwner(path);
+
+    // Edited sources are imported again, a cache without its source is still used
+    std::string cachePath = MeshCache::getCachePath(path);
+    GLuint64 sourceHash = 0;
+    bool sourceFound;
+    bool cacheLoaded;
+    CookedModel cooked;
+
+    {
+        StartupPhase mapPhase("Model Map", cachePath);
+        sourceFound = MeshCache::hashFile(path, sourceHash);
+        cacheLoaded = MeshCache::loadCache(cachePath, sourceFound, sourceHash, cooked);
+    }
+
+    if (!cacheLoaded)
+    {
+        if (!this->importModel(path, cooked))
+            return;
+
+        this->optimizeModel(path, cooked);
+        this->simplifyModel(path, cooked);
+        MeshCache::computeBounds(cooked);
+
+        for (size_t i = 0; i < cooked.meshes.size(); i++)
+            MeshCache::packMesh(cooked.meshes[i]);
+
+        if (MeshCache::saveCache(cachePath, sourceHash, cooked))
+            std::cout << "MODELS - COOKED : " << path << " -> " << cachePath << std::endl;
+        else
+            std::cout << "MODELS - FAILED WRITING CACHE : " << cachePath << std::endl;
+    }
+
+    // Set directory path for textures or other related assets
+    this->directory = path.substr(0, path.find_last_of('/'));
+    this->boundsMin = cooked.boundsMin;
+    this->boundsMax = cooked.boundsMax;
+
+    // Vertex/index buffer uploads of every mesh, straight from the mapped cache when there is one
+    StartupPhase uploadPhase("Model Upload", path);
+
+    for (size_t i = 0; i < cooked.meshes.size(); i++)
+    {
+        const CookedMesh& mesh = cooked.meshes[i];
+
+        if (mesh.vertexCount > 0 && mesh.indexCount > 0)
+        {
+            this->meshes.push_back(Mesh(mesh.getVertices(), mesh.vertexCount, mesh.getIndices(), mesh.indexCount, mesh.indexType, mesh.quantization));
+            this->meshes.back().lods = mesh.lods;
+        }
+    }
+}
+
+bool Model::isModelOption(const std::string& arg)
+{
+    return arg == "--mesh-lod" || arg == "--lod-error" || arg == "--lod-fade";
+}
+
+bool Model::setModelOptions(int argc, char* argv[])
+{
+    // Only mesh LOD options are read here, the benchmark parser handles the rest
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc) && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+
+        if ((arg == "--mesh-lod" || arg == "--lod-fade") && hasValue)
+        {
+            std::string mode = argv[++i];
+
+            if (mode != "on" && mode != "off")
+            {
+                std::cerr << "MODELS - INVALID LOD MODE : " << mode << std::endl;
+                return false;
+            }
+
+            (arg == "--mesh-lod" ? lodEnabled : lodCrossFade) = mode == "on";
+        }
+        else if (arg == "--lod-error" && hasValue)
+        {
+            lodErrorPixels = (GLfloat)std::atof(argv[++i]);
+
+            if (lodErrorPixels <= 0.0f)
+            {
+                std::cerr << "MODELS - INVALID LOD ERROR : " << argv[i] << " PIXELS" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Function to pick the level of detail of every mesh from its projected simplification error
+void Model::selectLods(const glm::mat4& modelMatrix, const glm::vec3& cameraPosition, GLfloat cameraFOV, GLuint viewportHeight)
+{
+    // Object space errors grow with the largest scale of the model matrix
+    GLfloat modelScale = std::max(glm::length(glm::vec3(modelMatrix[0])), std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+    GLfloat pixelsPerUnitAtOne = viewportHeight / (2.0f * std::tan(cameraFOV * 0.5f));
+
+    for (GLuint i = 0; i < this->meshes.size(); i++)
+    {
+        Mesh& mesh = this->meshes[i];
+
+        if (!lodEnabled)
+        {
+            mesh.resetLod();
+            continue;
+        }
+
+        // Nearest point of the bounding sphere, a camera inside it sees the full mesh
+        const VertexQuantization& quantization = mesh.quantization;
+        glm::vec3 boundsExtent = quantization.positionScale * 65535.0f;
+        glm::vec3 boundsCenter = glm::vec3(modelMatrix * glm::vec4(quantization.positionOffset + boundsExtent * 0.5f, 1.0f));
+        GLfloat boundsRadius = glm::length(boundsExtent) * 0.5f * modelScale;
+        GLfloat distance = glm::length(cameraPosition - boundsCenter) - boundsRadius;
+
+        if (distance <= 0.0f)
+        {
+            mesh.resetLod();
+            continue;
+        }
+
+        mesh.selectLod(pixelsPerUnitAtOne * modelScale / distance, lodErrorPixels, lodCrossFade);
+    }
+}
+
+// Function to import a model file with Assimp and gather the geometry of its meshes
+bool Model::importModel(const std::string& path, CookedModel& cooked)
 {
     // Import model file with specific processing options
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+    StartupReport::beginPhase("Model Import", path, false);
+    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    StartupReport::endPhase();
 
     // Error checking if the model fails to load
     if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
         std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
-        return;
+        return false;
     }
 
-    // Set directory path for textures or other related assets
-    this->directory = path.substr(0, path.find_last_of('/'));
+    // Process the root node recursively to gather the vertices and indices of every mesh
+    StartupPhase processPhase("Model Process", path);
+    Profiler::beginZone("processNode", false);
+    this->processNode(scene->mRootNode, scene, cooked);
+    Profiler::endZone();
+
+    return true;
+}
+
+// Function to weld and reorder the imported meshes before they are cooked, the cache keeps the result
+void Model::optimizeModel(const std::string& path, CookedModel& cooked)
+{
+    StartupPhase optimizePhase("Model Optimize", path);
+    VertexCacheStats statsBefore, statsAfter;
+    GLuint64 vertexCountBefore = 0, vertexCountAfter = 0;
+
+    for (size_t i = 0; i < cooked.meshes.size(); i++)
+    {
+        VertexCacheStats meshBefore, meshAfter;
+        vertexCountBefore += cooked.meshes[i].vertexCount;
+
+        MeshOptimizer::optimizeMesh(cooked.meshes[i], meshBefore, meshAfter);
+
+        vertexCountAfter += cooked.meshes[i].vertexCount;
+        statsBefore.addStats(meshBefore);
+        statsAfter.addStats(meshAfter);
+    }
 
-    // Process the root node recursively to build meshes
-    this->processNode(scene->mRootNode, scene);
+    char message[160];
+    std::snprintf(message, sizeof(message), "VERTICES %llu -> %llu  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f", (unsigned long long)vertexCountBefore,
+                  (unsigned long long)vertexCountAfter, statsBefore.getACMR(), statsAfter.getACMR(), statsBefore.getATVR(), statsAfter.getATVR());
+    std::cout << "MODELS - OPTIMIZED : " << path << "  " << message << std::endl;
+}
+
+// Function to build the LOD chain of every mesh, stored in the cache with the full meshes
+void Model::simplifyModel(const std::string& path, CookedModel& cooked)
+{
+    StartupPhase simplifyPhase("Model LOD", path);
+    std::vector<GLuint> lodTriangles;
+    std::vector<GLfloat> lodErrors;
+
+    for (size_t i = 0; i < cooked.meshes.size(); i++)
+    {
+        MeshSimplifier::generateLods(cooked.meshes[i]);
+
+        const std::vector<MeshLod>& lods = cooked.meshes[i].lods;
+
+        for (size_t level = 0; level < lods.size(); level++)
+        {
+            if (level >= lodTriangles.size())
+            {
+                lodTriangles.push_back(0);
+                lodErrors.push_back(0.0f);
+            }
+
+            lodTriangles[level] += lods[level].indexCount / 3;
+            lodErrors[level] = std::max(lodErrors[level], lods[level].lodError);
+        }
+    }
+
+    // Triangles and object space error of every level
+    std::string lodMessage;
+
+    for (size_t level = 0; level < lodTriangles.size(); level++)
+    {
+        char message[64];
+        std::snprintf(message, sizeof(message), "%s%u (%.4f)", level > 0 ? " / " : "", lodTriangles[level], lodErrors[level]);
+        lodMessage += message;
+    }
+
+    std::cout << "MODELS - LODS : " << path << "  TRIANGLES " << lodMessage << std::endl;
+}
+
+GLuint Model::getDrawnTriangles() const
+{
+    GLuint drawnTriangles = 0;
+
+    for (GLuint i = 0; i < this->meshes.size(); i++)
+        drawnTriangles += this->meshes[i].getDrawnTriangles();
+
+    return drawnTriangles;
+}
+
+GLuint Model::getFullTriangles() const
+{
+    GLuint fullTriangles = 0;
+
+    for (GLuint i = 0; i < this->meshes.size(); i++)
+        fullTriangles += this->meshes[i].lods[0].indexCount / 3;
+
+    return fullTriangles;
 }
 
 // Function to draw all meshes in the model
@@ -55,28 +290,38 @@ void Model::Draw()
         this->meshes[i].Draw();  // Render each mesh
 }
 
+// Function to free the GL buffers of every mesh
+void Model::releaseModel()
+{
+    for (GLuint i = 0; i < this->meshes.size(); i++)
+        this->meshes[i].releaseMesh();
+
+    this->meshes.clear();
+}
+
 // Recursive function to process nodes in the model's scene graph
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::processNode(aiNode* node, const aiScene* scene, CookedModel& cooked)
 {
     // Process each mesh in the current node
     for (GLuint i = 0; i < node->mNumMeshes; i++)
     {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        this->meshes.push_back(this->processMesh(mesh, scene));
+        cooked.meshes.push_back(CookedMesh());
+        this->processMesh(mesh, cooked.meshes.back());
     }
 
     // Recursively process each child node
     for (GLuint i = 0; i < node->mNumChildren; i++)
     {
-        this->processNode(node->mChildren[i], scene);
+        this->processNode(node->mChildren[i], scene, cooked);
     }
 }
 
-// Function to process and convert Assimp's aiMesh into a Mesh object
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+// Function to convert Assimp's aiMesh into interleaved vertices and indices
+void Model::processMesh(aiMesh* mesh, CookedMesh& cooked)
 {
-    std::vector<Vertex> vertices;  // List of vertices for the mesh
-    std::vector<GLuint> indices;   // List of indices for the mesh
+    std::vector<Vertex>& vertices = cooked.vertices;  // List of vertices for the mesh
+    std::vector<GLuint>& indices = cooked.indices;    // List of indices for the mesh
 
     // Process vertices
     for (GLuint i = 0; i < mesh->mNumVertices; i++)
@@ -109,6 +354,28 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
             vertex.TexCoords = glm::vec2(0.0f, 0.0f);  // Default texture coordinates if none are provided
         }
 
+        // Tangent (generated by Assimp along the UVs), made orthogonal to the normal, the bitangent only keeps its side
+        glm::vec3 tangent(0.0f);
+        GLfloat handedness = 1.0f;
+
+        if (mesh->mTangents)
+        {
+            glm::vec3 bitangent(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+
+            tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            tangent -= vertex.Normal * glm::dot(vertex.Normal, tangent);
+            handedness = glm::dot(glm::cross(vertex.Normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+        }
+
+        // Degenerate UVs or none at all, any direction orthogonal to the normal will do
+        if (glm::dot(tangent, tangent) < 1e-12f)
+            tangent = glm::cross(vertex.Normal, std::fabs(vertex.Normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+
+        if (glm::dot(tangent, tangent) > 0.0f)
+            tangent = glm::normalize(tangent);
+
+        vertex.Tangent = glm::vec4(tangent, handedness);
+
         vertices.push_back(vertex);  // Add vertex to the list
     }
 
@@ -122,5 +389,6 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
             indices.push_back(face.mIndices[j]);
     }
 
-    return Mesh(vertices, indices);
+    cooked.vertexCount = vertices.size();
+    cooked.indexCount = indices.size();
 }
@@ -16,20 +16,36 @@
 #include <assimp/postprocess.h>
 
 #include "mesh.h"
+#include "meshcache.h"
 
 
 class Model 
 {
     public:
+        glm::vec3 boundsMin, boundsMax;     // Object space, over every mesh
+
         Model();
         ~Model();
         void loadModel(std::string path);
+        void selectLods(const glm::mat4& modelMatrix, const glm::vec3& cameraPosition, GLfloat cameraFOV, GLuint viewportHeight);
         void Draw();
+        void releaseModel();
+        GLuint getDrawnTriangles() const;
+        GLuint getFullTriangles() const;
+
+        static bool isModelOption(const std::string& arg);
+        static bool setModelOptions(int argc, char* argv[]);
+        static bool lodEnabled;
+        static bool lodCrossFade;
+        static GLfloat lodErrorPixels;      // Largest simplification error allowed on screen
 
     private:
         std::vector<Mesh> meshes;
         std::string directory;
 
-        void processNode(aiNode* node, const aiScene* scene);
-        Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+        bool importModel(const std::string& path, CookedModel& cooked);
+        void optimizeModel(const std::string& path, CookedModel& cooked);
+        void simplifyModel(const std::string& path, CookedModel& cooked);
+        void processNode(aiNode* node, const aiScene* scene, CookedModel& cooked);
+        void processMesh(aiMesh* mesh, CookedMesh& cooked);
 };
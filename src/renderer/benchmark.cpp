@@ -0,0 +1,599 @@
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "benchmark.h"
+#include "profiler.h"
+#include "goldentest.h"
+#include "glstats.h"
+#include "startupreport.h"
+#include "resourceregistry.h"
+#include "framestats.h"
+#include "shader.h"
+#include "texturemanager.h"
+#include "model.h"
+
+
+const char* defaultBenchmarkScript = "resources/bench/default.bench";
+
+
+// "Lighting" -> "lighting", "ImGui Setup" -> "imgui_setup"
+static std::string getColumnName(const std::string& zoneName)
+{
+    std::string columnName;
+
+    for (size_t i = 0; i < zoneName.size(); ++i)
+    {
+        char c = zoneName[i];
+
+        if (std::isalnum((unsigned char)c))
+            columnName += std::tolower((unsigned char)c);
+        else if (!columnName.empty() && columnName[columnName.size() - 1] != '_')
+            columnName += '_';
+    }
+
+    return columnName;
+}
+
+
+Benchmark::Benchmark()
+{
+    this->benchActive = false;
+    this->benchGLStats = false;
+    this->benchWidth = 1280;
+    this->benchHeight = 720;
+    this->benchFrames = 0;
+    this->benchWarmup = 10;
+    this->benchTimeStep = 1.0f / 60.0f;
+    this->benchCSVPath = "benchmark.csv";
+}
+
+
+Benchmark::~Benchmark()
+{
+
+}
+
+
+bool Benchmark::setBenchmark(int argc, char* argv[])
+{
+    GLuint frameOverride = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc) && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+
+        if (arg == "--bench")
+        {
+            this->benchActive = true;
+            this->benchScriptPath = hasValue ? argv[++i] : defaultBenchmarkScript;
+        }
+        else if (arg == "--width" && hasValue)
+            this->benchWidth = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue)
+            this->benchHeight = std::atoi(argv[++i]);
+        else if (arg == "--frames" && hasValue)
+            frameOverride = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && hasValue)
+            this->benchWarmup = std::atoi(argv[++i]);
+        else if (arg == "--timestep" && hasValue)
+            this->benchTimeStep = std::atof(argv[++i]);
+        else if (arg == "--csv" && hasValue)
+            this->benchCSVPath = argv[++i];
+        else if (arg == "--glstats")
+            this->benchGLStats = true;
+        else if (GoldenTest::isGoldenOption(arg))
+        {
+            // Read by the golden-image harness, which shares the resolution options
+            if (hasValue)
+                ++i;
+        }
+        else if (StartupReport::isStartupOption(arg))
+        {
+            // Read by the startup report
+            if (hasValue)
+                ++i;
+        }
+        else if (FrameStats::isFrameStatsOption(arg))
+        {
+            // Read by the frame statistics
+            if (hasValue)
+                ++i;
+        }
+        else if (Shader::isShaderOption(arg))
+        {
+            // Read by the shader binary cache
+            if (hasValue)
+                ++i;
+        }
+        else if (TextureManager::isTextureOption(arg))
+        {
+            // Read by the texture cache, the converter switch takes no value
+            if (hasValue && arg != "--convert-textures")
+                ++i;
+        }
+        else if (Model::isModelOption(arg))
+        {
+            // Read by the mesh LOD selection
+            if (hasValue)
+                ++i;
+        }
+        else
+        {
+            std::cerr << "Unknown argument : " << arg << "\n"
+                      << "Usage : LuminariaEngine [--bench [script]] [--width W] [--height H] [--frames N]\n"
+                      << "                        [--warmup N] [--timestep seconds] [--csv path] [--glstats]\n"
+                      << "                        [--golden [update]] [--golden-dir path] [--golden-output path]\n"
+                      << "                        [--psnr dB] [--budget-scale factor] [--filter case]\n"
+                      << "                        [--startup-budget ms] [--startup-report path]\n"
+                      << "                        [--hitch-ms ms] [--stats-window frames]\n"
+                      << "                        [--shader-cache dir|off] [--texture-budget MB]\n"
+                      << "                        [--texture-compression on|off] [--texture-threads N]\n"
+                      << "                        [--hdr-format compact|float] [--convert-textures]\n"
+                      << "                        [--mesh-lod on|off] [--lod-error pixels] [--lod-fade on|off]" << std::endl;
+            return false;
+        }
+    }
+
+    if (!this->benchActive)
+        return true;
+
+    if (this->benchWidth == 0 || this->benchHeight == 0)
+    {
+        std::cerr << "BENCHMARK - INVALID RESOLUTION : " << this->benchWidth << "x" << this->benchHeight << std::endl;
+        return false;
+    }
+
+    if (!this->loadScript(this->benchScriptPath))
+        return false;
+
+    if (frameOverride > 0)
+        this->benchFrames = frameOverride;
+
+    return true;
+}
+
+
+bool Benchmark::loadScript(const std::string& scriptPath)
+{
+    std::ifstream scriptFile(scriptPath.c_str());
+
+    if (!scriptFile.is_open())
+    {
+        std::cerr << "BENCHMARK - FAILED LOADING SCRIPT : " << scriptPath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    GLuint lineNumber = 0;
+    GLuint lastFrame = 0;
+
+    while (std::getline(scriptFile, line))
+    {
+        lineNumber++;
+
+        // Strip comments
+        size_t commentStart = line.find('#');
+        if (commentStart != std::string::npos)
+            line = line.substr(0, commentStart);
+
+        std::istringstream lineStream(line);
+        BenchmarkEvent event;
+
+        if (!(lineStream >> event.eventFrame >> event.eventCommand))
+            continue;
+
+        std::string arg;
+        while (lineStream >> arg)
+            event.eventArgs.push_back(arg);
+
+        lastFrame = std::max(lastFrame, event.eventFrame);
+
+        if (event.eventCommand == "camera")
+        {
+            if (event.eventArgs.size() != 5)
+            {
+                std::cerr << "BENCHMARK - " << scriptPath << ":" << lineNumber << " : camera expects x y z yaw pitch" << std::endl;
+                return false;
+            }
+
+            BenchmarkCameraKey cameraKey;
+            cameraKey.keyFrame = event.eventFrame;
+            cameraKey.keyPosition = glm::vec3(std::atof(event.eventArgs[0].c_str()), std::atof(event.eventArgs[1].c_str()), std::atof(event.eventArgs[2].c_str()));
+            cameraKey.keyYaw = std::atof(event.eventArgs[3].c_str());
+            cameraKey.keyPitch = std::atof(event.eventArgs[4].c_str());
+
+            this->benchCameraKeys.push_back(cameraKey);
+        }
+        else if (event.eventCommand == "end")
+        {
+            // Explicit end of the run, the frame itself is not rendered
+            this->benchFrames = event.eventFrame;
+        }
+        else
+        {
+            this->benchEvents.push_back(event);
+        }
+    }
+
+    if (this->benchFrames == 0)
+        this->benchFrames = lastFrame + 1;
+
+    return true;
+}
+
+
+bool Benchmark::isActive()
+{
+    return this->benchActive;
+}
+
+
+bool Benchmark::isGLStatsEnabled()
+{
+    return this->benchGLStats;
+}
+
+
+GLuint Benchmark::getWidth()
+{
+    return this->benchWidth;
+}
+
+
+GLuint Benchmark::getHeight()
+{
+    return this->benchHeight;
+}
+
+
+GLuint Benchmark::getFrameCount()
+{
+    return this->benchFrames;
+}
+
+
+GLfloat Benchmark::getTimeStep()
+{
+    return this->benchTimeStep;
+}
+
+
+std::vector<BenchmarkEvent> Benchmark::getFrameEvents(GLuint frame)
+{
+    std::vector<BenchmarkEvent> frameEvents;
+
+    for (GLuint i = 0; i < this->benchEvents.size(); ++i)
+    {
+        if (this->benchEvents[i].eventFrame == frame)
+            frameEvents.push_back(this->benchEvents[i]);
+    }
+
+    return frameEvents;
+}
+
+
+bool Benchmark::getFrameCamera(GLuint frame, glm::vec3& position, GLfloat& yaw, GLfloat& pitch)
+{
+    if (this->benchCameraKeys.empty())
+        return false;
+
+    // Hold the first and last keys outside of the scripted range
+    const BenchmarkCameraKey* keyA = &this->benchCameraKeys.front();
+    const BenchmarkCameraKey* keyB = keyA;
+
+    for (GLuint i = 0; i < this->benchCameraKeys.size(); ++i)
+    {
+        if (this->benchCameraKeys[i].keyFrame <= frame)
+            keyA = &this->benchCameraKeys[i];
+
+        keyB = &this->benchCameraKeys[i];
+
+        if (this->benchCameraKeys[i].keyFrame > frame)
+            break;
+    }
+
+    GLfloat blend = 0.0f;
+    if (keyB->keyFrame > keyA->keyFrame && frame > keyA->keyFrame)
+        blend = std::min(1.0f, GLfloat(frame - keyA->keyFrame) / GLfloat(keyB->keyFrame - keyA->keyFrame));
+
+    position = glm::mix(keyA->keyPosition, keyB->keyPosition, blend);
+    yaw = glm::mix(keyA->keyYaw, keyB->keyYaw, blend);
+    pitch = glm::mix(keyA->keyPitch, keyB->keyPitch, blend);
+
+    return true;
+}
+
+
+void Benchmark::recordFrame(GLuint frame, double frameInterval)
+{
+    if (frame >= this->benchFrameTimes.size())
+        this->benchFrameTimes.resize(frame + 1);
+
+    BenchmarkFrame& frameTimes = this->benchFrameTimes[frame];
+    frameTimes.frameInterval = frameInterval;
+
+    // Only the frame itself and its passes are tabulated, deeper zones stay in the trace
+    const std::vector<ProfilerZoneRecord>& frameZones = Profiler::getFrameZones();
+
+    for (GLuint i = 0; i < frameZones.size(); ++i)
+    {
+        if (frameZones[i].zoneDepth > 1)
+            continue;
+
+        this->addZoneName(frameZones[i].zoneName);
+        frameTimes.cpuTimes[frameZones[i].zoneName] += (frameZones[i].cpuStop - frameZones[i].cpuStart) / 1000.0;
+    }
+
+    // Video memory of each resource category, then the totals including the host copies
+    for (GLuint i = 0; i < RESOURCE_TYPE_COUNT; ++i)
+    {
+        ResourceType type = (ResourceType)i;
+
+        if (type == RESOURCE_FRAMEBUFFER)
+            continue;
+
+        std::string memoryName = getColumnName(ResourceRegistry::getTypeName(type)) + "_vram_mb";
+
+        this->addMemoryName(memoryName);
+        frameTimes.memorySizes[memoryName] = ResourceRegistry::getTotals(type).deviceBytes / (1024.0 * 1024.0);
+    }
+
+    ResourceTotals memoryTotals = ResourceRegistry::getTotals();
+
+    this->addMemoryName("total_vram_mb");
+    this->addMemoryName("total_host_mb");
+    frameTimes.memorySizes["total_vram_mb"] = memoryTotals.deviceBytes / (1024.0 * 1024.0);
+    frameTimes.memorySizes["total_host_mb"] = memoryTotals.hostBytes / (1024.0 * 1024.0);
+
+    if (!GLStats::isEnabled())
+        return;
+
+    // GL call counters of every pass, then the whole frame
+    std::vector<std::string> counterNames = GLStats::getCounterNames();
+    const std::vector<GLStatsPass>& framePasses = GLStats::getFramePasses();
+
+    for (GLuint i = 0; i <= framePasses.size(); ++i)
+    {
+        bool frameTotal = i == framePasses.size();
+        std::vector<GLuint> counterValues = GLStats::getCounterValues(frameTotal ? GLStats::getFrameTotals() : framePasses[i].passCounters);
+        std::string columnPrefix = frameTotal ? "total" : getColumnName(framePasses[i].passName);
+
+        for (GLuint j = 0; j < counterNames.size(); ++j)
+        {
+            std::string counterName = columnPrefix + "_" + counterNames[j];
+
+            this->addCounterName(counterName);
+            frameTimes.glCounts[counterName] = counterValues[j];
+        }
+    }
+}
+
+
+void Benchmark::recordGPU(GLuint64 firstProfilerFrame)
+{
+    // GPU results are tagged with the frame that issued them, file every one under that frame
+    ProfilerGPUSample sample;
+
+    while (Profiler::popGPUSample(sample))
+    {
+        if (sample.frameIndex < firstProfilerFrame)
+            continue;
+
+        GLuint64 frame = sample.frameIndex - firstProfilerFrame;
+
+        if (frame < this->benchFrameTimes.size() && std::find(this->benchZoneNames.begin(), this->benchZoneNames.end(), sample.zoneName) != this->benchZoneNames.end())
+            this->benchFrameTimes[frame].gpuTimes[sample.zoneName] = sample.gpuTime;
+    }
+}
+
+
+void Benchmark::addZoneName(const std::string& zoneName)
+{
+    if (std::find(this->benchZoneNames.begin(), this->benchZoneNames.end(), zoneName) == this->benchZoneNames.end())
+        this->benchZoneNames.push_back(zoneName);
+}
+
+
+void Benchmark::addCounterName(const std::string& counterName)
+{
+    if (std::find(this->benchCounterNames.begin(), this->benchCounterNames.end(), counterName) == this->benchCounterNames.end())
+        this->benchCounterNames.push_back(counterName);
+}
+
+
+void Benchmark::recordMemory(GLuint frame, const std::string& memoryName, GLfloat size)
+{
+    if (frame >= this->benchFrameTimes.size())
+        return;
+
+    this->addMemoryName(memoryName);
+    this->benchFrameTimes[frame].memorySizes[memoryName] = size;
+}
+
+
+void Benchmark::addMemoryName(const std::string& memoryName)
+{
+    if (std::find(this->benchMemoryNames.begin(), this->benchMemoryNames.end(), memoryName) == this->benchMemoryNames.end())
+        this->benchMemoryNames.push_back(memoryName);
+}
+
+
+// Nearest-rank percentile of an already sorted sample list
+static double computePercentile(const std::vector<double>& sortedSamples, double percentile)
+{
+    if (sortedSamples.empty())
+        return 0.0;
+
+    size_t rank = (size_t)std::ceil(percentile / 100.0 * sortedSamples.size());
+    rank = std::max<size_t>(rank, 1);
+
+    return sortedSamples[std::min(rank, sortedSamples.size()) - 1];
+}
+
+
+bool Benchmark::writeCSV()
+{
+    std::ofstream csvFile(this->benchCSVPath.c_str());
+
+    if (!csvFile.is_open())
+    {
+        std::cerr << "BENCHMARK - FAILED WRITING CSV : " << this->benchCSVPath << std::endl;
+        return false;
+    }
+
+    // Gather one sample list per column, the first one being the frame interval
+    std::vector<std::string> columnNames;
+    std::vector<std::vector<double> > columnSamples;
+
+    columnNames.push_back("frame_interval_ms");
+
+    for (GLuint i = 0; i < this->benchZoneNames.size(); ++i)
+    {
+        columnNames.push_back(getColumnName(this->benchZoneNames[i]) + "_cpu_ms");
+
+        if (Profiler::isZoneGPUResolved(this->benchZoneNames[i]))
+            columnNames.push_back(getColumnName(this->benchZoneNames[i]) + "_gpu_ms");
+    }
+
+    GLuint firstCounterColumn = columnNames.size();
+
+    for (GLuint i = 0; i < this->benchCounterNames.size(); ++i)
+        columnNames.push_back(this->benchCounterNames[i]);
+
+    GLuint firstMemoryColumn = columnNames.size();
+
+    for (GLuint i = 0; i < this->benchMemoryNames.size(); ++i)
+        columnNames.push_back(this->benchMemoryNames[i]);
+
+    columnSamples.resize(columnNames.size());
+
+    // Per-frame table
+    csvFile << "frame";
+    for (GLuint i = 0; i < columnNames.size(); ++i)
+        csvFile << "," << columnNames[i];
+    csvFile << "\n";
+
+    csvFile.setf(std::ios::fixed);
+    csvFile.precision(4);
+
+    for (GLuint frame = 0; frame < this->benchFrameTimes.size(); ++frame)
+    {
+        BenchmarkFrame& frameTimes = this->benchFrameTimes[frame];
+        bool measured = frame >= this->benchWarmup;
+        GLuint column = 0;
+
+        csvFile << frame << "," << frameTimes.frameInterval;
+        if (measured)
+            columnSamples[column].push_back(frameTimes.frameInterval);
+        column++;
+
+        for (GLuint i = 0; i < this->benchZoneNames.size(); ++i)
+        {
+            const std::string& zoneName = this->benchZoneNames[i];
+
+            csvFile << "," << frameTimes.cpuTimes[zoneName];
+            if (measured)
+                columnSamples[column].push_back(frameTimes.cpuTimes[zoneName]);
+            column++;
+
+            if (!Profiler::isZoneGPUResolved(zoneName))
+                continue;
+
+            // GPU results of dropped timer frames are left empty rather than reported as zero
+            if (frameTimes.gpuTimes.count(zoneName))
+            {
+                csvFile << "," << frameTimes.gpuTimes[zoneName];
+                if (measured)
+                    columnSamples[column].push_back(frameTimes.gpuTimes[zoneName]);
+            }
+            else
+                csvFile << ",";
+            column++;
+        }
+
+        for (GLuint i = 0; i < this->benchCounterNames.size(); ++i)
+        {
+            GLuint count = frameTimes.glCounts[this->benchCounterNames[i]];
+
+            csvFile << "," << count;
+            if (measured)
+                columnSamples[column].push_back(count);
+            column++;
+        }
+
+        for (GLuint i = 0; i < this->benchMemoryNames.size(); ++i)
+        {
+            GLfloat size = frameTimes.memorySizes[this->benchMemoryNames[i]];
+
+            csvFile << "," << size;
+            if (measured)
+                columnSamples[column].push_back(size);
+            column++;
+        }
+
+        csvFile << "\n";
+    }
+
+    // Summary table with percentiles, warmup frames excluded
+    std::string summaryPath = this->benchCSVPath;
+    size_t extension = summaryPath.rfind(".csv");
+    summaryPath = (extension != std::string::npos ? summaryPath.substr(0, extension) : summaryPath) + "_summary.csv";
+
+    std::ofstream summaryFile(summaryPath.c_str());
+
+    if (!summaryFile.is_open())
+    {
+        std::cerr << "BENCHMARK - FAILED WRITING CSV : " << summaryPath << std::endl;
+        return false;
+    }
+
+    summaryFile.setf(std::ios::fixed);
+    summaryFile.precision(4);
+    summaryFile << "metric,samples,mean,p50,p95,p99,max\n";
+
+    std::cout << "BENCHMARK - " << this->benchFrameTimes.size() << " frames at " << this->benchWidth << "x" << this->benchHeight
+              << " (" << this->benchWarmup << " warmup)" << std::endl;
+
+    for (GLuint i = 0; i < columnNames.size(); ++i)
+    {
+        std::vector<double>& samples = columnSamples[i];
+        std::sort(samples.begin(), samples.end());
+
+        double mean = 0.0;
+        for (GLuint j = 0; j < samples.size(); ++j)
+            mean += samples[j];
+        if (!samples.empty())
+            mean /= samples.size();
+
+        summaryFile << columnNames[i] << "," << samples.size() << "," << mean << ","
+                    << computePercentile(samples, 50.0) << "," << computePercentile(samples, 95.0) << ","
+                    << computePercentile(samples, 99.0) << "," << (samples.empty() ? 0.0 : samples.back()) << "\n";
+
+        // Per-pass GL counters stay in the files, the console only gets the frame totals
+        if (i >= firstCounterColumn && i < firstMemoryColumn && columnNames[i].compare(0, 6, "total_") != 0)
+            continue;
+
+        const char* unit = i < firstCounterColumn ? "ms" : i < firstMemoryColumn ? "  " : "MB";
+
+        std::printf("  %-28s p50 %8.3f %s  p95 %8.3f %s  p99 %8.3f %s  max %8.3f %s\n", columnNames[i].c_str(),
+                    computePercentile(samples, 50.0), unit, computePercentile(samples, 95.0), unit,
+                    computePercentile(samples, 99.0), unit, samples.empty() ? 0.0 : samples.back(), unit);
+    }
+
+    std::cout << "BENCHMARK - CSV WRITTEN : " << this->benchCSVPath << ", " << summaryPath << std::endl;
+
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+
+// One line of a benchmark script: "<frame> <command> <arguments...>"
+struct BenchmarkEvent
+{
+    GLuint eventFrame;
+    std::string eventCommand;
+    std::vector<std::string> eventArgs;
+};
+
+
+// Camera keyframe of the scripted path, interpolated linearly between frames
+struct BenchmarkCameraKey
+{
+    GLuint keyFrame;
+    glm::vec3 keyPosition;
+    GLfloat keyYaw, keyPitch;
+};
+
+
+// Timings gathered for one benchmark frame
+struct BenchmarkFrame
+{
+    double frameInterval;                       // Wall time from the start of the frame to the end of its swap (ms)
+    std::map<std::string, GLfloat> cpuTimes;    // Per-zone CPU time (ms)
+    std::map<std::string, GLfloat> gpuTimes;    // Per-zone GPU time (ms), filled in once the frame retired
+    std::map<std::string, GLuint> glCounts;     // GL call counters per pass, when GLStats is enabled
+    std::map<std::string, GLfloat> memorySizes; // Live GL resource totals per category at the end of the frame (MB)
+};
+
+
+// Headless benchmark mode: command-line options, scripted playback and CSV output
+class Benchmark
+{
+    public:
+        Benchmark();
+        ~Benchmark();
+        bool setBenchmark(int argc, char* argv[]);
+        bool loadScript(const std::string& scriptPath);
+        bool isActive();
+        bool isGLStatsEnabled();
+        GLuint getWidth();
+        GLuint getHeight();
+        GLuint getFrameCount();
+        GLfloat getTimeStep();
+        std::vector<BenchmarkEvent> getFrameEvents(GLuint frame);
+        bool getFrameCamera(GLuint frame, glm::vec3& position, GLfloat& yaw, GLfloat& pitch);
+        void recordFrame(GLuint frame, double frameInterval);
+        void recordGPU(GLuint64 firstProfilerFrame);
+        void recordMemory(GLuint frame, const std::string& memoryName, GLfloat size);
+        bool writeCSV();
+
+    private:
+        bool benchActive, benchGLStats;
+        GLuint benchWidth, benchHeight, benchFrames, benchWarmup;
+        GLfloat benchTimeStep;
+        std::string benchScriptPath, benchCSVPath;
+        std::vector<BenchmarkEvent> benchEvents;
+        std::vector<BenchmarkCameraKey> benchCameraKeys;
+        std::vector<BenchmarkFrame> benchFrameTimes;
+        std::vector<std::string> benchZoneNames, benchCounterNames, benchMemoryNames;
+
+        void addZoneName(const std::string& zoneName);
+        void addCounterName(const std::string& counterName);
+        void addMemoryName(const std::string& memoryName);
+};
+
+#endif
@@ -0,0 +1,278 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include <glad/glad.h>
+
+#include "framestats.h"
+#include "profiler.h"
+
+
+std::map<std::string, std::deque<GLfloat> > FrameStats::frameSeries;
+std::vector<std::string> FrameStats::seriesNames;
+std::map<std::string, GLuint64> FrameStats::gpuSampleFrames;
+std::vector<std::string> FrameStats::frameEvents;
+std::deque<FrameHitch> FrameStats::frameHitches;
+GLuint FrameStats::windowSize = 600;
+GLuint FrameStats::hitchLogSize = 32;
+GLfloat FrameStats::hitchThreshold = 50.0f;
+GLuint64 FrameStats::recordedFrames = 0;
+double FrameStats::firstPresentTime = 0.0;
+double FrameStats::lastPresentTime = 0.0;
+
+
+// Nearest-rank percentile of an already sorted sample list
+static GLfloat getPercentile(const std::vector<GLfloat>& sortedSamples, GLfloat percentile)
+{
+    if (sortedSamples.empty())
+        return 0.0f;
+
+    size_t rank = (size_t)std::ceil(percentile / 100.0f * sortedSamples.size());
+    rank = std::max<size_t>(rank, 1);
+
+    return sortedSamples[std::min(rank, sortedSamples.size()) - 1];
+}
+
+
+bool FrameStats::isFrameStatsOption(const std::string& arg)
+{
+    return arg == "--hitch-ms" || arg == "--stats-window";
+}
+
+
+bool FrameStats::setFrameStats(int argc, char* argv[])
+{
+    // Only frame statistics options are read here, the benchmark parser handles the rest
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc) && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+
+        if (arg == "--hitch-ms" && hasValue)
+            hitchThreshold = std::atof(argv[++i]);
+        else if (arg == "--stats-window" && hasValue)
+            windowSize = std::atoi(argv[++i]);
+    }
+
+    if (hitchThreshold <= 0.0f || windowSize == 0)
+    {
+        std::cerr << "FRAMESTATS - INVALID SETTINGS : hitch " << hitchThreshold << " ms, window " << windowSize << " frames" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+void FrameStats::recordFrame()
+{
+    // Called right after the swap, the present interval runs from one swap to the next
+    double presentTime = Profiler::getTime() / 1000.0;
+    const std::vector<ProfilerZoneRecord>& frameZones = Profiler::getFrameZones();
+    GLfloat frameTime = 0.0f;
+
+    if (!frameZones.empty())
+        frameTime = (frameZones[0].cpuStop - frameZones[0].cpuStart) / 1000.0;
+
+    addSample("Frame CPU", frameTime);
+
+    if (recordedFrames == 0)
+        firstPresentTime = presentTime;
+    else
+    {
+        GLfloat presentInterval = presentTime - lastPresentTime;
+        addSample("Present", presentInterval);
+
+        if (presentInterval > hitchThreshold)
+        {
+            FrameHitch hitch;
+            hitch.hitchFrame = recordedFrames;
+            hitch.hitchTime = (presentTime - firstPresentTime) / 1000.0;
+            hitch.presentInterval = presentInterval;
+            hitch.frameTime = frameTime;
+            hitch.hitchZone = getHotZone();
+            hitch.hitchEvents = frameEvents;
+
+            std::cout << "FRAMESTATS - HITCH AT FRAME " << hitch.hitchFrame << " : " << presentInterval << " ms, " << hitch.hitchZone;
+            for (GLuint i = 0; i < hitch.hitchEvents.size(); ++i)
+                std::cout << (i == 0 ? " (" : ", ") << hitch.hitchEvents[i];
+            std::cout << (hitch.hitchEvents.empty() ? "" : ")") << std::endl;
+
+            frameHitches.push_front(hitch);
+            if (frameHitches.size() > hitchLogSize)
+                frameHitches.pop_back();
+        }
+    }
+
+    // GPU passes come back a few frames late, each resolved frame is sampled once
+    for (GLuint i = 0; i < frameZones.size(); ++i)
+    {
+        const std::string& zoneName = frameZones[i].zoneName;
+
+        if (frameZones[i].zoneDepth != 1 || frameZones[i].zoneGPUPass < 0 || !Profiler::isZoneGPUResolved(zoneName))
+            continue;
+
+        GLuint64 gpuFrame = Profiler::getZoneGPUFrame(zoneName);
+        std::map<std::string, GLuint64>::iterator sampled = gpuSampleFrames.find(zoneName);
+
+        if (sampled != gpuSampleFrames.end() && sampled->second == gpuFrame)
+            continue;
+
+        gpuSampleFrames[zoneName] = gpuFrame;
+        addSample(zoneName + " GPU", Profiler::getZoneGPUTime(zoneName));
+    }
+
+    frameEvents.clear();
+    lastPresentTime = presentTime;
+    recordedFrames++;
+}
+
+
+void FrameStats::addEvent(const std::string& event)
+{
+    frameEvents.push_back(event);
+}
+
+
+void FrameStats::setHitchThreshold(GLfloat threshold)
+{
+    hitchThreshold = threshold;
+}
+
+
+GLfloat FrameStats::getHitchThreshold()
+{
+    return hitchThreshold;
+}
+
+
+GLuint FrameStats::getWindowSize()
+{
+    return windowSize;
+}
+
+
+const std::vector<std::string>& FrameStats::getSeriesNames()
+{
+    return seriesNames;
+}
+
+
+std::vector<GLfloat> FrameStats::getSamples(const std::string& seriesName)
+{
+    std::map<std::string, std::deque<GLfloat> >::iterator series = frameSeries.find(seriesName);
+
+    if (series == frameSeries.end())
+        return std::vector<GLfloat>();
+
+    return std::vector<GLfloat>(series->second.begin(), series->second.end());
+}
+
+
+FrameStatsSummary FrameStats::getSummary(const std::string& seriesName)
+{
+    std::vector<GLfloat> samples = getSamples(seriesName);
+    std::sort(samples.begin(), samples.end());
+
+    FrameStatsSummary summary;
+    summary.sampleCount = samples.size();
+    summary.mean = 0.0f;
+
+    for (GLuint i = 0; i < samples.size(); ++i)
+        summary.mean += samples[i];
+    if (!samples.empty())
+        summary.mean /= samples.size();
+
+    summary.p50 = getPercentile(samples, 50.0f);
+    summary.p95 = getPercentile(samples, 95.0f);
+    summary.p99 = getPercentile(samples, 99.0f);
+    summary.max = samples.empty() ? 0.0f : samples.back();
+
+    return summary;
+}
+
+
+std::vector<GLfloat> FrameStats::getHistogram(const std::string& seriesName, GLuint bucketCount, GLfloat maxValue)
+{
+    std::vector<GLfloat> histogram(bucketCount, 0.0f);
+    std::vector<GLfloat> samples = getSamples(seriesName);
+
+    if (bucketCount == 0 || maxValue <= 0.0f)
+        return histogram;
+
+    // Samples past the range land in the last bucket so hitches stay visible
+    for (GLuint i = 0; i < samples.size(); ++i)
+    {
+        GLuint bucket = std::min((GLuint)(samples[i] / maxValue * bucketCount), bucketCount - 1);
+        histogram[bucket] += 1.0f;
+    }
+
+    return histogram;
+}
+
+
+const std::deque<FrameHitch>& FrameStats::getHitches()
+{
+    return frameHitches;
+}
+
+
+void FrameStats::clearHitches()
+{
+    frameHitches.clear();
+}
+
+
+void FrameStats::addSample(const std::string& seriesName, GLfloat sample)
+{
+    std::deque<GLfloat>& series = frameSeries[seriesName];
+
+    if (series.empty() && std::find(seriesNames.begin(), seriesNames.end(), seriesName) == seriesNames.end())
+        seriesNames.push_back(seriesName);
+
+    series.push_back(sample);
+
+    while (series.size() > windowSize)
+        series.pop_front();
+}
+
+
+std::string FrameStats::getHotZone()
+{
+    // Follow the slowest child from the frame down, as long as it accounts for most of its parent
+    const std::vector<ProfilerZoneRecord>& frameZones = Profiler::getFrameZones();
+    std::string zonePath;
+    size_t parent = 0;
+
+    while (parent < frameZones.size())
+    {
+        GLuint parentDepth = frameZones[parent].zoneDepth;
+        double parentTime = frameZones[parent].cpuStop - frameZones[parent].cpuStart;
+        size_t slowest = frameZones.size();
+        double slowestTime = 0.0;
+
+        for (size_t i = parent + 1; i < frameZones.size() && frameZones[i].zoneDepth > parentDepth; ++i)
+        {
+            double zoneTime = frameZones[i].cpuStop - frameZones[i].cpuStart;
+
+            if (frameZones[i].zoneDepth == parentDepth + 1 && zoneTime > slowestTime)
+            {
+                slowest = i;
+                slowestTime = zoneTime;
+            }
+        }
+
+        if (slowest == frameZones.size() || (!zonePath.empty() && slowestTime < 0.5 * parentTime))
+            break;
+
+        zonePath += (zonePath.empty() ? "" : " > ") + frameZones[slowest].zoneName;
+        parent = slowest;
+    }
+
+    return zonePath.empty() ? "Frame" : zonePath;
+}
@@ -0,0 +1,65 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+#include <glad/glad.h>
+
+
+// Distribution of one series over the rolling window (ms)
+struct FrameStatsSummary
+{
+    GLuint sampleCount;
+    GLfloat mean, p50, p95, p99, max;
+};
+
+
+// A frame whose present interval went over the hitch threshold
+struct FrameHitch
+{
+    GLuint64 hitchFrame;
+    double hitchTime;                       // Seconds since the first recorded frame
+    GLfloat presentInterval, frameTime;     // ms
+    std::string hitchZone;                  // Hottest zone path of the frame, "ImGui Setup > IBL Setup"
+    std::vector<std::string> hitchEvents;   // What the application did during the frame (model, material, HDRI switches...)
+};
+
+
+// Rolling frame-time statistics: CPU frame time, present interval and GPU pass
+// times over the last frames, with percentiles, histograms and a hitch log
+class FrameStats
+{
+    public:
+        static bool isFrameStatsOption(const std::string& arg);
+        static bool setFrameStats(int argc, char* argv[]);
+        static void recordFrame();
+        static void addEvent(const std::string& event);
+        static void setHitchThreshold(GLfloat threshold);
+        static GLfloat getHitchThreshold();
+        static GLuint getWindowSize();
+        static const std::vector<std::string>& getSeriesNames();
+        static std::vector<GLfloat> getSamples(const std::string& seriesName);
+        static FrameStatsSummary getSummary(const std::string& seriesName);
+        static std::vector<GLfloat> getHistogram(const std::string& seriesName, GLuint bucketCount, GLfloat maxValue);
+        static const std::deque<FrameHitch>& getHitches();
+        static void clearHitches();
+
+    private:
+        static std::map<std::string, std::deque<GLfloat> > frameSeries;
+        static std::vector<std::string> seriesNames;
+        static std::map<std::string, GLuint64> gpuSampleFrames;
+        static std::vector<std::string> frameEvents;
+        static std::deque<FrameHitch> frameHitches;
+        static GLuint windowSize, hitchLogSize;
+        static GLfloat hitchThreshold;
+        static GLuint64 recordedFrames;
+        static double firstPresentTime, lastPresentTime;
+
+        static void addSample(const std::string& seriesName, GLfloat sample);
+        static std::string getHotZone();
+};
+
+#endif
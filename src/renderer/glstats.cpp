@@ -0,0 +1,480 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+#include <glad/glad.h>
+
+#include "glstats.h"
+
+
+GLStatsCounters::GLStatsCounters()
+{
+    this->drawCalls = 0;
+    this->programBinds = 0;
+    this->textureBinds = 0;
+    this->framebufferBinds = 0;
+    this->vertexArrayBinds = 0;
+    this->redundantBinds = 0;
+    this->uniformUploads = 0;
+    this->bufferUploads = 0;
+    this->getCalls = 0;
+}
+
+
+GLStatsCounters& GLStatsCounters::operator+=(const GLStatsCounters& counters)
+{
+    this->drawCalls += counters.drawCalls;
+    this->programBinds += counters.programBinds;
+    this->textureBinds += counters.textureBinds;
+    this->framebufferBinds += counters.framebufferBinds;
+    this->vertexArrayBinds += counters.vertexArrayBinds;
+    this->redundantBinds += counters.redundantBinds;
+    this->uniformUploads += counters.uniformUploads;
+    this->bufferUploads += counters.bufferUploads;
+    this->getCalls += counters.getCalls;
+
+    return *this;
+}
+
+
+// Shadow of the bound objects, used to spot redundant binds. Reset whenever the
+// hooks are installed since calls made while disabled went unseen.
+const GLuint unknownBinding = 0xFFFFFFFF;
+
+static GLuint shadowProgram = unknownBinding;
+static GLuint shadowDrawFramebuffer = unknownBinding;
+static GLuint shadowReadFramebuffer = unknownBinding;
+static GLuint shadowVertexArray = unknownBinding;
+static GLenum shadowActiveTexture = GL_TEXTURE0;
+static std::map<std::pair<GLenum, GLenum>, GLuint> shadowTextures;    // (unit, target) -> texture
+
+
+// Counting wrappers: tally the call in the current pass, then forward to the driver
+#define GLSTATS_HOOK(returnType, proc, counter, params, args)   \
+    static decltype(glad_##proc) original_##proc = NULL;        \
+    static returnType APIENTRY hook_##proc params               \
+    {                                                           \
+        GLStats::getCounters().counter++;                       \
+        return original_##proc args;                            \
+    }
+
+GLSTATS_HOOK(void, glDrawArrays, drawCalls, (GLenum mode, GLint first, GLsizei count), (mode, first, count))
+GLSTATS_HOOK(void, glDrawElements, drawCalls, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices))
+GLSTATS_HOOK(void, glDrawArraysInstanced, drawCalls, (GLenum mode, GLint first, GLsizei count, GLsizei instances), (mode, first, count, instances))
+GLSTATS_HOOK(void, glDrawElementsInstanced, drawCalls, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances), (mode, count, type, indices, instances))
+GLSTATS_HOOK(void, glDrawElementsBaseVertex, drawCalls, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex), (mode, count, type, indices, baseVertex))
+
+GLSTATS_HOOK(void, glUniform1f, uniformUploads, (GLint location, GLfloat v0), (location, v0))
+GLSTATS_HOOK(void, glUniform2f, uniformUploads, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1))
+GLSTATS_HOOK(void, glUniform3f, uniformUploads, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2))
+GLSTATS_HOOK(void, glUniform4f, uniformUploads, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3))
+GLSTATS_HOOK(void, glUniform1i, uniformUploads, (GLint location, GLint v0), (location, v0))
+GLSTATS_HOOK(void, glUniform2i, uniformUploads, (GLint location, GLint v0, GLint v1), (location, v0, v1))
+GLSTATS_HOOK(void, glUniform3i, uniformUploads, (GLint location, GLint v0, GLint v1, GLint v2), (location, v0, v1, v2))
+GLSTATS_HOOK(void, glUniform4i, uniformUploads, (GLint location, GLint v0, GLint v1, GLint v2, GLint v3), (location, v0, v1, v2, v3))
+GLSTATS_HOOK(void, glUniform1fv, uniformUploads, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+GLSTATS_HOOK(void, glUniform2fv, uniformUploads, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+GLSTATS_HOOK(void, glUniform3fv, uniformUploads, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+GLSTATS_HOOK(void, glUniform4fv, uniformUploads, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+GLSTATS_HOOK(void, glUniform1iv, uniformUploads, (GLint location, GLsizei count, const GLint* value), (location, count, value))
+GLSTATS_HOOK(void, glUniformMatrix3fv, uniformUploads, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))
+GLSTATS_HOOK(void, glUniformMatrix4fv, uniformUploads, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))
+
+GLSTATS_HOOK(void, glBufferData, bufferUploads, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage))
+GLSTATS_HOOK(void, glBufferSubData, bufferUploads, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data))
+
+GLSTATS_HOOK(void, glGetBooleanv, getCalls, (GLenum pname, GLboolean* data), (pname, data))
+GLSTATS_HOOK(void, glGetIntegerv, getCalls, (GLenum pname, GLint* data), (pname, data))
+GLSTATS_HOOK(void, glGetInteger64v, getCalls, (GLenum pname, GLint64* data), (pname, data))
+GLSTATS_HOOK(void, glGetFloatv, getCalls, (GLenum pname, GLfloat* data), (pname, data))
+GLSTATS_HOOK(const GLubyte*, glGetString, getCalls, (GLenum name), (name))
+GLSTATS_HOOK(GLenum, glGetError, getCalls, (), ())
+GLSTATS_HOOK(GLint, glGetUniformLocation, getCalls, (GLuint program, const GLchar* name), (program, name))
+GLSTATS_HOOK(GLint, glGetAttribLocation, getCalls, (GLuint program, const GLchar* name), (program, name))
+GLSTATS_HOOK(void, glGetProgramiv, getCalls, (GLuint program, GLenum pname, GLint* params), (program, pname, params))
+GLSTATS_HOOK(void, glGetShaderiv, getCalls, (GLuint shader, GLenum pname, GLint* params), (shader, pname, params))
+GLSTATS_HOOK(void, glGetQueryObjectiv, getCalls, (GLuint id, GLenum pname, GLint* params), (id, pname, params))
+GLSTATS_HOOK(void, glGetQueryObjectui64v, getCalls, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params))
+
+#undef GLSTATS_HOOK
+
+
+// Bind wrappers also compare against the shadow state
+static decltype(glad_glUseProgram) original_glUseProgram = NULL;
+static decltype(glad_glActiveTexture) original_glActiveTexture = NULL;
+static decltype(glad_glBindTexture) original_glBindTexture = NULL;
+static decltype(glad_glBindFramebuffer) original_glBindFramebuffer = NULL;
+static decltype(glad_glBindVertexArray) original_glBindVertexArray = NULL;
+static decltype(glad_glDeleteProgram) original_glDeleteProgram = NULL;
+static decltype(glad_glDeleteTextures) original_glDeleteTextures = NULL;
+static decltype(glad_glDeleteFramebuffers) original_glDeleteFramebuffers = NULL;
+static decltype(glad_glDeleteVertexArrays) original_glDeleteVertexArrays = NULL;
+
+
+static void APIENTRY hook_glUseProgram(GLuint program)
+{
+    GLStatsCounters& counters = GLStats::getCounters();
+    counters.programBinds++;
+
+    if (program == shadowProgram)
+        counters.redundantBinds++;
+
+    shadowProgram = program;
+    original_glUseProgram(program);
+}
+
+
+static void APIENTRY hook_glActiveTexture(GLenum texture)
+{
+    shadowActiveTexture = texture;
+    original_glActiveTexture(texture);
+}
+
+
+static void APIENTRY hook_glBindTexture(GLenum target, GLuint texture)
+{
+    GLStatsCounters& counters = GLStats::getCounters();
+    counters.textureBinds++;
+
+    std::map<std::pair<GLenum, GLenum>, GLuint>::iterator binding = shadowTextures.find(std::make_pair(shadowActiveTexture, target));
+
+    if (binding != shadowTextures.end() && binding->second == texture)
+        counters.redundantBinds++;
+
+    shadowTextures[std::make_pair(shadowActiveTexture, target)] = texture;
+    original_glBindTexture(target, texture);
+}
+
+
+static void APIENTRY hook_glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    GLStatsCounters& counters = GLStats::getCounters();
+    counters.framebufferBinds++;
+
+    bool drawTarget = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    bool readTarget = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+
+    if ((!drawTarget || shadowDrawFramebuffer == framebuffer) && (!readTarget || shadowReadFramebuffer == framebuffer))
+        counters.redundantBinds++;
+
+    if (drawTarget)
+        shadowDrawFramebuffer = framebuffer;
+    if (readTarget)
+        shadowReadFramebuffer = framebuffer;
+
+    original_glBindFramebuffer(target, framebuffer);
+}
+
+
+static void APIENTRY hook_glBindVertexArray(GLuint array)
+{
+    GLStatsCounters& counters = GLStats::getCounters();
+    counters.vertexArrayBinds++;
+
+    if (array == shadowVertexArray)
+        counters.redundantBinds++;
+
+    shadowVertexArray = array;
+    original_glBindVertexArray(array);
+}
+
+
+// Deleted names get recycled by the driver, forget them so a new object is not taken for a rebind
+static void APIENTRY hook_glDeleteProgram(GLuint program)
+{
+    if (program == shadowProgram)
+        shadowProgram = unknownBinding;
+
+    original_glDeleteProgram(program);
+}
+
+
+static void APIENTRY hook_glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        for (std::map<std::pair<GLenum, GLenum>, GLuint>::iterator it = shadowTextures.begin(); it != shadowTextures.end(); ++it)
+        {
+            if (it->second == textures[i])
+                it->second = unknownBinding;
+        }
+    }
+
+    original_glDeleteTextures(n, textures);
+}
+
+
+static void APIENTRY hook_glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (framebuffers[i] == shadowDrawFramebuffer)
+            shadowDrawFramebuffer = unknownBinding;
+        if (framebuffers[i] == shadowReadFramebuffer)
+            shadowReadFramebuffer = unknownBinding;
+    }
+
+    original_glDeleteFramebuffers(n, framebuffers);
+}
+
+
+static void APIENTRY hook_glDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (arrays[i] == shadowVertexArray)
+            shadowVertexArray = unknownBinding;
+    }
+
+    original_glDeleteVertexArrays(n, arrays);
+}
+
+
+// Swaps one glad pointer between the driver entry point and its wrapper
+template <typename Proc>
+static void installHook(Proc& gladProc, Proc& originalProc, Proc hookProc, bool enabled)
+{
+    if (originalProc == NULL)
+        originalProc = gladProc;
+
+    // Entry points the driver does not expose stay untouched
+    if (originalProc == NULL)
+        return;
+
+    gladProc = enabled ? hookProc : originalProc;
+}
+
+
+void GLStats::installHooks(bool enabled)
+{
+    installHook(glad_glDrawArrays, original_glDrawArrays, hook_glDrawArrays, enabled);
+    installHook(glad_glDrawElements, original_glDrawElements, hook_glDrawElements, enabled);
+    installHook(glad_glDrawArraysInstanced, original_glDrawArraysInstanced, hook_glDrawArraysInstanced, enabled);
+    installHook(glad_glDrawElementsInstanced, original_glDrawElementsInstanced, hook_glDrawElementsInstanced, enabled);
+    installHook(glad_glDrawElementsBaseVertex, original_glDrawElementsBaseVertex, hook_glDrawElementsBaseVertex, enabled);
+
+    installHook(glad_glUniform1f, original_glUniform1f, hook_glUniform1f, enabled);
+    installHook(glad_glUniform2f, original_glUniform2f, hook_glUniform2f, enabled);
+    installHook(glad_glUniform3f, original_glUniform3f, hook_glUniform3f, enabled);
+    installHook(glad_glUniform4f, original_glUniform4f, hook_glUniform4f, enabled);
+    installHook(glad_glUniform1i, original_glUniform1i, hook_glUniform1i, enabled);
+    installHook(glad_glUniform2i, original_glUniform2i, hook_glUniform2i, enabled);
+    installHook(glad_glUniform3i, original_glUniform3i, hook_glUniform3i, enabled);
+    installHook(glad_glUniform4i, original_glUniform4i, hook_glUniform4i, enabled);
+    installHook(glad_glUniform1fv, original_glUniform1fv, hook_glUniform1fv, enabled);
+    installHook(glad_glUniform2fv, original_glUniform2fv, hook_glUniform2fv, enabled);
+    installHook(glad_glUniform3fv, original_glUniform3fv, hook_glUniform3fv, enabled);
+    installHook(glad_glUniform4fv, original_glUniform4fv, hook_glUniform4fv, enabled);
+    installHook(glad_glUniform1iv, original_glUniform1iv, hook_glUniform1iv, enabled);
+    installHook(glad_glUniformMatrix3fv, original_glUniformMatrix3fv, hook_glUniformMatrix3fv, enabled);
+    installHook(glad_glUniformMatrix4fv, original_glUniformMatrix4fv, hook_glUniformMatrix4fv, enabled);
+
+    installHook(glad_glBufferData, original_glBufferData, hook_glBufferData, enabled);
+    installHook(glad_glBufferSubData, original_glBufferSubData, hook_glBufferSubData, enabled);
+
+    installHook(glad_glGetBooleanv, original_glGetBooleanv, hook_glGetBooleanv, enabled);
+    installHook(glad_glGetIntegerv, original_glGetIntegerv, hook_glGetIntegerv, enabled);
+    installHook(glad_glGetInteger64v, original_glGetInteger64v, hook_glGetInteger64v, enabled);
+    installHook(glad_glGetFloatv, original_glGetFloatv, hook_glGetFloatv, enabled);
+    installHook(glad_glGetString, original_glGetString, hook_glGetString, enabled);
+    installHook(glad_glGetError, original_glGetError, hook_glGetError, enabled);
+    installHook(glad_glGetUniformLocation, original_glGetUniformLocation, hook_glGetUniformLocation, enabled);
+    installHook(glad_glGetAttribLocation, original_glGetAttribLocation, hook_glGetAttribLocation, enabled);
+    installHook(glad_glGetProgramiv, original_glGetProgramiv, hook_glGetProgramiv, enabled);
+    installHook(glad_glGetShaderiv, original_glGetShaderiv, hook_glGetShaderiv, enabled);
+    installHook(glad_glGetQueryObjectiv, original_glGetQueryObjectiv, hook_glGetQueryObjectiv, enabled);
+    installHook(glad_glGetQueryObjectui64v, original_glGetQueryObjectui64v, hook_glGetQueryObjectui64v, enabled);
+
+    installHook(glad_glUseProgram, original_glUseProgram, hook_glUseProgram, enabled);
+    installHook(glad_glActiveTexture, original_glActiveTexture, hook_glActiveTexture, enabled);
+    installHook(glad_glBindTexture, original_glBindTexture, hook_glBindTexture, enabled);
+    installHook(glad_glBindFramebuffer, original_glBindFramebuffer, hook_glBindFramebuffer, enabled);
+    installHook(glad_glBindVertexArray, original_glBindVertexArray, hook_glBindVertexArray, enabled);
+    installHook(glad_glDeleteProgram, original_glDeleteProgram, hook_glDeleteProgram, enabled);
+    installHook(glad_glDeleteTextures, original_glDeleteTextures, hook_glDeleteTextures, enabled);
+    installHook(glad_glDeleteFramebuffers, original_glDeleteFramebuffers, hook_glDeleteFramebuffers, enabled);
+    installHook(glad_glDeleteVertexArrays, original_glDeleteVertexArrays, hook_glDeleteVertexArrays, enabled);
+}
+
+
+void GLStats::setEnabled(bool enabled)
+{
+    // Needs gladLoadGL to have run, the wrappers keep the driver pointers it loaded
+    if (enabled == statsEnabled)
+        return;
+
+    statsEnabled = enabled;
+
+    shadowProgram = unknownBinding;
+    shadowDrawFramebuffer = unknownBinding;
+    shadowReadFramebuffer = unknownBinding;
+    shadowVertexArray = unknownBinding;
+    shadowActiveTexture = GL_TEXTURE0;
+    shadowTextures.clear();
+
+    if (enabled)
+    {
+        // Calls made before the hooks went in were not seen, start from the real state
+        GLint binding = 0;
+
+        glGetIntegerv(GL_CURRENT_PROGRAM, &binding);
+        shadowProgram = binding;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &binding);
+        shadowDrawFramebuffer = binding;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &binding);
+        shadowReadFramebuffer = binding;
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &binding);
+        shadowVertexArray = binding;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &binding);
+        shadowActiveTexture = binding;
+    }
+
+    installHooks(enabled);
+
+    framePasses.clear();
+    lastFramePasses.clear();
+    passStack.clear();
+    currentPass = -1;
+    inFrame = false;
+}
+
+
+bool GLStats::isEnabled()
+{
+    return statsEnabled;
+}
+
+
+void GLStats::beginFrame()
+{
+    if (!statsEnabled)
+        return;
+
+    framePasses.clear();
+    inFrame = true;
+
+    // Calls made between passes land in the frame's own bucket
+    beginPass("Frame");
+}
+
+
+void GLStats::endFrame()
+{
+    if (!statsEnabled)
+        return;
+
+    inFrame = false;
+    passStack.clear();
+    currentPass = -1;
+    lastFramePasses.swap(framePasses);
+}
+
+
+void GLStats::beginPass(const std::string& passName)
+{
+    if (!statsEnabled || !inFrame)
+        return;
+
+    passStack.push_back(currentPass);
+
+    // Passes opened several times in a frame share their counters
+    for (GLuint i = 0; i < framePasses.size(); ++i)
+    {
+        if (framePasses[i].passName == passName)
+        {
+            currentPass = i;
+            return;
+        }
+    }
+
+    GLStatsPass pass;
+    pass.passName = passName;
+    framePasses.push_back(pass);
+
+    currentPass = framePasses.size() - 1;
+}
+
+
+void GLStats::endPass()
+{
+    // Calls after a nested pass go back to the one around it, the frame at the outermost level
+    if (!statsEnabled || !inFrame || passStack.empty())
+        return;
+
+    currentPass = passStack.back();
+    passStack.pop_back();
+}
+
+
+GLStatsCounters& GLStats::getCounters()
+{
+    // Calls outside of a frame (loading, setup) are not reported per pass
+    if (currentPass < 0)
+        return outsideCounters;
+
+    return framePasses[currentPass].passCounters;
+}
+
+
+const std::vector<GLStatsPass>& GLStats::getFramePasses()
+{
+    return lastFramePasses;
+}
+
+
+GLStatsCounters GLStats::getFrameTotals()
+{
+    GLStatsCounters totals;
+
+    for (GLuint i = 0; i < lastFramePasses.size(); ++i)
+        totals += lastFramePasses[i].passCounters;
+
+    return totals;
+}
+
+
+std::vector<std::string> GLStats::getCounterNames()
+{
+    std::vector<std::string> counterNames;
+
+    counterNames.push_back("draws");
+    counterNames.push_back("program_binds");
+    counterNames.push_back("texture_binds");
+    counterNames.push_back("fbo_binds");
+    counterNames.push_back("vao_binds");
+    counterNames.push_back("redundant_binds");
+    counterNames.push_back("uniforms");
+    counterNames.push_back("buffer_uploads");
+    counterNames.push_back("gets");
+
+    return counterNames;
+}
+
+
+std::vector<GLuint> GLStats::getCounterValues(const GLStatsCounters& counters)
+{
+    std::vector<GLuint> counterValues;
+
+    counterValues.push_back(counters.drawCalls);
+    counterValues.push_back(counters.programBinds);
+    counterValues.push_back(counters.textureBinds);
+    counterValues.push_back(counters.framebufferBinds);
+    counterValues.push_back(counters.vertexArrayBinds);
+    counterValues.push_back(counters.redundantBinds);
+    counterValues.push_back(counters.uniformUploads);
+    counterValues.push_back(counters.bufferUploads);
+    counterValues.push_back(counters.getCalls);
+
+    return counterValues;
+}
+
+
+// Static member initialization
+std::vector<GLStatsPass> GLStats::framePasses;
+std::vector<GLStatsPass> GLStats::lastFramePasses;
+GLStatsCounters GLStats::outsideCounters;
+GLint GLStats::currentPass = -1;
+std::vector<GLint> GLStats::passStack;
+bool GLStats::inFrame = false;
+bool GLStats::statsEnabled = false;
@@ -0,0 +1,60 @@
+#ifndef GLSTATS_H
+#define GLSTATS_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+// GL calls counted for one pass (or a whole frame)
+struct GLStatsCounters
+{
+    GLuint drawCalls;
+    GLuint programBinds, textureBinds, framebufferBinds, vertexArrayBinds;
+    GLuint redundantBinds;      // Binds of the object that was already bound
+    GLuint uniformUploads;
+    GLuint bufferUploads;       // glBufferData / glBufferSubData, uniform blocks included
+    GLuint getCalls;            // glGet* round-trips, glGetUniformLocation included
+
+    GLStatsCounters();
+    GLStatsCounters& operator+=(const GLStatsCounters& counters);
+};
+
+
+struct GLStatsPass
+{
+    std::string passName;
+    GLStatsCounters passCounters;
+};
+
+
+// Optional instrumentation over the glad function pointers. While enabled, the
+// counted entry points are swapped for wrappers that tally each call into the
+// current profiler pass, then forward to the driver.
+class GLStats
+{
+    public:
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+        static void beginFrame();
+        static void endFrame();
+        static void beginPass(const std::string& passName);
+        static void endPass();
+        static GLStatsCounters& getCounters();
+        static const std::vector<GLStatsPass>& getFramePasses();
+        static GLStatsCounters getFrameTotals();
+        static std::vector<std::string> getCounterNames();
+        static std::vector<GLuint> getCounterValues(const GLStatsCounters& counters);
+
+    private:
+        static std::vector<GLStatsPass> framePasses, lastFramePasses;
+        static GLStatsCounters outsideCounters;
+        static GLint currentPass;
+        static std::vector<GLint> passStack;        // Enclosing passes, restored when the inner one ends
+        static bool inFrame, statsEnabled;
+
+        static void installHooks(bool enabled);
+};
+
+#endif
@@ -0,0 +1,455 @@
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <glad/glad.h>
+
+#include "goldentest.h"
+#include "profiler.h"
+#include "stb_image.h"
+
+// STB Image Write Implementation
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+
+// Built-in scenes, in the order the GUI lists them
+const char* goldenModels[] = { "sphere", "cube", "torus", "pyramid", "statue" };
+const char* goldenMaterials[] = { "quartz", "shiny", "granite" };
+const GLint goldenViewCount = 9;
+
+
+static bool makeDirectory(const std::string& dirPath)
+{
+#ifdef _WIN32
+    _mkdir(dirPath.c_str());
+#else
+    mkdir(dirPath.c_str(), 0755);
+#endif
+
+    // Already existing directories are fine, anything else shows up when writing
+    return true;
+}
+
+
+GoldenTest::GoldenTest()
+{
+    this->goldenActive = false;
+    this->goldenUpdate = false;
+    this->goldenDir = "resources/golden";
+    this->goldenOutputDir = "golden_output";
+    this->goldenPSNR = 40.0f;
+    this->goldenBudgetScale = 1.0f;
+    this->goldenFrames = 6;
+    this->goldenWarmup = 2;
+}
+
+
+GoldenTest::~GoldenTest()
+{
+
+}
+
+
+bool GoldenTest::isGoldenOption(const std::string& arg)
+{
+    return arg == "--golden" || arg == "--golden-dir" || arg == "--golden-output" || arg == "--psnr"
+        || arg == "--budget-scale" || arg == "--filter";
+}
+
+
+bool GoldenTest::setGoldenTest(int argc, char* argv[])
+{
+    // Only golden options are read here, the benchmark parser handles the rest
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc) && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+
+        if (arg == "--golden")
+        {
+            this->goldenActive = true;
+
+            if (hasValue && std::string(argv[i + 1]) == "update")
+            {
+                this->goldenUpdate = true;
+                ++i;
+            }
+        }
+        else if (arg == "--golden-dir" && hasValue)
+            this->goldenDir = argv[++i];
+        else if (arg == "--golden-output" && hasValue)
+            this->goldenOutputDir = argv[++i];
+        else if (arg == "--psnr" && hasValue)
+            this->goldenPSNR = std::atof(argv[++i]);
+        else if (arg == "--budget-scale" && hasValue)
+            this->goldenBudgetScale = std::atof(argv[++i]);
+        else if (arg == "--filter" && hasValue)
+            this->goldenFilter = argv[++i];
+    }
+
+    if (!this->goldenActive)
+        return true;
+
+    makeDirectory(this->goldenOutputDir);
+
+    if (this->goldenUpdate)
+        makeDirectory(this->goldenDir);
+
+    return this->loadBudgets(this->goldenDir + "/budgets.txt");
+}
+
+
+bool GoldenTest::loadBudgets(const std::string& budgetPath)
+{
+    std::ifstream budgetFile(budgetPath.c_str());
+
+    // Without a budget file only the images are checked
+    if (!budgetFile.is_open())
+    {
+        std::cout << "GOLDEN - NO BUDGET FILE : " << budgetPath << std::endl;
+        return true;
+    }
+
+    std::string line;
+    GLuint lineNumber = 0;
+
+    while (std::getline(budgetFile, line))
+    {
+        lineNumber++;
+
+        size_t commentStart = line.find('#');
+        if (commentStart != std::string::npos)
+            line = line.substr(0, commentStart);
+
+        std::istringstream lineStream(line);
+        std::string casePattern;
+        GoldenBudget budget;
+
+        if (!(lineStream >> casePattern))
+            continue;
+
+        // The pass name may contain spaces ("ImGui Setup"), the budget is the last token
+        std::vector<std::string> tokens;
+        std::string token;
+        while (lineStream >> token)
+            tokens.push_back(token);
+
+        size_t firstSlash = casePattern.find('/');
+        size_t secondSlash = casePattern.find('/', firstSlash + 1);
+
+        if (tokens.size() < 2 || firstSlash == std::string::npos || secondSlash == std::string::npos)
+        {
+            std::cerr << "GOLDEN - " << budgetPath << ":" << lineNumber << " : expected <model>/<material>/<view> <pass> <ms>" << std::endl;
+            return false;
+        }
+
+        budget.budgetModel = casePattern.substr(0, firstSlash);
+        budget.budgetMaterial = casePattern.substr(firstSlash + 1, secondSlash - firstSlash - 1);
+        budget.budgetView = casePattern.substr(secondSlash + 1);
+        budget.budgetTime = std::atof(tokens.back().c_str());
+
+        for (GLuint i = 0; i + 1 < tokens.size(); ++i)
+            budget.budgetPass += (i > 0 ? " " : "") + tokens[i];
+
+        this->goldenBudgets.push_back(budget);
+    }
+
+    return true;
+}
+
+
+bool GoldenTest::isActive()
+{
+    return this->goldenActive;
+}
+
+
+std::vector<GoldenCase> GoldenTest::getCases()
+{
+    std::vector<GoldenCase> cases;
+
+    // Model outermost so every model/material pair is only loaded once
+    for (GLuint m = 0; m < sizeof(goldenModels) / sizeof(goldenModels[0]); ++m)
+    {
+        for (GLuint t = 0; t < sizeof(goldenMaterials) / sizeof(goldenMaterials[0]); ++t)
+        {
+            for (GLint view = 1; view <= goldenViewCount; ++view)
+            {
+                GoldenCase goldenCase;
+                goldenCase.caseModel = goldenModels[m];
+                goldenCase.caseMaterial = goldenMaterials[t];
+                goldenCase.caseView = view;
+
+                std::ostringstream caseName;
+                caseName << goldenCase.caseModel << "_" << goldenCase.caseMaterial << "_view" << view;
+                goldenCase.caseName = caseName.str();
+
+                if (this->goldenFilter.empty() || goldenCase.caseName.find(this->goldenFilter) != std::string::npos)
+                    cases.push_back(goldenCase);
+            }
+        }
+    }
+
+    return cases;
+}
+
+
+GLuint GoldenTest::getFrameCount()
+{
+    return this->goldenFrames;
+}
+
+
+GLuint GoldenTest::getWarmupFrames()
+{
+    return this->goldenWarmup;
+}
+
+
+void GoldenTest::beginCase(const GoldenCase& goldenCase)
+{
+    this->currentCase = goldenCase;
+    this->currentTimes.clear();
+}
+
+
+void GoldenTest::recordFrame()
+{
+    // Called once the frame has been finished and resolved, so GPU results belong to it
+    GLuint64 lastFrame = Profiler::getFrameCount() - 1;
+    const std::vector<ProfilerZoneRecord>& frameZones = Profiler::getFrameZones();
+
+    for (GLuint i = 0; i < frameZones.size(); ++i)
+    {
+        const ProfilerZoneRecord& zone = frameZones[i];
+
+        if (zone.zoneDepth > 1)
+            continue;
+
+        // GPU passes are budgeted on their GPU time, CPU-only zones on their CPU time
+        if (zone.zoneGPUPass >= 0 && Profiler::isZoneGPUResolved(zone.zoneName) && Profiler::getZoneGPUFrame(zone.zoneName) == lastFrame)
+            this->currentTimes[zone.zoneName].push_back(Profiler::getZoneGPUTime(zone));
+        else if (zone.zoneGPUPass < 0)
+            this->currentTimes[zone.zoneName].push_back((zone.cpuStop - zone.cpuStart) / 1000.0);
+    }
+}
+
+
+bool GoldenTest::endCase(const std::vector<unsigned char>& pixels, GLuint width, GLuint height)
+{
+    GoldenResult result;
+    result.caseName = this->currentCase.caseName;
+    result.casePSNR = 0.0;
+
+    // Median over the measured frames, a single slow frame should not fail a case
+    for (std::map<std::string, std::vector<GLfloat> >::iterator it = this->currentTimes.begin(); it != this->currentTimes.end(); ++it)
+    {
+        std::vector<GLfloat>& samples = it->second;
+        std::sort(samples.begin(), samples.end());
+
+        if (!samples.empty())
+            result.passTimes[it->first] = samples[samples.size() / 2];
+    }
+
+    result.imagePassed = this->checkImage(result, pixels, width, height);
+    result.budgetPassed = this->checkBudgets(result);
+
+    std::printf("GOLDEN - %s %-28s PSNR %7.2f dB  %s\n", (result.imagePassed && result.budgetPassed) ? "PASS" : "FAIL",
+                result.caseName.c_str(), result.casePSNR, result.caseMessage.c_str());
+
+    this->goldenResults.push_back(result);
+
+    return result.imagePassed && result.budgetPassed;
+}
+
+
+bool GoldenTest::checkImage(GoldenResult& result, const std::vector<unsigned char>& pixels, GLuint width, GLuint height)
+{
+    // glReadPixels rows start at the bottom, images are stored top-down as RGB
+    std::vector<unsigned char> image(width * height * 3);
+
+    for (GLuint y = 0; y < height; ++y)
+    {
+        for (GLuint x = 0; x < width; ++x)
+        {
+            const unsigned char* src = &pixels[((height - 1 - y) * width + x) * 4];
+            unsigned char* dst = &image[(y * width + x) * 3];
+
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    }
+
+    std::string outputPath = this->goldenOutputDir + "/" + result.caseName + ".png";
+    std::string goldenPath = this->goldenDir + "/" + result.caseName + ".png";
+
+    stbi_write_png(outputPath.c_str(), width, height, 3, &image[0], width * 3);
+
+    if (this->goldenUpdate)
+    {
+        if (!stbi_write_png(goldenPath.c_str(), width, height, 3, &image[0], width * 3))
+        {
+            result.caseMessage += "cannot write " + goldenPath + " ";
+            return false;
+        }
+
+        result.casePSNR = std::numeric_limits<double>::infinity();
+        result.caseMessage += "golden updated ";
+        return true;
+    }
+
+    // Texture loading leaves the flip flag set, goldens are read as written
+    stbi_set_flip_vertically_on_load(false);
+
+    int goldenWidth, goldenHeight, goldenComponents;
+    unsigned char* goldenData = stbi_load(goldenPath.c_str(), &goldenWidth, &goldenHeight, &goldenComponents, 3);
+
+    if (!goldenData)
+    {
+        result.caseMessage += "missing golden " + goldenPath + " ";
+        return false;
+    }
+
+    if ((GLuint)goldenWidth != width || (GLuint)goldenHeight != height)
+    {
+        std::ostringstream message;
+        message << "golden is " << goldenWidth << "x" << goldenHeight << " ";
+        result.caseMessage += message.str();
+
+        stbi_image_free(goldenData);
+        return false;
+    }
+
+    double squaredError = 0.0;
+    std::vector<unsigned char> diffImage(image.size());
+
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        int difference = (int)image[i] - (int)goldenData[i];
+        squaredError += difference * difference;
+
+        // Differences amplified so small shifts are still visible in the diff image
+        diffImage[i] = (unsigned char)std::min(255, std::abs(difference) * 8);
+    }
+
+    stbi_image_free(goldenData);
+
+    double meanSquaredError = squaredError / image.size();
+    result.casePSNR = meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+
+    if (result.casePSNR < this->goldenPSNR)
+    {
+        std::string diffPath = this->goldenOutputDir + "/" + result.caseName + "_diff.png";
+        stbi_write_png(diffPath.c_str(), width, height, 3, &diffImage[0], width * 3);
+
+        result.caseMessage += "image differs (see " + diffPath + ") ";
+        return false;
+    }
+
+    return true;
+}
+
+
+bool GoldenTest::checkBudgets(GoldenResult& result)
+{
+    std::ostringstream viewName;
+    viewName << this->currentCase.caseView;
+
+    bool passed = true;
+
+    for (std::map<std::string, GLfloat>::iterator it = result.passTimes.begin(); it != result.passTimes.end(); ++it)
+    {
+        // The last matching line wins, so specific cases can override the defaults above them
+        const GoldenBudget* budget = NULL;
+
+        for (GLuint i = 0; i < this->goldenBudgets.size(); ++i)
+        {
+            const GoldenBudget& candidate = this->goldenBudgets[i];
+
+            if (candidate.budgetPass == it->first
+                && (candidate.budgetModel == "*" || candidate.budgetModel == this->currentCase.caseModel)
+                && (candidate.budgetMaterial == "*" || candidate.budgetMaterial == this->currentCase.caseMaterial)
+                && (candidate.budgetView == "*" || candidate.budgetView == viewName.str()))
+                budget = &candidate;
+        }
+
+        if (budget && it->second > budget->budgetTime * this->goldenBudgetScale)
+        {
+            char message[128];
+            std::snprintf(message, sizeof(message), "%s %.3f ms > %.3f ms ", it->first.c_str(), it->second, budget->budgetTime * this->goldenBudgetScale);
+            result.caseMessage += message;
+
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+
+bool GoldenTest::writeReport()
+{
+    GLuint failedCases = 0;
+    std::vector<std::string> passNames;
+
+    for (GLuint i = 0; i < this->goldenResults.size(); ++i)
+    {
+        if (!this->goldenResults[i].imagePassed || !this->goldenResults[i].budgetPassed)
+            failedCases++;
+
+        for (std::map<std::string, GLfloat>::iterator it = this->goldenResults[i].passTimes.begin(); it != this->goldenResults[i].passTimes.end(); ++it)
+        {
+            if (std::find(passNames.begin(), passNames.end(), it->first) == passNames.end())
+                passNames.push_back(it->first);
+        }
+    }
+
+    std::string reportPath = this->goldenOutputDir + "/golden_report.csv";
+    std::ofstream reportFile(reportPath.c_str());
+
+    if (reportFile.is_open())
+    {
+        reportFile << "case,psnr_db,image,budget";
+        for (GLuint i = 0; i < passNames.size(); ++i)
+            reportFile << "," << passNames[i] << "_ms";
+        reportFile << "\n";
+
+        reportFile.setf(std::ios::fixed);
+        reportFile.precision(4);
+
+        for (GLuint i = 0; i < this->goldenResults.size(); ++i)
+        {
+            GoldenResult& result = this->goldenResults[i];
+
+            reportFile << result.caseName << "," << result.casePSNR << "," << (result.imagePassed ? "pass" : "fail")
+                       << "," << (result.budgetPassed ? "pass" : "fail");
+
+            for (GLuint j = 0; j < passNames.size(); ++j)
+                reportFile << "," << result.passTimes[passNames[j]];
+            reportFile << "\n";
+        }
+    }
+    else
+        std::cerr << "GOLDEN - FAILED WRITING REPORT : " << reportPath << std::endl;
+
+    std::cout << "GOLDEN - " << (this->goldenResults.size() - failedCases) << "/" << this->goldenResults.size()
+              << " CASES PASSED, REPORT : " << reportPath << std::endl;
+
+    return failedCases == 0;
+}
@@ -0,0 +1,72 @@
+#ifndef GOLDENTEST_H
+#define GOLDENTEST_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <glad/glad.h>
+
+
+// One rendered configuration: built-in model x sample material x G-Buffer view
+struct GoldenCase
+{
+    std::string caseName;
+    std::string caseModel, caseMaterial;
+    GLint caseView;
+};
+
+
+// "<model>/<material>/<view> <pass> <milliseconds>", '*' matching any value
+struct GoldenBudget
+{
+    std::string budgetModel, budgetMaterial, budgetView;
+    std::string budgetPass;
+    GLfloat budgetTime;
+};
+
+
+struct GoldenResult
+{
+    std::string caseName;
+    double casePSNR;
+    bool imagePassed, budgetPassed;
+    std::string caseMessage;
+    std::map<std::string, GLfloat> passTimes;   // Median time of each pass over the measured frames (ms)
+};
+
+
+// Golden-image regression harness: renders every built-in case offscreen, compares
+// it against the stored reference with a PSNR threshold and checks per-pass budgets
+class GoldenTest
+{
+    public:
+        GoldenTest();
+        ~GoldenTest();
+        static bool isGoldenOption(const std::string& arg);
+        bool setGoldenTest(int argc, char* argv[]);
+        bool isActive();
+        std::vector<GoldenCase> getCases();
+        GLuint getFrameCount();
+        GLuint getWarmupFrames();
+        void beginCase(const GoldenCase& goldenCase);
+        void recordFrame();
+        bool endCase(const std::vector<unsigned char>& pixels, GLuint width, GLuint height);
+        bool writeReport();
+
+    private:
+        bool goldenActive, goldenUpdate;
+        std::string goldenDir, goldenOutputDir, goldenFilter;
+        GLfloat goldenPSNR, goldenBudgetScale;
+        GLuint goldenFrames, goldenWarmup;
+        std::vector<GoldenBudget> goldenBudgets;
+        std::vector<GoldenResult> goldenResults;
+        GoldenCase currentCase;
+        std::map<std::string, std::vector<GLfloat> > currentTimes;
+
+        bool loadBudgets(const std::string& budgetPath);
+        bool checkBudgets(GoldenResult& result);
+        bool checkImage(GoldenResult& result, const std::vector<unsigned char>& pixels, GLuint width, GLuint height);
+};
+
+#endif
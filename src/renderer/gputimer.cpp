@@ -0,0 +1,287 @@
+#include <string>
+#include <vector>
+#include <deque>
+
+#include <glad/glad.h>
+
+#include "gputimer.h"
+
+
+// Samples nobody reads are dropped past this point, oldest first
+static const size_t maxResolvedSamples = 4096;
+
+
+GPUTimer::GPUTimer()
+{
+    this->frameCount = 0;
+    this->droppedFrames = 0;
+    this->currentSlot = 0;
+}
+
+
+GPUTimer::~GPUTimer()
+{
+
+}
+
+
+void GPUTimer::setTimer(GLuint frameLatency)
+{
+    // At least two frames in flight, otherwise every readback would have to wait
+    if (frameLatency < 2)
+        frameLatency = 2;
+
+    this->timerFrames.resize(frameLatency);
+
+    for (GLuint i = 0; i < this->timerFrames.size(); ++i)
+    {
+        this->timerFrames[i].frameIndex = 0;
+        this->timerFrames[i].pending = false;
+    }
+}
+
+
+void GPUTimer::releaseTimer()
+{
+    // The GL context is gone by the time the destructor runs, queries are freed at shutdown with
+    // the other GL objects. Resolved results stay readable, no frame can be timed afterwards.
+    for (GLuint i = 0; i < this->timerFrames.size(); ++i)
+    {
+        TimerFrame& frame = this->timerFrames[i];
+
+        if (!frame.queries.empty())
+            glDeleteQueries(frame.queries.size(), &frame.queries[0]);
+
+        frame.queries.clear();
+        frame.passIssued.clear();
+        frame.pending = false;
+    }
+
+    this->timerFrames.clear();
+}
+
+
+GLuint GPUTimer::addPass(std::string passName)
+{
+    GLuint passID = this->passNames.size();
+
+    this->passNames.push_back(passName);
+
+    TimerResult result;
+    result.startTime = 0;
+    result.stopTime = 0;
+    result.frameIndex = 0;
+    result.resolved = false;
+    this->passResults.push_back(result);
+
+    // Every frame of the ring gets its own start/stop pair for the new pass
+    for (GLuint i = 0; i < this->timerFrames.size(); ++i)
+    {
+        GLuint passQueries[2];
+        glGenQueries(2, passQueries);
+
+        this->timerFrames[i].queries.push_back(passQueries[0]);
+        this->timerFrames[i].queries.push_back(passQueries[1]);
+        this->timerFrames[i].passIssued.push_back(false);
+    }
+
+    return passID;
+}
+
+
+void GPUTimer::beginFrame()
+{
+    this->currentSlot = this->frameCount % this->timerFrames.size();
+    TimerFrame& frame = this->timerFrames[this->currentSlot];
+
+    // The slot is about to be reused: grab its results if they landed, drop them otherwise
+    if (frame.pending && !this->resolveFrame(frame))
+    {
+        frame.pending = false;
+        this->droppedFrames++;
+    }
+
+    for (GLuint i = 0; i < frame.passIssued.size(); ++i)
+        frame.passIssued[i] = false;
+}
+
+
+void GPUTimer::endFrame()
+{
+    TimerFrame& frame = this->timerFrames[this->currentSlot];
+    frame.frameIndex = this->frameCount;
+    frame.pending = true;
+
+    this->frameCount++;
+
+    this->resolveFrames();
+}
+
+
+void GPUTimer::resolveFrames()
+{
+    // Read back retired frames oldest first, stopping at the first one still in flight
+    for (GLuint i = 0; i < this->timerFrames.size(); ++i)
+    {
+        TimerFrame& oldFrame = this->timerFrames[(this->frameCount + i) % this->timerFrames.size()];
+
+        if (!oldFrame.pending)
+            continue;
+
+        if (!this->resolveFrame(oldFrame))
+            break;
+    }
+}
+
+
+void GPUTimer::beginPass(GLuint passID)
+{
+    TimerFrame& frame = this->timerFrames[this->currentSlot];
+
+    glQueryCounter(frame.queries[2 * passID], GL_TIMESTAMP);
+    frame.passIssued[passID] = true;
+}
+
+
+void GPUTimer::endPass(GLuint passID)
+{
+    glQueryCounter(this->timerFrames[this->currentSlot].queries[2 * passID + 1], GL_TIMESTAMP);
+}
+
+
+bool GPUTimer::resolveFrame(TimerFrame& frame)
+{
+    // Non-blocking check: every issued timestamp of the frame must be available
+    for (GLuint i = 0; i < frame.passIssued.size(); ++i)
+    {
+        if (!frame.passIssued[i])
+            continue;
+
+        GLint stopAvailable = 0;
+        glGetQueryObjectiv(frame.queries[2 * i + 1], GL_QUERY_RESULT_AVAILABLE, &stopAvailable);
+
+        if (!stopAvailable)
+            return false;
+    }
+
+    for (GLuint i = 0; i < frame.passIssued.size(); ++i)
+    {
+        if (!frame.passIssued[i])
+            continue;
+
+        GPUTimerSample sample;
+        sample.passID = i;
+        sample.frameIndex = frame.frameIndex;
+        glGetQueryObjectui64v(frame.queries[2 * i], GL_QUERY_RESULT, &sample.startTime);
+        glGetQueryObjectui64v(frame.queries[2 * i + 1], GL_QUERY_RESULT, &sample.stopTime);
+
+        // Several slots can retire together, each of their results is queued before the next overwrites it
+        this->resolvedSamples.push_back(sample);
+
+        if (this->resolvedSamples.size() > maxResolvedSamples)
+            this->resolvedSamples.pop_front();
+
+        // Never overwrite a newer result with an older one
+        TimerResult& result = this->passResults[i];
+
+        if (result.resolved && result.frameIndex > frame.frameIndex)
+            continue;
+
+        result.startTime = sample.startTime;
+        result.stopTime = sample.stopTime;
+        result.frameIndex = sample.frameIndex;
+        result.resolved = true;
+    }
+
+    frame.pending = false;
+
+    return true;
+}
+
+
+bool GPUTimer::isPassResolved(GLuint passID)
+{
+    return this->passResults[passID].resolved;
+}
+
+
+GLfloat GPUTimer::getPassTime(GLuint passID)
+{
+    const TimerResult& result = this->passResults[passID];
+
+    if (!result.resolved || result.stopTime < result.startTime)
+        return 0.0f;
+
+    return (result.stopTime - result.startTime) / 1000000.0;
+}
+
+
+GLuint64 GPUTimer::getPassStart(GLuint passID)
+{
+    return this->passResults[passID].startTime;
+}
+
+
+GLuint64 GPUTimer::getPassStop(GLuint passID)
+{
+    return this->passResults[passID].stopTime;
+}
+
+
+GLuint64 GPUTimer::getPassFrame(GLuint passID)
+{
+    return this->passResults[passID].frameIndex;
+}
+
+
+GLuint GPUTimer::getPassLatency(GLuint passID)
+{
+    // Number of frames between the one that issued the result and the last submitted frame
+    if (!this->passResults[passID].resolved || this->frameCount == 0)
+        return 0;
+
+    return (this->frameCount - 1) - this->passResults[passID].frameIndex;
+}
+
+
+bool GPUTimer::popSample(GPUTimerSample& sample)
+{
+    // Oldest first, frames are resolved in the order they were issued
+    if (this->resolvedSamples.empty())
+        return false;
+
+    sample = this->resolvedSamples.front();
+    this->resolvedSamples.pop_front();
+
+    return true;
+}
+
+
+std::string GPUTimer::getPassName(GLuint passID)
+{
+    return this->passNames[passID];
+}
+
+
+GLuint GPUTimer::getPassCount()
+{
+    return this->passNames.size();
+}
+
+
+GLuint GPUTimer::getFrameLatency()
+{
+    return this->timerFrames.size();
+}
+
+
+GLuint64 GPUTimer::getFrameCount()
+{
+    return this->frameCount;
+}
+
+
+GLuint64 GPUTimer::getDroppedFrames()
+{
+    return this->droppedFrames;
+}
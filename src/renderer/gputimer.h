@@ -0,0 +1,74 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+
+#include <glad/glad.h>
+
+
+// Timestamps of one pass in one frame, as read back from the query ring
+struct GPUTimerSample
+{
+    GLuint passID;
+    GLuint64 frameIndex;
+    GLuint64 startTime, stopTime;
+};
+
+
+// N-frame-deep ring of GL_TIMESTAMP queries. Results are only read back from
+// frames the GPU has already retired, so the CPU never waits on the timer.
+class GPUTimer
+{
+    public:
+        GPUTimer();
+        ~GPUTimer();
+        void setTimer(GLuint frameLatency);
+        void releaseTimer();
+        GLuint addPass(std::string passName);
+        void beginFrame();
+        void endFrame();
+        void resolveFrames();
+        void beginPass(GLuint passID);
+        void endPass(GLuint passID);
+        bool isPassResolved(GLuint passID);
+        GLfloat getPassTime(GLuint passID);
+        GLuint64 getPassStart(GLuint passID);
+        GLuint64 getPassStop(GLuint passID);
+        GLuint64 getPassFrame(GLuint passID);
+        GLuint getPassLatency(GLuint passID);
+        bool popSample(GPUTimerSample& sample);
+        std::string getPassName(GLuint passID);
+        GLuint getPassCount();
+        GLuint getFrameLatency();
+        GLuint64 getFrameCount();
+        GLuint64 getDroppedFrames();
+
+    private:
+        struct TimerFrame
+        {
+            std::vector<GLuint> queries;   // Two timestamps (start, stop) per pass
+            std::vector<bool> passIssued;
+            GLuint64 frameIndex;
+            bool pending;
+        };
+
+        struct TimerResult
+        {
+            GLuint64 startTime, stopTime;
+            GLuint64 frameIndex;
+            bool resolved;
+        };
+
+        std::vector<TimerFrame> timerFrames;
+        std::vector<TimerResult> passResults;
+        std::vector<std::string> passNames;
+        std::deque<GPUTimerSample> resolvedSamples;    // Every readback in frame order, the pass results only keep the newest
+        GLuint64 frameCount, droppedFrames;
+        GLuint currentSlot;
+
+        bool resolveFrame(TimerFrame& frame);
+};
+
+#endif
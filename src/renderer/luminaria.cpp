@@ -32,11 +32,29 @@
 #include "model.h"
 #include "shape.h"
 #include "environment.h"
+#include "profiler.h"
+#include "benchmark.h"
+#include "goldentest.h"
+#include "glstats.h"
+#include "startupreport.h"
+#include "resourceregistry.h"
+#include "texturemanager.h"
+#include "framestats.h"
+#include "uniformbuffer.h"
 
 // STB Image Implementation
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+// Storage and estimated per-frame traffic of an HDR image, next to what the float formats take
+struct HDRImageStats
+{
+    std::string imageName;
+    GLenum imageFormat, floatFormat;
+    GLuint64 imageBytes, floatBytes;
+    GLuint64 frameBytes, floatFrameBytes;
+};
+
 // Function Prototypes
 void cameraMove();
 void imGuiSetup();
@@ -44,6 +62,20 @@ void gBufferSetup();
 void saoSetup();
 void postprocessSetup();
 void iblSetup();
+void outputSetup();
+void releaseResources();
+void renderFrame();
+std::vector<std::string> getLightingDefines();
+std::vector<std::string> getPostprocessDefines();
+void runBenchmark(GLFWwindow* window);
+void applyBenchmarkEvent(const BenchmarkEvent& event);
+bool runGoldenTest(GLFWwindow* window);
+void loadModelPreset(const std::string& modelName);
+void loadMaterialPreset(const std::string& materialName);
+void loadMaterialTextures(const std::string& materialName);
+void loadEnvironment(const std::string& hdrName);
+void convertTextures();
+std::vector<HDRImageStats> getHDRImageStats();
 
 // GLFW Callbacks
 static void error_callback(int error, const char* description);
@@ -65,6 +97,9 @@ GLuint gPosition, gNormal, gAlbedo, gEffects; // G-buffer textures
 GLuint saoFBO, saoBlurFBO;                    // SAO framebuffers for ambient occlusion
 GLuint saoBuffer, saoBlurBuffer;              // SAO buffers
 GLuint postprocessFBO, postprocessBuffer;     // Post-processing framebuffer and buffer
+GLuint outputFBO = 0;                         // Final image target, the default framebuffer unless running offscreen
+GLuint outputBuffer, outputDepth;             // Offscreen color and depth attachments
+bool outputSRGB = false;                      // The output target encodes to sRGB on write, tonemapped colours stay linear
 
 // Framebuffers and Renderbuffers for environment mapping and IBL
 GLuint envToCubeFBO, irradianceFBO, prefilterFBO, brdfLUTFBO;
@@ -87,9 +122,7 @@ GLint motionBlurMaxSamples = 32;
 // Timing variables for performance measurement
 GLfloat lastX = WIDTH / 2, lastY = HEIGHT / 2;
 GLfloat deltaTime = 0.0f, lastFrame = 0.0f;
-GLfloat deltaGeometryTime = 0.0f, deltaLightingTime = 0.0f;
-GLfloat deltaSAOTime = 0.0f, deltaPostprocessTime = 0.0f;
-GLfloat deltaForwardTime = 0.0f, deltaGUITime = 0.0f;
+GLfloat sceneTime = 0.0f;                     // Animation clock, wall time interactively and fixed steps in benchmark runs
 
 // Material properties for PBR
 GLfloat materialRoughness = 0.01f;
@@ -182,14 +215,17 @@ Shader firstpassPPShader;     // Shader for first pass of post-processing effect
 Shader saoShader;             // Shader for Screen Space Ambient Occlusion (SSAO)
 Shader saoBlurShader;         // Shader for blurring SSAO results
 
-// Textures
-Texture objectAlbedo;          // Albedo texture for the object
-Texture objectNormal;          // Normal map texture for the object
-Texture objectRoughness;       // Roughness texture for the object
-Texture objectMetalness;       // Metalness texture for the object
-Texture objectAO;              // Ambient occlusion texture for the object
+// Uniform buffers shared by the shaders above
+UniformBuffer frameUBO;       // Camera, exposure and motion blur
+UniformBuffer saoUBO;         // SAO pass parameters
+
+// Textures, file textures are shared through the texture cache
+TextureHandle objectAlbedo;    // Albedo texture for the object
+TextureHandle objectNormal;    // Normal map texture for the object
+TextureHandle objectAO;        // Ambient occlusion texture for the object
+TextureHandle objectRoughMetal; // Packed roughness and metalness texture for the object
 
-Texture envMapHDR;             // High Dynamic Range environment map texture
+TextureHandle envMapHDR;       // High Dynamic Range environment map texture
 Texture envMapCube;            // Cubemap environment map texture
 Texture envMapIrradiance;      // Irradiance environment map texture
 Texture envMapPrefilter;       // Prefiltered environment map texture
@@ -211,36 +247,79 @@ Light lightDirectional1;      // Directional light source
 Shape quadRender;             // Quad shape for screen-space rendering
 Shape envCubeRender;          // Cubic shape for environment map rendering
 
+// Profiling
+const GLuint gpuTimerLatency = 4;  // Frames kept in flight before a GPU timer slot is reused
+const char* profilerTracePath = "luminaria_trace.json";
+
+// Benchmark and golden-image harness
+Benchmark benchmark;
+GoldenTest goldenTest;
+
 
 // MAIN FUNCTION BEGINS HERE
 
 int main(int argc, char* argv[])
 {
+    // Everything up to the first presented frame counts towards the startup report
+    StartupReport::beginStartup();
+
+    // Command-line options (--bench and its settings)
+    if (!benchmark.setBenchmark(argc, argv) || !goldenTest.setGoldenTest(argc, argv) || !StartupReport::setStartupReport(argc, argv)
+        || !FrameStats::setFrameStats(argc, argv) || !Shader::setShaderOptions(argc, argv) || !TextureManager::setTextureOptions(argc, argv)
+        || !Model::setModelOptions(argc, argv))
+        return 1;
+
+    bool headless = benchmark.isActive() || goldenTest.isActive() || TextureManager::isConvertRequested();
+
     // Initialize GLFW and configure OpenGL context
+    StartupReport::beginPhase("Context", "GLFW", false);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);   // Use OpenGL version 4.0
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);  // Use core profile
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);        // Disable window resizing
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GL_TRUE);      // Let the default framebuffer do the final sRGB encoding
 
-    // Get monitor properties for fullscreen setup
-    GLFWmonitor* glfwMonitor = glfwGetPrimaryMonitor();                 // Get primary monitor
-    const GLFWvidmode* glfwMode = glfwGetVideoMode(glfwMonitor);        // Get video mode details
+    GLFWwindow* window = NULL;
 
-    // Set window properties to match monitor video mode (fullscreen)
-    glfwWindowHint(GLFW_RED_BITS, glfwMode->redBits);
-    glfwWindowHint(GLFW_GREEN_BITS, glfwMode->greenBits);
-    glfwWindowHint(GLFW_BLUE_BITS, glfwMode->blueBits);
-    glfwWindowHint(GLFW_REFRESH_RATE, glfwMode->refreshRate);
+    if (headless)
+    {
+        // Benchmark runs render offscreen at a fixed resolution, the window only carries the context
+        WIDTH = benchmark.getWidth();
+        HEIGHT = benchmark.getHeight();
 
-    // Set window width and height to match the monitor
-    WIDTH = glfwMode->width;
-    HEIGHT = glfwMode->height;
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+        window = glfwCreateWindow(WIDTH, HEIGHT, "GLEngine", NULL, NULL);
+    }
+    else
+    {
+        // Get monitor properties for fullscreen setup
+        GLFWmonitor* glfwMonitor = glfwGetPrimaryMonitor();                 // Get primary monitor
+        const GLFWvidmode* glfwMode = glfwGetVideoMode(glfwMonitor);        // Get video mode details
+
+        // Set window properties to match monitor video mode (fullscreen)
+        glfwWindowHint(GLFW_RED_BITS, glfwMode->redBits);
+        glfwWindowHint(GLFW_GREEN_BITS, glfwMode->greenBits);
+        glfwWindowHint(GLFW_BLUE_BITS, glfwMode->blueBits);
+        glfwWindowHint(GLFW_REFRESH_RATE, glfwMode->refreshRate);
+
+        // Set window width and height to match the monitor
+        WIDTH = glfwMode->width;
+        HEIGHT = glfwMode->height;
+
+        // Create a fullscreen window on the primary monitor
+        window = glfwCreateWindow(WIDTH, HEIGHT, "GLEngine", glfwMonitor, NULL);
+        // Alternatively, to run in windowed mode, uncomment the line below and comment the above line
+        // window = glfwCreateWindow(WIDTH, HEIGHT, "GLEngine", nullptr, nullptr);
+    }
 
-    // Create a fullscreen window on the primary monitor
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "GLEngine", glfwMonitor, NULL);
-    // Alternatively, to run in windowed mode, uncomment the line below and comment the above line
-    // GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "GLEngine", nullptr, nullptr);
+    if (window == NULL)
+    {
+        StartupReport::endPhase();
+        std::cerr << "ERROR::GLFW::WINDOW_CREATION_FAILED" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
 
     // Set the current OpenGL context to the created window
     glfwMakeContextCurrent(window);
@@ -253,6 +332,30 @@ int main(int argc, char* argv[])
 
     // Load all OpenGL function pointers using GLAD
     gladLoadGL();
+    StartupReport::endPhase();
+
+    // Offscreen runs render to an sRGB texture, a window only when the driver gave it an sRGB back buffer
+    GLint outputEncoding = GL_LINEAR;
+
+    if (!headless)
+        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_BACK_LEFT, GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING, &outputEncoding);
+
+    outputSRGB = headless || outputEncoding == GL_SRGB;
+
+    // Converting ahead of time only needs the context, for the compressed formats the driver takes
+    if (TextureManager::isConvertRequested())
+    {
+        convertTextures();
+        glfwTerminate();
+        return 0;
+    }
+
+    // Start the profiler clock before anything gets loaded
+    Profiler::setProfiler(gpuTimerLatency);
+
+    // GL call counting, also available from the Debug Info panel
+    if (benchmark.isGLStatsEnabled())
+        GLStats::setEnabled(true);
 
     // Set viewport size
     glViewport(0, 0, WIDTH, HEIGHT);
@@ -271,8 +374,15 @@ int main(int argc, char* argv[])
     glfwSetMouseButtonCallback(window, mouse_button_callback);// Mouse button callback
     glfwSetScrollCallback(window, scroll_callback);           // Scroll input callback
 
+    // Texture loader threads, the material textures below stream in while the rest of the scene is set up
+    TextureManager::startLoading();
+
     //Shaders
     // 
+    // Compiles and links are only submitted here, each program is waited on at its first
+    // useShader() once the textures and the model below have been loaded
+    Shader::setParallelCompile();
+
     // G-buffer shader for deferred rendering
     gBufferShader.setShader("resources/shaders/gBuffer.vert", "resources/shaders/gBuffer.frag");
 
@@ -281,34 +391,37 @@ int main(int argc, char* argv[])
 
     // Lighting shaders for various BRDF techniques and IBL (Image-Based Lighting)
     simpleShader.setShader("resources/shaders/lighting/simple.vert", "resources/shaders/lighting/simple.frag");
-    lightingBRDFShader.setShader("resources/shaders/lighting/lightingBRDF.vert", "resources/shaders/lighting/lightingBRDF.frag");
+    lightingBRDFShader.setShader("resources/shaders/lighting/lightingBRDF.vert", "resources/shaders/lighting/lightingBRDF.frag", getLightingDefines());
     irradianceIBLShader.setShader("resources/shaders/lighting/irradianceIBL.vert", "resources/shaders/lighting/irradianceIBL.frag");
     prefilterIBLShader.setShader("resources/shaders/lighting/prefilterIBL.vert", "resources/shaders/lighting/prefilterIBL.frag");
     integrateIBLShader.setShader("resources/shaders/lighting/integrateIBL.vert", "resources/shaders/lighting/integrateIBL.frag");
 
     // Post-processing shaders for effects like SAO (Screen-Space Ambient Occlusion)
-    firstpassPPShader.setShader("resources/shaders/postprocess/postprocess.vert", "resources/shaders/postprocess/firstpass.frag");
+    firstpassPPShader.setShader("resources/shaders/postprocess/postprocess.vert", "resources/shaders/postprocess/firstpass.frag", getPostprocessDefines());
     saoShader.setShader("resources/shaders/postprocess/sao.vert", "resources/shaders/postprocess/sao.frag");
     saoBlurShader.setShader("resources/shaders/postprocess/sao.vert", "resources/shaders/postprocess/saoBlur.frag");
 
+    // Uniform blocks shared by the programs, each stays bound at its fixed binding point
+    frameUBO.setUniformBuffer("FrameData", UNIFORM_BLOCK_FRAME, sizeof(FrameUniforms));
+    saoUBO.setUniformBuffer("SAOData", UNIFORM_BLOCK_SAO, sizeof(SAOUniforms));
+
     // Textures
 
     // Load PBR textures (Albedo, Normal, Roughness, Metalness, and AO) for the object
-    objectAlbedo.setTexture("resources/textures/pbr/quartz/quartz_albedo.png", "statueAlbedo", true);
-    objectNormal.setTexture("resources/textures/pbr/quartz/quartz_normal.png", "statueNormal", true);
-    objectRoughness.setTexture("resources/textures/pbr/quartz/quartz_roughness.png", "statueRoughness", true);
-    objectMetalness.setTexture("resources/textures/pbr/quartz/quartz_metalness.png", "statueMetalness", true);
-    objectAO.setTexture("resources/textures/pbr/quartz/quartz_ao.png", "statueAO", true);
+    loadMaterialTextures("quartz");
 
     // Load HDR environment map (used for IBL)
-    envMapHDR.setTextureHDR("resources/textures/hdr/studio1.hdr", "ensuiteHDR", true);
+    envMapHDR = TextureManager::getTextureHDR("resources/textures/hdr/studio1.hdr", "ensuiteHDR", true);
 
     // Set up cube maps for environment reflection and IBL
-    envMapCube.setTextureCube(512, GL_RGB, GL_RGB16F, GL_FLOAT, GL_LINEAR_MIPMAP_LINEAR);   // Cube map for reflections
-    envMapIrradiance.setTextureCube(32, GL_RGB, GL_RGB16F, GL_FLOAT, GL_LINEAR);            // Irradiance map for diffuse lighting
-    envMapPrefilter.setTextureCube(128, GL_RGB, GL_RGB16F, GL_FLOAT, GL_LINEAR_MIPMAP_LINEAR); // Prefiltered environment map for specular lighting
+    ResourceRegistry::beginOwner("IBL");
+    GLenum cubeFormat = TextureCompressor::getHDRTargetFormat(GL_RGB16F);
+    envMapCube.setTextureCube(512, GL_RGB, cubeFormat, GL_FLOAT, GL_LINEAR_MIPMAP_LINEAR);  // Cube map for reflections
+    envMapIrradiance.setTextureCube(32, GL_RGB, cubeFormat, GL_FLOAT, GL_LINEAR);           // Irradiance map for diffuse lighting
+    envMapPrefilter.setTextureCube(128, GL_RGB, cubeFormat, GL_FLOAT, GL_LINEAR_MIPMAP_LINEAR); // Prefiltered environment map for specular lighting
     envMapPrefilter.computeTexMipmap();                                                     // Generate mipmaps for the prefiltered map
     envMapLUT.setTextureHDR(512, 512, GL_RG, GL_RG16F, GL_FLOAT, GL_LINEAR);                 // BRDF LUT for specular IBL
+    ResourceRegistry::endOwner();
 
 
     // Model
@@ -329,47 +442,53 @@ int main(int argc, char* argv[])
     lightDirectional1.setLight(lightDirectionalDirection1, glm::vec4(lightDirectionalColor1, 1.0f));
 
     lightingBRDFShader.useShader();
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "gPosition"), 0);
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "gAlbedo"), 1);
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "gNormal"), 2);
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "gEffects"), 3);
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "sao"), 4);
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "envMap"), 5);
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "envMapIrradiance"), 6);
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "envMapPrefilter"), 7);
-    glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "envMapLUT"), 8);
+    lightingBRDFShader.setInt("gPosition", 0);
+    lightingBRDFShader.setInt("gAlbedo", 1);
+    lightingBRDFShader.setInt("gNormal", 2);
+    lightingBRDFShader.setInt("gEffects", 3);
+    lightingBRDFShader.setInt("sao", 4);
+    lightingBRDFShader.setInt("envMap", 5);
+    lightingBRDFShader.setInt("envMapIrradiance", 6);
+    lightingBRDFShader.setInt("envMapPrefilter", 7);
+    lightingBRDFShader.setInt("envMapLUT", 8);
 
     saoShader.useShader();
-    glUniform1i(glGetUniformLocation(saoShader.Program, "gPosition"), 0);
-    glUniform1i(glGetUniformLocation(saoShader.Program, "gNormal"), 1);
+    saoShader.setInt("gPosition", 0);
+    saoShader.setInt("gNormal", 1);
 
     firstpassPPShader.useShader();
-    glUniform1i(glGetUniformLocation(firstpassPPShader.Program, "sao"), 1);
-    glUniform1i(glGetUniformLocation(firstpassPPShader.Program, "gEffects"), 2);
+    firstpassPPShader.setInt("sao", 1);
+    firstpassPPShader.setInt("gEffects", 2);
 
     latlongToCubeShader.useShader();
-    glUniform1i(glGetUniformLocation(latlongToCubeShader.Program, "envMap"), 0);
+    latlongToCubeShader.setInt("envMap", 0);
 
     irradianceIBLShader.useShader();
-    glUniform1i(glGetUniformLocation(irradianceIBLShader.Program, "envMap"), 0);
+    irradianceIBLShader.setInt("envMap", 0);
 
     prefilterIBLShader.useShader();
-    glUniform1i(glGetUniformLocation(prefilterIBLShader.Program, "envMap"), 0);
+    prefilterIBLShader.setInt("envMap", 0);
 
     // G-Buffer setup
 
+    StartupReport::beginPhase("Render Targets", "G-Buffer", false);
     gBufferSetup();
+    StartupReport::endPhase();
 
 
 
     // SAO setup
 
+    StartupReport::beginPhase("Render Targets", "SAO", false);
     saoSetup();
+    StartupReport::endPhase();
 
 
     // Postprocessing setup
 
+    StartupReport::beginPhase("Render Targets", "Postprocess", false);
     postprocessSetup();
+    StartupReport::endPhase();
 
 
 
@@ -378,27 +497,30 @@ int main(int argc, char* argv[])
     iblSetup();
 
 
-    // Queries setting for profiling
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
 
-    GLuint64 startGeometryTime, startLightingTime, startSAOTime, startPostprocessTime, startForwardTime, startGUITime;
-    GLuint64 stopGeometryTime, stopLightingTime, stopSAOTime, stopPostprocessTime, stopForwardTime, stopGUITime;
+    // Headless golden-image or benchmark run, replaces the interactive loop
 
-    unsigned int queryIDGeometry[2];
-    unsigned int queryIDLighting[2];
-    unsigned int queryIDSAO[2];
-    unsigned int queryIDPostprocess[2];
-    unsigned int queryIDForward[2];
-    unsigned int queryIDGUI[2];
+    if (headless)
+    {
+        outputSetup();
 
-    glGenQueries(2, queryIDGeometry);
-    glGenQueries(2, queryIDLighting);
-    glGenQueries(2, queryIDSAO);
-    glGenQueries(2, queryIDPostprocess);
-    glGenQueries(2, queryIDForward);
-    glGenQueries(2, queryIDGUI);
+        bool headlessPassed = true;
 
+        if (goldenTest.isActive())
+            headlessPassed = runGoldenTest(window);
+        else
+            runBenchmark(window);
 
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        releaseResources();
+        ResourceRegistry::reportLeaks();
+
+        ImGui_ImplGlfwGL3_Shutdown();
+        glfwTerminate();
+
+        return headlessPassed && StartupReport::isWithinBudget() ? 0 : 1;
+    }
 
 
     while (!glfwWindowShouldClose(window))
@@ -406,315 +528,605 @@ int main(int argc, char* argv[])
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        sceneTime = currentFrame;
 
         glfwPollEvents();
         cameraMove();
 
+        Profiler::beginFrame();
+
         // ImGui setup
 
+        Profiler::beginZone("ImGui Setup", false);
         imGuiSetup();
+        Profiler::endZone();
 
-        // Geometry Pass rendering
+        // Scene rendering
+
+        renderFrame();
 
-        glQueryCounter(queryIDGeometry[0], GL_TIMESTAMP);
-        glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Camera setting
-        glm::mat4 projection = glm::perspective(camera.cameraFOV, (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 model;
+        // ImGui rendering
+
+        Profiler::beginZone("GUI", true);
+        ImGui::Render();
+        Profiler::endZone();
+
+        // Profiling (GPU zones are read back from retired frames only, never waits on the GPU)
+
+        Profiler::endFrame();
+
+        glfwSwapBuffers(window);
 
-        // Model(s) rendering
-        gBufferShader.useShader();
+        // Time to first frame, over budget is only reported when running interactively
+        StartupReport::endStartup();
+        FrameStats::recordFrame();
+    }
 
-        glUniformMatrix4fv(glGetUniformLocation(gBufferShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(gBufferShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    releaseResources();
+    ResourceRegistry::reportLeaks();
 
-        GLfloat rotationAngle = glfwGetTime() / 5.0f * modelRotationSpeed;
-        model = glm::mat4();
-        model = glm::translate(model, modelPosition);
-        model = glm::rotate(model, rotationAngle, modelRotationAxis);
-        model = glm::scale(model, modelScale);
+    ImGui_ImplGlfwGL3_Shutdown();
+    glfwTerminate();
 
-        projViewModel = projection * view * model;
+    return 0;
+}
 
-        glUniformMatrix4fv(glGetUniformLocation(gBufferShader.Program, "projViewModel"), 1, GL_FALSE, glm::value_ptr(projViewModel));
-        glUniformMatrix4fv(glGetUniformLocation(gBufferShader.Program, "prevProjViewModel"), 1, GL_FALSE, glm::value_ptr(prevProjViewModel));
-        glUniformMatrix4fv(glGetUniformLocation(gBufferShader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniform3f(glGetUniformLocation(gBufferShader.Program, "albedoColor"), albedoColor.r, albedoColor.g, albedoColor.b);
 
-        // Material
-        // pbrMat.renderToShader();
+
+void renderFrame()
+{
+    // Texture streaming, whatever the loader threads finished since the last frame is uploaded
+
+    Profiler::beginZone("Texture Streaming", false);
+    TextureManager::pumpTextures();
+    Profiler::endZone();
+
+    // Geometry Pass rendering
+
+    Profiler::beginZone("Geometry", true);
+    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Camera setting
+    glm::mat4 projection = glm::perspective(camera.cameraFOV, (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 model;
+
+    // ImGui only averages the framerate when it runs, scripted runs use their fixed time step
+    GLfloat frameRate = (benchmark.isActive() || goldenTest.isActive()) ? 1.0f / deltaTime : ImGui::GetIO().Framerate;
+
+    // Per-frame uniforms, uploaded once and read by every program through the shared blocks
+    FrameUniforms frameUniforms;
+    frameUniforms.view = view;
+    frameUniforms.projection = projection;
+    frameUniforms.inverseView = glm::transpose(view);
+    frameUniforms.inverseProj = glm::inverse(projection);
+    frameUniforms.viewportSize = glm::vec2(WIDTH, HEIGHT);
+    frameUniforms.texelSize = glm::vec2(1.0f / WIDTH, 1.0f / HEIGHT);
+    frameUniforms.cameraAperture = cameraAperture;
+    frameUniforms.cameraShutterSpeed = cameraShutterSpeed;
+    frameUniforms.cameraISO = cameraISO;
+    frameUniforms.motionBlurScale = int(frameRate) / 60.0f;
+    frameUniforms.motionBlurMaxSamples = motionBlurMaxSamples;
+    frameUBO.updateUniformBuffer(&frameUniforms);
+
+    // Model(s) rendering
+    gBufferShader.useShader();
+
+    GLfloat rotationAngle = sceneTime / 5.0f * modelRotationSpeed;
+    model = glm::mat4();
+    model = glm::translate(model, modelPosition);
+    model = glm::rotate(model, rotationAngle, modelRotationAxis);
+    model = glm::scale(model, modelScale);
+
+    projViewModel = projection * view * model;
+
+    gBufferShader.setMat4("projViewModel", projViewModel);
+    gBufferShader.setMat4("prevProjViewModel", prevProjViewModel);
+    gBufferShader.setMat4("model", model);
+    gBufferShader.setVec3("albedoColor", albedoColor);
+
+    // Material
+    // pbrMat.renderToShader();
+
+    glActiveTexture(GL_TEXTURE0);
+    objectAlbedo->useTexture();
+    gBufferShader.setInt("texAlbedo", 0);
+    glActiveTexture(GL_TEXTURE1);
+    objectNormal->useTexture();
+    gBufferShader.setInt("texNormal", 1);
+    glActiveTexture(GL_TEXTURE2);
+    objectAO->useTexture();
+    gBufferShader.setInt("texAO", 2);
+    glActiveTexture(GL_TEXTURE3);
+    objectRoughMetal->useTexture();
+    gBufferShader.setInt("texRoughMetal", 3);
+
+    // Levels of detail follow the projected size of the model
+    objectModel.selectLods(model, camera.cameraPosition, camera.cameraFOV, HEIGHT);
+
+    // Linear albedo is encoded into the sRGB attachment, the other targets are not affected
+    glEnable(GL_FRAMEBUFFER_SRGB);
+    objectModel.Draw();
+    glDisable(GL_FRAMEBUFFER_SRGB);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Profiler::endZone();
+
+    prevProjViewModel = projViewModel;
+
+
+    // SAO
+
+    Profiler::beginZone("SAO", true);
+    glBindFramebuffer(GL_FRAMEBUFFER, saoFBO);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (saoMode)
+    {
+        // SAO noisy texture
+        saoShader.useShader();
 
         glActiveTexture(GL_TEXTURE0);
-        objectAlbedo.useTexture();
-        glUniform1i(glGetUniformLocation(gBufferShader.Program, "texAlbedo"), 0);
+        glBindTexture(GL_TEXTURE_2D, gPosition);
         glActiveTexture(GL_TEXTURE1);
-        objectNormal.useTexture();
-        glUniform1i(glGetUniformLocation(gBufferShader.Program, "texNormal"), 1);
-        glActiveTexture(GL_TEXTURE2);
-        objectRoughness.useTexture();
-        glUniform1i(glGetUniformLocation(gBufferShader.Program, "texRoughness"), 2);
-        glActiveTexture(GL_TEXTURE3);
-        objectMetalness.useTexture();
-        glUniform1i(glGetUniformLocation(gBufferShader.Program, "texMetalness"), 3);
-        glActiveTexture(GL_TEXTURE4);
-        objectAO.useTexture();
-        glUniform1i(glGetUniformLocation(gBufferShader.Program, "texAO"), 4);
-
-        objectModel.Draw();
+        glBindTexture(GL_TEXTURE_2D, gNormal);
+
+        SAOUniforms saoUniforms = SAOUniforms();
+        saoUniforms.saoSamples = saoSamples;
+        saoUniforms.saoTurns = saoTurns;
+        saoUniforms.saoRadius = saoRadius;
+        saoUniforms.saoBias = saoBias;
+        saoUniforms.saoScale = saoScale;
+        saoUniforms.saoContrast = saoContrast;
+        saoUBO.updateUniformBuffer(&saoUniforms);
+
+        quadRender.drawShape();
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glQueryCounter(queryIDGeometry[1], GL_TIMESTAMP);
 
-        prevProjViewModel = projViewModel;
+        // SAO blur pass
+        glBindFramebuffer(GL_FRAMEBUFFER, saoBlurFBO);
+        glClear(GL_COLOR_BUFFER_BIT);
 
+        saoBlurShader.useShader();
 
-        // SAO
+        saoBlurShader.setInt("saoBlurSize", saoBlurSize);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, saoBuffer);
 
-        glQueryCounter(queryIDSAO[0], GL_TIMESTAMP);
-        glBindFramebuffer(GL_FRAMEBUFFER, saoFBO);
-        glClear(GL_COLOR_BUFFER_BIT);
+        quadRender.drawShape();
+    }
 
-        if (saoMode)
-        {
-            // SAO noisy texture
-            saoShader.useShader();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Profiler::endZone();
 
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, gPosition);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, gNormal);
 
-            glUniform1i(glGetUniformLocation(saoShader.Program, "saoSamples"), saoSamples);
-            glUniform1f(glGetUniformLocation(saoShader.Program, "saoRadius"), saoRadius);
-            glUniform1i(glGetUniformLocation(saoShader.Program, "saoTurns"), saoTurns);
-            glUniform1f(glGetUniformLocation(saoShader.Program, "saoBias"), saoBias);
-            glUniform1f(glGetUniformLocation(saoShader.Program, "saoScale"), saoScale);
-            glUniform1f(glGetUniformLocation(saoShader.Program, "saoContrast"), saoContrast);
-            glUniform1i(glGetUniformLocation(saoShader.Program, "viewportWidth"), WIDTH);
-            glUniform1i(glGetUniformLocation(saoShader.Program, "viewportHeight"), HEIGHT);
+    // Lighting Pass rendering
 
-            quadRender.drawShape();
+    Profiler::beginZone("Lighting", true);
+    glBindFramebuffer(GL_FRAMEBUFFER, postprocessFBO);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    lightingBRDFShader.setVariant(getLightingDefines());
+    lightingBRDFShader.useShader();
 
-            // SAO blur pass
-            glBindFramebuffer(GL_FRAMEBUFFER, saoBlurFBO);
-            glClear(GL_COLOR_BUFFER_BIT);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, gPosition);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, gAlbedo);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, gNormal);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, gEffects);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, saoBlurBuffer);
+    glActiveTexture(GL_TEXTURE5);
+    envMapHDR->useTexture();
+    glActiveTexture(GL_TEXTURE6);
+    envMapIrradiance.useTexture();
+    glActiveTexture(GL_TEXTURE7);
+    envMapPrefilter.useTexture();
+    glActiveTexture(GL_TEXTURE8);
+    envMapLUT.useTexture();
 
-            saoBlurShader.useShader();
+    lightPoint1.setLightPosition(lightPointPosition1);
+    lightPoint2.setLightPosition(lightPointPosition2);
+    lightPoint3.setLightPosition(lightPointPosition3);
 
-            glUniform1i(glGetUniformLocation(saoBlurShader.Program, "saoBlurSize"), saoBlurSize);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, saoBuffer);
 
-            quadRender.drawShape();
-        }
+    // Define brightness factor
+    const float brightnessFactor = 10.0f; // Increase this factor to make the light even brighter
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glQueryCounter(queryIDSAO[1], GL_TIMESTAMP);
+    // Set light colors with increased brightness
+    lightPoint1.setLightColor(glm::vec4(lightPointColor1 * brightnessFactor, 1.0f)); // Adjusting light color brightness
+    lightPoint2.setLightColor(glm::vec4(lightPointColor2 * brightnessFactor, 1.0f)); // Adjusting light color brightness
+    lightPoint3.setLightColor(glm::vec4(lightPointColor3 * brightnessFactor, 1.0f)); // Adjusting light color brightness
 
 
-        // Lighting Pass rendering
 
-        glQueryCounter(queryIDLighting[0], GL_TIMESTAMP);
-        glBindFramebuffer(GL_FRAMEBUFFER, postprocessFBO);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    lightPoint1.setLightRadius(lightPointRadius1);
+    lightPoint2.setLightRadius(lightPointRadius2);
+    lightPoint3.setLightRadius(lightPointRadius3);
 
-        lightingBRDFShader.useShader();
+    for (int i = 0; i < Light::lightPointList.size(); i++)
+    {
+        Light::lightPointList[i].renderToShader(lightingBRDFShader, camera);
+    }
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, gPosition);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, gAlbedo);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gNormal);
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, gEffects);
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, saoBlurBuffer);
-        glActiveTexture(GL_TEXTURE5);
-        envMapHDR.useTexture();
-        glActiveTexture(GL_TEXTURE6);
-        envMapIrradiance.useTexture();
-        glActiveTexture(GL_TEXTURE7);
-        envMapPrefilter.useTexture();
-        glActiveTexture(GL_TEXTURE8);
-        envMapLUT.useTexture();
+    lightDirectional1.setLightDirection(lightDirectionalDirection1);
+
+    const float brightnessFactor2 = 2.0f; // Increase this factor to make the light even brighter
+
+    // Set the directional light color with increased brightness
+    lightDirectional1.setLightColor(glm::vec4(lightDirectionalColor1 * brightnessFactor2, 1.0f));
+
+    for (int i = 0; i < Light::lightDirectionalList.size(); i++)
+    {
+        Light::lightDirectionalList[i].renderToShader(lightingBRDFShader, camera);
+    }
+
+    lightingBRDFShader.setFloat("materialRoughness", materialRoughness);
+    lightingBRDFShader.setFloat("materialMetallicity", materialMetallicity);
+    lightingBRDFShader.setVec3("materialF0", materialF0);
+    lightingBRDFShader.setFloat("ambientIntensity", ambientIntensity);
+
+    quadRender.drawShape();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Profiler::endZone();
+
+    // Post-processing Pass rendering
+
+    Profiler::beginZone("Postprocess", true);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    firstpassPPShader.setVariant(getPostprocessDefines());
+    firstpassPPShader.useShader();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, postprocessBuffer);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, saoBlurBuffer);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, gEffects);
+
+    // Filmic tonemapping bakes its own gamma in and the data views show raw values, neither is encoded.
+    // The albedo view holds colours, it is encoded like the final image
+    bool encodeOutput = outputSRGB && (gBufferView == 1 ? tonemappingMode != 2 : gBufferView == 4);
+
+    if (encodeOutput)
+        glEnable(GL_FRAMEBUFFER_SRGB);
+
+    quadRender.drawShape();
 
-        lightPoint1.setLightPosition(lightPointPosition1);
-        lightPoint2.setLightPosition(lightPointPosition2);
-        lightPoint3.setLightPosition(lightPointPosition3);
+    if (encodeOutput)
+        glDisable(GL_FRAMEBUFFER_SRGB);
 
+    Profiler::endZone();
 
-        // Define brightness factor
-        const float brightnessFactor = 10.0f; // Increase this factor to make the light even brighter
 
-        // Set light colors with increased brightness
-        lightPoint1.setLightColor(glm::vec4(lightPointColor1 * brightnessFactor, 1.0f)); // Adjusting light color brightness
-        lightPoint2.setLightColor(glm::vec4(lightPointColor2 * brightnessFactor, 1.0f)); // Adjusting light color brightness
-        lightPoint3.setLightColor(glm::vec4(lightPointColor3 * brightnessFactor, 1.0f)); // Adjusting light color brightness
 
+    // Forward Pass rendering
 
+    Profiler::beginZone("Forward", true);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFBO);
 
-        lightPoint1.setLightRadius(lightPointRadius1);
-        lightPoint2.setLightRadius(lightPointRadius2);
-        lightPoint3.setLightRadius(lightPointRadius3);
+    // Copy the depth informations from the Geometry Pass into the output framebuffer
+    glBlitFramebuffer(0, 0, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+
+    // Shape(s) rendering
+    if (pointMode)
+    {
+        simpleShader.useShader();
 
         for (int i = 0; i < Light::lightPointList.size(); i++)
         {
-            Light::lightPointList[i].renderToShader(lightingBRDFShader, camera);
+            simpleShader.setVec4("lightColor", Light::lightPointList[i].getLightColor());
+
+            if (Light::lightPointList[i].isMesh())
+                Light::lightPointList[i].lightMesh.drawShape(simpleShader);
         }
+    }
+    Profiler::endZone();
+}
 
-        lightDirectional1.setLightDirection(lightDirectionalDirection1);
 
-        const float brightnessFactor2 = 2.0f; // Increase this factor to make the light even brighter
+// Feature defines of the lighting variant matching the GUI toggles
+std::vector<std::string> getLightingDefines()
+{
+    std::vector<std::string> defines;
 
-        // Set the directional light color with increased brightness
-        lightDirectional1.setLightColor(glm::vec4(lightDirectionalColor1 * brightnessFactor2, 1.0f));
+    // Buffer views skip lighting entirely, the toggles would only multiply identical variants
+    if (gBufferView != 1)
+    {
+        defines.push_back("GBUFFER_VIEW " + std::to_string(gBufferView));
+        return defines;
+    }
 
-        for (int i = 0; i < Light::lightDirectionalList.size(); i++)
-        {
-            Light::lightDirectionalList[i].renderToShader(lightingBRDFShader, camera);
-        }
+    if (pointMode)
+    {
+        defines.push_back("POINT_LIGHTS");
+        defines.push_back("ATTENUATION_MODE " + std::to_string(attenuationMode));
+    }
+    if (directionalMode)
+        defines.push_back("DIRECTIONAL_LIGHTS");
+    if (iblMode)
+        defines.push_back("IBL");
 
-        glUniformMatrix4fv(glGetUniformLocation(lightingBRDFShader.Program, "inverseView"), 1, GL_FALSE, glm::value_ptr(glm::transpose(view)));
-        glUniformMatrix4fv(glGetUniformLocation(lightingBRDFShader.Program, "inverseProj"), 1, GL_FALSE, glm::value_ptr(glm::inverse(projection)));
-        glUniformMatrix4fv(glGetUniformLocation(lightingBRDFShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniform1f(glGetUniformLocation(lightingBRDFShader.Program, "materialRoughness"), materialRoughness);
-        glUniform1f(glGetUniformLocation(lightingBRDFShader.Program, "materialMetallicity"), materialMetallicity);
-        glUniform3f(glGetUniformLocation(lightingBRDFShader.Program, "materialF0"), materialF0.r, materialF0.g, materialF0.b);
-        glUniform1f(glGetUniformLocation(lightingBRDFShader.Program, "ambientIntensity"), ambientIntensity);
-        glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "gBufferView"), gBufferView);
-        glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "pointMode"), pointMode);
-        glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "directionalMode"), directionalMode);
-        glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "iblMode"), iblMode);
-        glUniform1i(glGetUniformLocation(lightingBRDFShader.Program, "attenuationMode"), attenuationMode);
+    return defines;
+}
 
-        quadRender.drawShape();
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glQueryCounter(queryIDLighting[1], GL_TIMESTAMP);
+// Feature defines of the post-processing variant matching the GUI toggles
+std::vector<std::string> getPostprocessDefines()
+{
+    std::vector<std::string> defines;
 
-        // Post-processing Pass rendering
+    if (gBufferView != 1)
+    {
+        defines.push_back("DEBUG_VIEW");
 
-        glQueryCounter(queryIDPostprocess[0], GL_TIMESTAMP);
-        glClear(GL_COLOR_BUFFER_BIT);
+        if (gBufferView == 4)
+            defines.push_back("COLOR_VIEW");
+        if (gBufferView == 4 && outputSRGB)
+            defines.push_back("SRGB_FRAMEBUFFER");
 
-        firstpassPPShader.useShader();
-        glUniform1i(glGetUniformLocation(firstpassPPShader.Program, "gBufferView"), gBufferView);
-        glUniform2f(glGetUniformLocation(firstpassPPShader.Program, "screenTextureSize"), 1.0f / WIDTH, 1.0f / HEIGHT);
-        glUniform1f(glGetUniformLocation(firstpassPPShader.Program, "cameraAperture"), cameraAperture);
-        glUniform1f(glGetUniformLocation(firstpassPPShader.Program, "cameraShutterSpeed"), cameraShutterSpeed);
-        glUniform1f(glGetUniformLocation(firstpassPPShader.Program, "cameraISO"), cameraISO);
-        glUniform1i(glGetUniformLocation(firstpassPPShader.Program, "saoMode"), saoMode);
-        glUniform1i(glGetUniformLocation(firstpassPPShader.Program, "fxaaMode"), fxaaMode);
-        glUniform1i(glGetUniformLocation(firstpassPPShader.Program, "motionBlurMode"), motionBlurMode);
-        glUniform1f(glGetUniformLocation(firstpassPPShader.Program, "motionBlurScale"), int(ImGui::GetIO().Framerate) / 60.0f);
-        glUniform1i(glGetUniformLocation(firstpassPPShader.Program, "motionBlurMaxSamples"), motionBlurMaxSamples);
-        glUniform1i(glGetUniformLocation(firstpassPPShader.Program, "tonemappingMode"), tonemappingMode);
+        return defines;
+    }
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, postprocessBuffer);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, saoBlurBuffer);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gEffects);
+    if (fxaaMode)
+        defines.push_back("FXAA");
+    if (motionBlurMode)
+        defines.push_back("MOTION_BLUR");
+    if (saoMode)
+        defines.push_back("SAO");
+    defines.push_back("TONEMAPPING_MODE " + std::to_string(tonemappingMode));
+    if (outputSRGB)
+        defines.push_back("SRGB_FRAMEBUFFER");
+
+    return defines;
+}
 
-        quadRender.drawShape();
 
-        glQueryCounter(queryIDPostprocess[1], GL_TIMESTAMP);
+void runBenchmark(GLFWwindow* window)
+{
+    GLuint64 firstProfilerFrame = Profiler::getFrameCount();
+
+    std::cout << "BENCHMARK - RUNNING " << benchmark.getFrameCount() << " FRAMES" << std::endl;
+
+    for (GLuint frame = 0; frame < benchmark.getFrameCount() && !glfwWindowShouldClose(window); ++frame)
+    {
+        double frameStart = Profiler::getTime();
+
+        // Fixed time step, animations and motion blur do not depend on how fast the frame ran
+        deltaTime = benchmark.getTimeStep();
+        sceneTime = frame * deltaTime;
 
+        glfwPollEvents();
 
+        Profiler::beginFrame();
 
-        // Forward Pass rendering
+        // Scripted scene changes and camera path
 
-        glQueryCounter(queryIDForward[0], GL_TIMESTAMP);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        Profiler::beginZone("Benchmark Script", false);
+        std::vector<BenchmarkEvent> frameEvents = benchmark.getFrameEvents(frame);
 
-        // Copy the depth informations from the Geometry Pass into the default framebuffer
-        glBlitFramebuffer(0, 0, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        for (GLuint i = 0; i < frameEvents.size(); ++i)
+            applyBenchmarkEvent(frameEvents[i]);
+
+        glm::vec3 cameraPosition;
+        GLfloat cameraYaw, cameraPitch;
+
+        if (benchmark.getFrameCamera(frame, cameraPosition, cameraYaw, cameraPitch))
+            camera.setCamera(cameraPosition, cameraYaw, cameraPitch);
+        Profiler::endZone();
+
+        // Scene rendering
+
+        renderFrame();
+
+        Profiler::endFrame();
+
+        // The hidden window is still swapped so the driver paces the frames as it would on screen
+        glfwSwapBuffers(window);
+        StartupReport::endStartup();
+        FrameStats::recordFrame();
+
+        benchmark.recordFrame(frame, (Profiler::getTime() - frameStart) / 1000.0);
+        benchmark.recordGPU(firstProfilerFrame);
+
+        // HDR images in their current formats against the float ones, storage and estimated frame traffic
+        std::vector<HDRImageStats> hdrImages = getHDRImageStats();
+        GLuint64 hdrBytes[4] = { 0, 0, 0, 0 };
 
-        // Shape(s) rendering
-        if (pointMode)
+        for (GLuint i = 0; i < hdrImages.size(); ++i)
         {
-            simpleShader.useShader();
-            glUniformMatrix4fv(glGetUniformLocation(simpleShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-            glUniformMatrix4fv(glGetUniformLocation(simpleShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            hdrBytes[0] += hdrImages[i].imageBytes;
+            hdrBytes[1] += hdrImages[i].floatBytes;
+            hdrBytes[2] += hdrImages[i].frameBytes;
+            hdrBytes[3] += hdrImages[i].floatFrameBytes;
+        }
 
-            for (int i = 0; i < Light::lightPointList.size(); i++)
-            {
-                glUniform4f(glGetUniformLocation(simpleShader.Program, "lightColor"), Light::lightPointList[i].getLightColor().r, Light::lightPointList[i].getLightColor().g, Light::lightPointList[i].getLightColor().b, Light::lightPointList[i].getLightColor().a);
+        benchmark.recordMemory(frame, "hdr_vram_mb", hdrBytes[0] / (1024.0 * 1024.0));
+        benchmark.recordMemory(frame, "hdr_float_vram_mb", hdrBytes[1] / (1024.0 * 1024.0));
+        benchmark.recordMemory(frame, "hdr_frame_mb", hdrBytes[2] / (1024.0 * 1024.0));
+        benchmark.recordMemory(frame, "hdr_float_frame_mb", hdrBytes[3] / (1024.0 * 1024.0));
+    }
+
+    // Let the last frames retire so their GPU timings make it into the results
+    glFinish();
+    Profiler::resolveGPU();
+    benchmark.recordGPU(firstProfilerFrame);
+
+    benchmark.writeCSV();
+}
+
+
+std::vector<HDRImageStats> getHDRImageStats()
+{
+    // The lighting pass samples the environment maps once per pixel, its output is written and read back once
+    struct HDRImage
+    {
+        const char* imageName;
+        GLuint texID;
+        GLenum floatFormat;
+        GLuint frameAccesses;
+    };
+
+    HDRImage hdrImages[] = {
+        { "Environment", envMapHDR ? envMapHDR->getTexID() : 0, GL_RGB16F, 1 },
+        { "Environment Cube", envMapCube.getTexID(), GL_RGB16F, 0 },
+        { "Irradiance", envMapIrradiance.getTexID(), GL_RGB16F, 1 },
+        { "Prefiltered", envMapPrefilter.getTexID(), GL_RGB16F, 1 },
+        { "Lighting Output", postprocessBuffer, GL_RGBA32F, 2 }
+    };
+
+    std::vector<HDRImageStats> imageStats;
+
+    for (GLuint i = 0; i < sizeof(hdrImages) / sizeof(hdrImages[0]); ++i)
+    {
+        ResourceRecord record;
+
+        if (hdrImages[i].texID == 0 || !ResourceRegistry::getResource(RESOURCE_TEXTURE, hdrImages[i].texID, record))
+            continue;
+
+        // Environments with alpha are half floats either way
+        GLenum floatFormat = record.resourceFormat == GL_RGBA16F ? GL_RGBA16F : hdrImages[i].floatFormat;
+        GLuint64 framePixels = (GLuint64)WIDTH * HEIGHT * hdrImages[i].frameAccesses;
+
+        HDRImageStats stats;
+        stats.imageName = hdrImages[i].imageName;
+        stats.imageFormat = record.resourceFormat;
+        stats.floatFormat = floatFormat;
+        stats.imageBytes = record.deviceBytes;
+        stats.floatBytes = ResourceRegistry::getTextureBytes(floatFormat, record.resourceWidth, record.resourceHeight, record.resourceLayers, record.resourceLevels);
+        stats.frameBytes = framePixels * ResourceRegistry::getTexelBytes(record.resourceFormat);
+        stats.floatFrameBytes = framePixels * ResourceRegistry::getTexelBytes(floatFormat);
+        imageStats.push_back(stats);
+    }
+
+    return imageStats;
+}
+
+
+void applyBenchmarkEvent(const BenchmarkEvent& event)
+{
+    const std::string& command = event.eventCommand;
+    std::string arg = event.eventArgs.empty() ? "" : event.eventArgs[0];
+    bool enable = event.eventArgs.size() < 2 || std::atoi(event.eventArgs[1].c_str()) != 0;
+
+    if (command == "model")
+        loadModelPreset(arg);
+    else if (command == "material")
+        loadMaterialPreset(arg);
+    else if (command == "hdri")
+        loadEnvironment(arg);
+    else if (command == "view")
+        gBufferView = std::atoi(arg.c_str());
+    else if (command == "tonemapping")
+        tonemappingMode = std::atoi(arg.c_str());
+    else if (command == "spin")
+        modelRotationSpeed = std::atof(arg.c_str());
+    else if (command == "toggle" && arg == "point")
+        pointMode = enable;
+    else if (command == "toggle" && arg == "directional")
+        directionalMode = enable;
+    else if (command == "toggle" && arg == "ibl")
+        iblMode = enable;
+    else if (command == "toggle" && arg == "sao")
+        saoMode = enable;
+    else if (command == "toggle" && arg == "fxaa")
+        fxaaMode = enable;
+    else if (command == "toggle" && arg == "motionblur")
+        motionBlurMode = enable;
+    else
+        std::cerr << "BENCHMARK - UNKNOWN COMMAND AT FRAME " << event.eventFrame << " : " << command << " " << arg << std::endl;
+}
+
+
+bool runGoldenTest(GLFWwindow* window)
+{
+    std::vector<GoldenCase> cases = goldenTest.getCases();
+    std::vector<unsigned char> pixels(WIDTH * HEIGHT * 4);
+    std::string loadedModel, loadedMaterial;
+    bool lodPassed = true;
+
+    std::cout << "GOLDEN - RUNNING " << cases.size() << " CASES AT " << WIDTH << "x" << HEIGHT << std::endl;
+
+    for (GLuint c = 0; c < cases.size() && !glfwWindowShouldClose(window); ++c)
+    {
+        const GoldenCase& goldenCase = cases[c];
+
+        // Model presets reset the textures, so the material is applied again after a model change
+        if (goldenCase.caseModel != loadedModel)
+        {
+            loadModelPreset(goldenCase.caseModel);
+            loadedModel = goldenCase.caseModel;
+            loadedMaterial.clear();
 
-                if (Light::lightPointList[i].isMesh())
-                    Light::lightPointList[i].lightMesh.drawShape(simpleShader, view, projection, camera);
+            // With LOD disabled every mesh has to draw its full index range, whatever the camera sees
+            bool lodEnabled = Model::lodEnabled;
+            Model::lodEnabled = false;
+            objectModel.selectLods(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 1000.0f), camera.cameraFOV, HEIGHT);
+            Model::lodEnabled = lodEnabled;
+
+            if (objectModel.getDrawnTriangles() != objectModel.getFullTriangles())
+            {
+                std::printf("GOLDEN - FAIL %-28s LOD OFF DRAWS %u / %u TRIANGLES\n", loadedModel.c_str(), objectModel.getDrawnTriangles(), objectModel.getFullTriangles());
+                lodPassed = false;
             }
         }
-        glQueryCounter(queryIDForward[1], GL_TIMESTAMP);
 
+        if (goldenCase.caseMaterial != loadedMaterial)
+        {
+            loadMaterialPreset(goldenCase.caseMaterial);
+            loadedMaterial = goldenCase.caseMaterial;
+        }
 
-        // ImGui rendering
+        // Images are compared, every texture has to be resident before the first frame
+        TextureManager::finishLoads();
 
-        glQueryCounter(queryIDGUI[0], GL_TIMESTAMP);
-        ImGui::Render();
-        glQueryCounter(queryIDGUI[1], GL_TIMESTAMP);
+        gBufferView = goldenCase.caseView;
 
-        // GPU profiling
+        // Same still frame every time: default camera, no animation, no velocity
+        camera.setCamera(glm::vec3(0.0f, 0.0f, 4.0f), defaultCameraYaw, defaultCameraPitch);
+        deltaTime = benchmark.getTimeStep();
+        sceneTime = 0.0f;
 
-        GLint stopGeometryTimerAvailable = 0;
-        GLint stopLightingTimerAvailable = 0;
-        GLint stopSAOTimerAvailable = 0;
-        GLint stopPostprocessTimerAvailable = 0;
-        GLint stopForwardTimerAvailable = 0;
-        GLint stopGUITimerAvailable = 0;
+        goldenTest.beginCase(goldenCase);
 
-        while (!stopGeometryTimerAvailable && !stopLightingTimerAvailable && !stopSAOTimerAvailable && !stopPostprocessTimerAvailable && !stopForwardTimerAvailable && !stopGUITimerAvailable)
+        for (GLuint frame = 0; frame < goldenTest.getFrameCount(); ++frame)
         {
-            glGetQueryObjectiv(queryIDGeometry[1], GL_QUERY_RESULT_AVAILABLE, &stopGeometryTimerAvailable);
-            glGetQueryObjectiv(queryIDLighting[1], GL_QUERY_RESULT_AVAILABLE, &stopLightingTimerAvailable);
-            glGetQueryObjectiv(queryIDSAO[1], GL_QUERY_RESULT_AVAILABLE, &stopSAOTimerAvailable);
-            glGetQueryObjectiv(queryIDPostprocess[1], GL_QUERY_RESULT_AVAILABLE, &stopPostprocessTimerAvailable);
-            glGetQueryObjectiv(queryIDForward[1], GL_QUERY_RESULT_AVAILABLE, &stopForwardTimerAvailable);
-            glGetQueryObjectiv(queryIDGUI[1], GL_QUERY_RESULT_AVAILABLE, &stopGUITimerAvailable);
+            Profiler::beginFrame();
+            renderFrame();
+            Profiler::endFrame();
+
+            // Each frame is finished before the next one so its pass timings are not overlapped
+            glFinish();
+            Profiler::resolveGPU();
+            StartupReport::endStartup();
+
+            if (frame >= goldenTest.getWarmupFrames())
+                goldenTest.recordFrame();
         }
 
-        glGetQueryObjectui64v(queryIDGeometry[0], GL_QUERY_RESULT, &startGeometryTime);
-        glGetQueryObjectui64v(queryIDGeometry[1], GL_QUERY_RESULT, &stopGeometryTime);
-        glGetQueryObjectui64v(queryIDLighting[0], GL_QUERY_RESULT, &startLightingTime);
-        glGetQueryObjectui64v(queryIDLighting[1], GL_QUERY_RESULT, &stopLightingTime);
-        glGetQueryObjectui64v(queryIDSAO[0], GL_QUERY_RESULT, &startSAOTime);
-        glGetQueryObjectui64v(queryIDSAO[1], GL_QUERY_RESULT, &stopSAOTime);
-        glGetQueryObjectui64v(queryIDPostprocess[0], GL_QUERY_RESULT, &startPostprocessTime);
-        glGetQueryObjectui64v(queryIDPostprocess[1], GL_QUERY_RESULT, &stopPostprocessTime);
-        glGetQueryObjectui64v(queryIDForward[0], GL_QUERY_RESULT, &startForwardTime);
-        glGetQueryObjectui64v(queryIDForward[1], GL_QUERY_RESULT, &stopForwardTime);
-        glGetQueryObjectui64v(queryIDGUI[0], GL_QUERY_RESULT, &startGUITime);
-        glGetQueryObjectui64v(queryIDGUI[1], GL_QUERY_RESULT, &stopGUITime);
-
-        // Delta Timing
-
-        deltaGeometryTime = (stopGeometryTime - startGeometryTime) / 1000000.0;
-        deltaLightingTime = (stopLightingTime - startLightingTime) / 1000000.0;
-        deltaSAOTime = (stopSAOTime - startSAOTime) / 1000000.0;
-        deltaPostprocessTime = (stopPostprocessTime - startPostprocessTime) / 1000000.0;
-        deltaForwardTime = (stopForwardTime - startForwardTime) / 1000000.0;
-        deltaGUITime = (stopGUITime - startGUITime) / 1000000.0;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, outputFBO);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 
-        glfwSwapBuffers(window);
+        goldenTest.endCase(pixels, WIDTH, HEIGHT);
     }
 
-    ImGui_ImplGlfwGL3_Shutdown();
-    glfwTerminate();
-
-    return 0;
+    return goldenTest.writeReport() && lodPassed;
 }
 
 
-
 void cameraMove()
 {
     if (keys[GLFW_KEY_W])
@@ -813,26 +1225,22 @@ void imGuiSetup()
             {
                 if (ImGui::Button("Blue Sky"))
                 {
-                    envMapHDR.setTextureHDR("resources/textures/hdr/bluesky.hdr", "blueskyHDR", true);
-                    iblSetup();
+                    loadEnvironment("bluesky");
                 }
 
                 if (ImGui::Button("Warm Home"))
                 {
-                    envMapHDR.setTextureHDR("resources/textures/hdr/warmhome.hdr", "warmhomeHDR", true);
-                    iblSetup();
+                    loadEnvironment("warmhome");
                 }
 
                 if (ImGui::Button("Hotel Room"))
                 {
-                    envMapHDR.setTextureHDR("resources/textures/hdr/ensuite.hdr", "ensuiteHDR", true);
-                    iblSetup();
+                    loadEnvironment("ensuite");
                 }
 
                 if (ImGui::Button("Studio"))
                 {
-                    envMapHDR.setTextureHDR("resources/textures/hdr/studio1.hdr", "studio1HDR", true);
-                    iblSetup();
+                    loadEnvironment("studio1");
                 }
 
                 ImGui::TreePop();
@@ -908,71 +1316,22 @@ void imGuiSetup()
                 {
                     if (ImGui::Button("Sphere"))
                     {
-                        objectModel.~Model();
-                        objectModel.loadModel("resources/models/sphere/sphere.obj");
-                        modelScale = glm::vec3(0.6f);
-
-                        if (Statue = true) {
-
-                            objectAlbedo.setTexture("resources/textures/pbr/quartz/quartz_albedo.png", "quartzAlbedo", true);
-                            objectNormal.setTexture("resources/textures/pbr/quartz/quartz_normal.png", "quartzNormal", true);
-                            objectRoughness.setTexture("resources/textures/pbr/quartz/quartz_roughness.png", "quartzRoughness", true);
-                            objectMetalness.setTexture("resources/textures/pbr/quartz/quartz_metalness.png", "quartzMetalness", true);
-                            objectAO.setTexture("resources/textures/pbr/quartz/quartz_ao.png", "quartzAO", true);
-
-                        }
+                        loadModelPreset("sphere");
                     }
 
                     if (ImGui::Button("Cube"))
                     {
-                        objectModel.~Model();
-                        objectModel.loadModel("resources/models/cube/cube.obj");
-                        modelScale = glm::vec3(0.6f);
-
-                        if (Statue = true) {
-
-                            objectAlbedo.setTexture("resources/textures/pbr/quartz/quartz_albedo.png", "quartzAlbedo", true);
-                            objectNormal.setTexture("resources/textures/pbr/quartz/quartz_normal.png", "quartzNormal", true);
-                            objectRoughness.setTexture("resources/textures/pbr/quartz/quartz_roughness.png", "quartzRoughness", true);
-                            objectMetalness.setTexture("resources/textures/pbr/quartz/quartz_metalness.png", "quartzMetalness", true);
-                            objectAO.setTexture("resources/textures/pbr/quartz/quartz_ao.png", "quartzAO", true);
-
-                        }
+                        loadModelPreset("cube");
                     }
 
                     if (ImGui::Button("Torus"))
                     {
-                        objectModel.~Model();
-                        objectModel.loadModel("resources/models/torus/torus.obj");
-                        modelScale = glm::vec3(0.35f);
-
-                        if (Statue = true) {
-
-                            objectAlbedo.setTexture("resources/textures/pbr/quartz/quartz_albedo.png", "quartzAlbedo", true);
-                            objectNormal.setTexture("resources/textures/pbr/quartz/quartz_normal.png", "quartzNormal", true);
-                            objectRoughness.setTexture("resources/textures/pbr/quartz/quartz_roughness.png", "quartzRoughness", true);
-                            objectMetalness.setTexture("resources/textures/pbr/quartz/quartz_metalness.png", "quartzMetalness", true);
-                            objectAO.setTexture("resources/textures/pbr/quartz/quartz_ao.png", "quartzAO", true);
-
-                        }
+                        loadModelPreset("torus");
                     }
 
                     if (ImGui::Button("Pyramid"))
                     {
-                        objectModel.~Model();
-                        objectModel.loadModel("resources/models/pyramid/pyramid.obj");
-                        modelScale = glm::vec3(0.55f);
-
-                        if (Statue = true) {
-
-                            objectAlbedo.setTexture("resources/textures/pbr/quartz/quartz_albedo.png", "quartzAlbedo", true);
-                            objectNormal.setTexture("resources/textures/pbr/quartz/quartz_normal.png", "quartzNormal", true);
-                            objectRoughness.setTexture("resources/textures/pbr/quartz/quartz_roughness.png", "quartzRoughness", true);
-                            objectMetalness.setTexture("resources/textures/pbr/quartz/quartz_metalness.png", "quartzMetalness", true);
-                            objectAO.setTexture("resources/textures/pbr/quartz/quartz_ao.png", "quartzAO", true);
-
-                        }
-
+                        loadModelPreset("pyramid");
                     }
 
                     ImGui::TreePop();
@@ -982,20 +1341,19 @@ void imGuiSetup()
                 {
                     if (ImGui::Button("Statue"))
                     {
-                        objectModel.~Model();
-                        objectModel.loadModel("resources/models/statue/statue.obj");
-                        modelScale = glm::vec3(0.6f);
-
-                        objectAlbedo.setTexture("resources/textures/pbr/statue/statue_albedo.png", "statueAlbedo", true);
-                        objectNormal.setTexture("resources/textures/pbr/statue/statue_normal.png", "statueNormal", true);
-                        objectRoughness.setTexture("resources/textures/pbr/statue/statue_roughness.png", "statueRoughness", true);
-                        objectMetalness.setTexture("resources/textures/pbr/statue/statue_metalness.png", "statueMetalness", true);
-                        objectAO.setTexture("resources/textures/pbr/statue/statue_ao.png", "statueAO", true);
+                        loadModelPreset("statue");
+                    }
 
-                        Statue = true;
 
-                    }
+                    ImGui::TreePop();
+                }
 
+                if (ImGui::TreeNode("Level of Detail"))
+                {
+                    ImGui::Checkbox("Enable", &Model::lodEnabled);
+                    ImGui::Checkbox("Dithered Cross-Fade", &Model::lodCrossFade);
+                    ImGui::SliderFloat("Error (px)", &Model::lodErrorPixels, 0.25f, 8.0f);
+                    ImGui::Text("Triangles : %u / %u", objectModel.getDrawnTriangles(), objectModel.getFullTriangles());
 
                     ImGui::TreePop();
                 }
@@ -1013,36 +1371,17 @@ void imGuiSetup()
             {
                 if (ImGui::Button("Quartz"))
                 {
-                    objectAlbedo.setTexture("resources/textures/pbr/quartz/quartz_albedo.png", "quartzAlbedo", true);
-                    objectNormal.setTexture("resources/textures/pbr/quartz/quartz_normal.png", "quartzNormal", true);
-                    objectRoughness.setTexture("resources/textures/pbr/quartz/quartz_roughness.png", "quartzRoughness", true);
-                    objectMetalness.setTexture("resources/textures/pbr/quartz/quartz_metalness.png", "quartzMetalness", true);
-                    objectAO.setTexture("resources/textures/pbr/quartz/quartz_ao.png", "quartzAO", true);
-
-                    materialF0 = glm::vec3(0.04f);
-
+                    loadMaterialPreset("quartz");
                 }
 
                 if (ImGui::Button("Shiny"))
                 {
-                    objectAlbedo.setTexture("resources/textures/pbr/shiny/shiny_albedo.png", "goldAlbedo", true);
-                    objectNormal.setTexture("resources/textures/pbr/shiny/shiny_normal.png", "goldNormal", true);
-                    objectRoughness.setTexture("resources/textures/pbr/shiny/shiny_roughness.png", "goldRoughness", true);
-                    objectMetalness.setTexture("resources/textures/pbr/shiny/shiny_metalness.png", "goldMetalness", true);
-                    objectAO.setTexture("resources/textures/pbr/shiny/shiny_ao.png", "goldAO", true);
-
-                    materialF0 = glm::vec3(1.0f, 0.72f, 0.29f);
+                    loadMaterialPreset("shiny");
                 }
 
                 if (ImGui::Button("Granite"))
                 {
-                    objectAlbedo.setTexture("resources/textures/pbr/granite/granite_albedo.png", "graniteAlbedo", true);
-                    objectNormal.setTexture("resources/textures/pbr/granite/granite_normal.png", "graniteNormal", true);
-                    objectRoughness.setTexture("resources/textures/pbr/granite/granite_roughness.png", "graniteRoughness", true);
-                    objectMetalness.setTexture("resources/textures/pbr/granite/granite_metalness.png", "graniteMetalness", true);
-                    objectAO.setTexture("resources/textures/pbr/granite/granite_ao.png", "graniteAO", true);
-
-                    materialF0 = glm::vec3(0.04f);
+                    loadMaterialPreset("granite");
                 }
 
                 ImGui::TreePop();
@@ -1054,12 +1393,221 @@ void imGuiSetup()
 
     if (ImGui::CollapsingHeader("Debug Info", 0, true, true))
     {
-        ImGui::Text("Geometry Phase:      %.4f ms", deltaGeometryTime);
-        ImGui::Text("Illumination Phase:  %.4f ms", deltaLightingTime);
-        ImGui::Text("AO Computation:      %.4f ms", deltaSAOTime);
-        ImGui::Text("PostFX Processing:   %.4f ms", deltaPostprocessTime);
-        ImGui::Text("Forward Rendering:   %.4f ms", deltaForwardTime);
-        ImGui::Text("UI Rendering:        %.4f ms", deltaGUITime);
+        const std::vector<ProfilerZoneRecord>& frameZones = Profiler::getFrameZones();
+
+        for (GLuint i = 0; i < frameZones.size(); ++i)
+        {
+            GLfloat cpuTime = (frameZones[i].cpuStop - frameZones[i].cpuStart) / 1000.0;
+            int zoneIndent = 2 * frameZones[i].zoneDepth;
+
+            // Nested zones are indented under their parent
+            if (frameZones[i].zoneGPUPass >= 0)
+                ImGui::Text("%*s%-*s CPU %.3f ms / GPU %.3f ms", zoneIndent, "", 20 - zoneIndent, frameZones[i].zoneName.c_str(), cpuTime, Profiler::getZoneGPUTime(frameZones[i]));
+            else
+                ImGui::Text("%*s%-*s CPU %.3f ms", zoneIndent, "", 20 - zoneIndent, frameZones[i].zoneName.c_str(), cpuTime);
+        }
+
+        ImGui::Text("\nGPU timings latency: %u frame(s)", Profiler::getGPULatency());
+        ImGui::Text("Dropped timer frames: %llu", (unsigned long long)Profiler::getDroppedFrames());
+
+        if (ImGui::Button("Dump Trace"))
+            Profiler::dumpTrace(profilerTracePath);
+
+        bool glStatsMode = GLStats::isEnabled();
+
+        if (ImGui::Checkbox("Count GL Calls", &glStatsMode))
+            GLStats::setEnabled(glStatsMode);
+
+        if (GLStats::isEnabled())
+        {
+            const std::vector<GLStatsPass>& framePasses = GLStats::getFramePasses();
+            GLStatsCounters frameTotals = GLStats::getFrameTotals();
+
+            ImGui::Columns(6, "glStatsColumns", false);
+
+            // Wide first column for the pass names, narrow ones for the counts
+            for (GLuint i = 1; i < 6; ++i)
+                ImGui::SetColumnOffset(i, 100.0f + 45.0f * (i - 1));
+
+            const char* headers[] = { "Pass", "Draw", "Bind", "Redun.", "Unif.", "Get" };
+            for (GLuint i = 0; i < 6; ++i)
+            {
+                ImGui::Text("%s", headers[i]);
+                ImGui::NextColumn();
+            }
+
+            // One row per pass, then the frame total
+            for (GLuint i = 0; i <= framePasses.size(); ++i)
+            {
+                const GLStatsCounters& counters = i < framePasses.size() ? framePasses[i].passCounters : frameTotals;
+                GLuint binds = counters.programBinds + counters.textureBinds + counters.framebufferBinds + counters.vertexArrayBinds;
+
+                ImGui::Text("%s", i < framePasses.size() ? framePasses[i].passName.c_str() : "Total");
+                ImGui::NextColumn();
+                ImGui::Text("%u", counters.drawCalls);
+                ImGui::NextColumn();
+                ImGui::Text("%u", binds);
+                ImGui::NextColumn();
+                ImGui::Text("%u", counters.redundantBinds);
+                ImGui::NextColumn();
+                ImGui::Text("%u", counters.uniformUploads);
+                ImGui::NextColumn();
+                ImGui::Text("%u", counters.getCalls);
+                ImGui::NextColumn();
+            }
+
+            ImGui::Columns(1);
+
+            ImGui::Text("Binds: %u program, %u texture, %u FBO, %u VAO", frameTotals.programBinds, frameTotals.textureBinds,
+                        frameTotals.framebufferBinds, frameTotals.vertexArrayBinds);
+            ImGui::Text("Buffer uploads: %u", frameTotals.bufferUploads);
+        }
+
+        // Live GL resources, video memory is estimated from the formats
+        ImGui::Text("\nMemory");
+        ImGui::Columns(4, "memoryColumns", false);
+
+        for (GLuint i = 1; i < 4; ++i)
+            ImGui::SetColumnOffset(i, 100.0f + 55.0f * (i - 1));
+
+        const char* memoryHeaders[] = { "Category", "Count", "VRAM", "Host" };
+        for (GLuint i = 0; i < 4; ++i)
+        {
+            ImGui::Text("%s", memoryHeaders[i]);
+            ImGui::NextColumn();
+        }
+
+        for (GLuint i = 0; i <= RESOURCE_TYPE_COUNT; ++i)
+        {
+            ResourceTotals totals = i < RESOURCE_TYPE_COUNT ? ResourceRegistry::getTotals((ResourceType)i) : ResourceRegistry::getTotals();
+
+            ImGui::Text("%s", i < RESOURCE_TYPE_COUNT ? ResourceRegistry::getTypeName((ResourceType)i) : "Total");
+            ImGui::NextColumn();
+            ImGui::Text("%u", totals.resourceCount);
+            ImGui::NextColumn();
+            ImGui::Text("%.1f MB", totals.deviceBytes / (1024.0 * 1024.0));
+            ImGui::NextColumn();
+            ImGui::Text("%.1f MB", totals.hostBytes / (1024.0 * 1024.0));
+            ImGui::NextColumn();
+        }
+
+        ImGui::Columns(1);
+
+        // File textures kept for reuse, idle ones are only held by the cache
+        TextureCacheStats textureStats = TextureManager::getStats();
+        int textureBudget = TextureManager::getBudget() / (1024 * 1024);
+
+        ImGui::Text("\nTexture cache: %u textures (%u idle), %.1f MB (%.1f MB idle)", textureStats.textureCount, textureStats.idleCount,
+                    textureStats.textureBytes / (1024.0 * 1024.0), textureStats.idleBytes / (1024.0 * 1024.0));
+        ImGui::Text("Hits %llu, misses %llu, evicted %llu", (unsigned long long)textureStats.cacheHits,
+                    (unsigned long long)textureStats.cacheMisses, (unsigned long long)textureStats.cacheEvictions);
+
+        if (ImGui::SliderInt("Texture budget (MB)", &textureBudget, 0, 2048))
+            TextureManager::setBudget((GLuint64)textureBudget * 1024 * 1024);
+
+        // Streaming: decoding on the loader threads, then staged in the upload ring until their fence is signaled
+        TextureLoaderStats loaderStats = TextureLoader::getStats();
+
+        ImGui::Text("Texture loader: %u threads, %u loading, %u uploading, ring %.1f / %.1f MB", loaderStats.threadCount,
+                    loaderStats.queuedCount, loaderStats.uploadingCount, loaderStats.ringUsedBytes / (1024.0 * 1024.0),
+                    loaderStats.ringBytes / (1024.0 * 1024.0));
+        ImGui::Text("Streamed %llu textures, %.1f MB, staging pool %.1f MB", (unsigned long long)loaderStats.uploadedCount,
+                    loaderStats.uploadedBytes / (1024.0 * 1024.0), loaderStats.stagingBytes / (1024.0 * 1024.0));
+
+        if (ImGui::TreeNode("HDR Formats"))
+        {
+            // Frame traffic counts one texel per pixel for every read and write, filtering and caches aside
+            std::vector<HDRImageStats> hdrImages = getHDRImageStats();
+            HDRImageStats hdrTotals = { "Total", GL_NONE, GL_NONE, 0, 0, 0, 0 };
+
+            ImGui::Text("%-18s %-8s %9s %9s %11s %11s", "Image", "Format", "MB", "Float MB", "Frame MB", "Float Frame");
+
+            for (GLuint i = 0; i <= hdrImages.size(); ++i)
+            {
+                const HDRImageStats& image = i < hdrImages.size() ? hdrImages[i] : hdrTotals;
+
+                ImGui::Text("%-18s %-8s %9.2f %9.2f %11.2f %11.2f", image.imageName.c_str(), ResourceRegistry::getFormatName(image.imageFormat).c_str(),
+                            image.imageBytes / (1024.0 * 1024.0), image.floatBytes / (1024.0 * 1024.0),
+                            image.frameBytes / (1024.0 * 1024.0), image.floatFrameBytes / (1024.0 * 1024.0));
+
+                if (i < hdrImages.size())
+                {
+                    hdrTotals.imageBytes += image.imageBytes;
+                    hdrTotals.floatBytes += image.floatBytes;
+                    hdrTotals.frameBytes += image.frameBytes;
+                    hdrTotals.floatFrameBytes += image.floatFrameBytes;
+                }
+            }
+
+            ImGui::TreePop();
+        }
+
+        if (ImGui::TreeNode("Resources"))
+        {
+            std::vector<ResourceRecord> resources = ResourceRegistry::getResources();
+
+            for (GLuint i = 0; i < resources.size(); ++i)
+            {
+                const ResourceRecord& resource = resources[i];
+
+                ImGui::Text("%-8s %4ux%-4u %8.2f MB  %s", ResourceRegistry::getFormatName(resource.resourceFormat).c_str(),
+                            resource.resourceWidth, resource.resourceHeight, (resource.deviceBytes + resource.hostBytes) / (1024.0 * 1024.0),
+                            resource.resourceOwner.c_str());
+            }
+
+            ImGui::TreePop();
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Frame Stats", 0, true, true))
+    {
+        const std::vector<std::string>& seriesNames = FrameStats::getSeriesNames();
+        GLfloat hitchThreshold = FrameStats::getHitchThreshold();
+
+        if (ImGui::SliderFloat("Hitch (ms)", &hitchThreshold, 5.0f, 500.0f, "%.0f"))
+            FrameStats::setHitchThreshold(hitchThreshold);
+
+        ImGui::Text("Last %u frames (ms)", FrameStats::getWindowSize());
+        ImGui::Text("%-20s %7s %7s %7s %7s", "Series", "p50", "p95", "p99", "max");
+
+        for (GLuint i = 0; i < seriesNames.size(); ++i)
+        {
+            FrameStatsSummary summary = FrameStats::getSummary(seriesNames[i]);
+            ImGui::Text("%-20s %7.2f %7.2f %7.2f %7.2f", seriesNames[i].c_str(), summary.p50, summary.p95, summary.p99, summary.max);
+        }
+
+        // Graphs are scaled to twice the threshold, anything above it is a hitch anyway
+        std::vector<GLfloat> presentSamples = FrameStats::getSamples("Present");
+        std::vector<GLfloat> frameSamples = FrameStats::getSamples("Frame CPU");
+        std::vector<GLfloat> presentHistogram = FrameStats::getHistogram("Present", 40, 2.0f * hitchThreshold);
+
+        if (!presentSamples.empty())
+            ImGui::PlotLines("Present", &presentSamples[0], presentSamples.size(), 0, NULL, 0.0f, 2.0f * hitchThreshold, ImVec2(0, 60));
+        if (!frameSamples.empty())
+            ImGui::PlotLines("Frame CPU", &frameSamples[0], frameSamples.size(), 0, NULL, 0.0f, 2.0f * hitchThreshold, ImVec2(0, 60));
+        ImGui::PlotHistogram("Histogram", &presentHistogram[0], presentHistogram.size(), 0, "Present 0 - 2x hitch", 0.0f, FLT_MAX, ImVec2(0, 60));
+
+        // Most recent hitch first, with the slowest zone and what the application was doing
+        const std::deque<FrameHitch>& frameHitches = FrameStats::getHitches();
+
+        ImGui::Text("\nHitches: %u", (GLuint)frameHitches.size());
+        ImGui::SameLine();
+
+        if (ImGui::Button("Clear"))
+            FrameStats::clearHitches();
+
+        for (GLuint i = 0; i < frameHitches.size(); ++i)
+        {
+            const FrameHitch& hitch = frameHitches[i];
+            std::string hitchEvents;
+
+            for (GLuint j = 0; j < hitch.hitchEvents.size(); ++j)
+                hitchEvents += (j == 0 ? "" : ", ") + hitch.hitchEvents[j];
+
+            ImGui::Text("%7.2fs %7.1f ms  %s", hitch.hitchTime, hitch.presentInterval, hitch.hitchZone.c_str());
+            if (!hitchEvents.empty())
+                ImGui::Text("          %s", hitchEvents.c_str());
+        }
     }
 
     if (ImGui::CollapsingHeader("Specs", 0, true, true))
@@ -1088,26 +1636,143 @@ void imGuiSetup()
 }
 
 
+void loadModelPreset(const std::string& modelName)
+{
+    // Scale that frames each model the same way in the default camera
+    GLfloat presetScale = 0.6f;
+
+    if (modelName == "torus")
+        presetScale = 0.35f;
+    else if (modelName == "pyramid")
+        presetScale = 0.55f;
+    else if (modelName != "sphere" && modelName != "cube" && modelName != "statue")
+    {
+        std::cerr << "UNKNOWN MODEL PRESET : " << modelName << std::endl;
+        return;
+    }
+
+    FrameStats::addEvent("Model " + modelName);
+
+    // Start from a fresh model, calling the destructor in place left the mesh list dangling
+    objectModel.releaseModel();
+    objectModel = Model();
+    objectModel.loadModel("resources/models/" + modelName + "/" + modelName + ".obj");
+    modelScale = glm::vec3(presetScale);
+
+    // The statue comes with its own textures, basic shapes go back to quartz
+    if (modelName == "statue")
+    {
+        loadMaterialTextures("statue");
+        Statue = true;
+    }
+    else
+        loadMaterialTextures("quartz");
+}
+
+
+void loadMaterialPreset(const std::string& materialName)
+{
+    if (materialName == "shiny")
+        materialF0 = glm::vec3(1.0f, 0.72f, 0.29f);
+    else if (materialName == "quartz" || materialName == "granite")
+        materialF0 = glm::vec3(0.04f);
+    else
+    {
+        std::cerr << "UNKNOWN MATERIAL PRESET : " << materialName << std::endl;
+        return;
+    }
+
+    FrameStats::addEvent("Material " + materialName);
+
+    loadMaterialTextures(materialName);
+}
+
+
+void loadMaterialTextures(const std::string& materialName)
+{
+    std::string materialPath = "resources/textures/pbr/" + materialName + "/" + materialName;
+
+    // Materials seen before come straight from the cache, the previous ones stay resident within the budget.
+    // New ones are streamed in, each map shows a neutral placeholder until it lands
+    objectAlbedo = TextureManager::requestTexture(materialPath + "_albedo.png", materialName + "Albedo", true, TEXTURE_USAGE_COLOR);
+    objectNormal = TextureManager::requestTexture(materialPath + "_normal.png", materialName + "Normal", true, TEXTURE_USAGE_NORMAL);
+    objectAO = TextureManager::requestTexture(materialPath + "_ao.png", materialName + "AO", true, TEXTURE_USAGE_MASK);
+    objectRoughMetal = TextureManager::requestTexture(materialPath + "_rm.png", materialName + "RoughMetal", true, TEXTURE_USAGE_ROUGH_METAL);
+
+    TextureManager::trimTextures();
+}
+
+
+void loadEnvironment(const std::string& hdrName)
+{
+    FrameStats::addEvent("HDRI " + hdrName);
+    envMapHDR = TextureManager::getTextureHDR("resources/textures/hdr/" + hdrName + ".hdr", hdrName + "HDR", true);
+    TextureManager::trimTextures();
+    iblSetup();
+}
+
+
+void convertTextures()
+{
+    // Every file texture the presets load, so even their first load maps a container
+    const char* materialNames[] = { "quartz", "granite", "shiny", "statue" };
+    const char* environmentNames[] = { "bluesky", "warmhome", "ensuite", "studio1" };
+    const char* materialMaps[] = { "_albedo.png", "_normal.png", "_ao.png", "_rm.png" };
+    TextureUsage materialUsages[] = { TEXTURE_USAGE_COLOR, TEXTURE_USAGE_NORMAL, TEXTURE_USAGE_MASK, TEXTURE_USAGE_ROUGH_METAL };
+    GLuint convertedCount = 0, failedCount = 0;
+    TextureImage image;
+
+    for (GLuint i = 0; i < sizeof(materialNames) / sizeof(materialNames[0]); ++i)
+    {
+        std::string materialPath = "resources/textures/pbr/" + std::string(materialNames[i]) + "/" + materialNames[i];
+
+        for (GLuint map = 0; map < 4; ++map)
+        {
+            if (Texture::convertTextureImage(materialPath + materialMaps[map], true, materialUsages[map], image))
+                convertedCount++;
+            else
+            {
+                std::cerr << "TEXTURES - NOTHING TO CONVERT : " << materialPath + materialMaps[map] << std::endl;
+                failedCount++;
+            }
+        }
+    }
+
+    for (GLuint i = 0; i < sizeof(environmentNames) / sizeof(environmentNames[0]); ++i)
+    {
+        if (Texture::convertTextureImageHDR("resources/textures/hdr/" + std::string(environmentNames[i]) + ".hdr", true, image))
+            convertedCount++;
+        else
+            failedCount++;
+    }
+
+    std::cout << "TEXTURES - " << convertedCount << " CONVERTED, " << failedCount << " MISSING" << std::endl;
+}
+
+
 void gBufferSetup()
 {
     // Generate and bind the G-Buffer framebuffer
     glGenFramebuffers(1, &gBuffer);
+    ResourceRegistry::addFramebuffer(gBuffer, "G-Buffer");
     glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
 
     // Setup Position Texture
     glGenTextures(1, &gPosition);
     glBindTexture(GL_TEXTURE_2D, gPosition);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WIDTH, HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+    ResourceRegistry::addTexture(gPosition, GL_RGBA16F, WIDTH, HEIGHT, 1, false, "G-Buffer Position");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
 
-    // Setup Albedo Texture
+    // Setup Albedo Texture, sRGB encoded so the 8 bits go where the dark tones need them
     glGenTextures(1, &gAlbedo);
     glBindTexture(GL_TEXTURE_2D, gAlbedo);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    ResourceRegistry::addTexture(gAlbedo, GL_SRGB8_ALPHA8, WIDTH, HEIGHT, 1, false, "G-Buffer Albedo");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gAlbedo, 0);
@@ -1116,6 +1781,7 @@ void gBufferSetup()
     glGenTextures(1, &gNormal);
     glBindTexture(GL_TEXTURE_2D, gNormal);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WIDTH, HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+    ResourceRegistry::addTexture(gNormal, GL_RGBA16F, WIDTH, HEIGHT, 1, false, "G-Buffer Normal");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gNormal, 0);
@@ -1124,6 +1790,7 @@ void gBufferSetup()
     glGenTextures(1, &gEffects);
     glBindTexture(GL_TEXTURE_2D, gEffects);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, WIDTH, HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
+    ResourceRegistry::addTexture(gEffects, GL_RGB16F, WIDTH, HEIGHT, 1, false, "G-Buffer Effects");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, gEffects, 0);
@@ -1136,6 +1803,7 @@ void gBufferSetup()
     glGenRenderbuffers(1, &zBuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, zBuffer);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, WIDTH, HEIGHT);
+    ResourceRegistry::addRenderbuffer(zBuffer, GL_DEPTH_COMPONENT, WIDTH, HEIGHT, "G-Buffer Depth");
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, zBuffer);
 
 
@@ -1149,10 +1817,12 @@ void saoSetup()
 {
     // SAO Buffer
     glGenFramebuffers(1, &saoFBO);
+    ResourceRegistry::addFramebuffer(saoFBO, "SAO");
     glBindFramebuffer(GL_FRAMEBUFFER, saoFBO);
     glGenTextures(1, &saoBuffer);
     glBindTexture(GL_TEXTURE_2D, saoBuffer);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, WIDTH, HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    ResourceRegistry::addTexture(saoBuffer, GL_RED, WIDTH, HEIGHT, 1, false, "SAO");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, saoBuffer, 0);
@@ -1162,10 +1832,12 @@ void saoSetup()
 
     // SAO Blur Buffer
     glGenFramebuffers(1, &saoBlurFBO);
+    ResourceRegistry::addFramebuffer(saoBlurFBO, "SAO Blur");
     glBindFramebuffer(GL_FRAMEBUFFER, saoBlurFBO);
     glGenTextures(1, &saoBlurBuffer);
     glBindTexture(GL_TEXTURE_2D, saoBlurBuffer);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, WIDTH, HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    ResourceRegistry::addTexture(saoBlurBuffer, GL_RED, WIDTH, HEIGHT, 1, false, "SAO Blur");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, saoBlurBuffer, 0);
@@ -1181,11 +1853,16 @@ void postprocessSetup()
 {
     // Post-processing Buffer
     glGenFramebuffers(1, &postprocessFBO);
+    ResourceRegistry::addFramebuffer(postprocessFBO, "Postprocess");
     glBindFramebuffer(GL_FRAMEBUFFER, postprocessFBO);
 
+    // The lighting pass writes no alpha and nothing negative, packed floats hold its output in a quarter of the memory
+    GLenum postprocessFormat = TextureCompressor::getHDRTargetFormat(GL_RGBA32F);
+
     glGenTextures(1, &postprocessBuffer);
     glBindTexture(GL_TEXTURE_2D, postprocessBuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, WIDTH, HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, postprocessFormat, WIDTH, HEIGHT, 0, postprocessFormat == GL_RGBA32F ? GL_RGBA : GL_RGB, GL_FLOAT, NULL);
+    ResourceRegistry::addTexture(postprocessBuffer, postprocessFormat, WIDTH, HEIGHT, 1, false, "Postprocess");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, postprocessBuffer, 0);
@@ -1195,28 +1872,118 @@ void postprocessSetup()
 }
 
 
+void outputSetup()
+{
+    // Offscreen final image for runs without a visible window
+    glGenFramebuffers(1, &outputFBO);
+    ResourceRegistry::addFramebuffer(outputFBO, "Output");
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+
+    glGenTextures(1, &outputBuffer);
+    glBindTexture(GL_TEXTURE_2D, outputBuffer);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    ResourceRegistry::addTexture(outputBuffer, GL_SRGB8_ALPHA8, WIDTH, HEIGHT, 1, false, "Output");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, outputBuffer, 0);
+
+    // Same depth format as the G-Buffer, the forward pass blits its depth in here
+    glGenRenderbuffers(1, &outputDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, outputDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, WIDTH, HEIGHT);
+    ResourceRegistry::addRenderbuffer(outputDepth, GL_DEPTH_COMPONENT, WIDTH, HEIGHT, "Output Depth");
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, outputDepth);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Output Framebuffer not complete !" << std::endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+void releaseResources()
+{
+    // Everything created above, whatever the registry still lists afterwards was leaked
+    TextureManager::stopLoading();
+    objectModel.releaseModel();
+    envCubeRender.releaseShape();
+    quadRender.releaseShape();
+    lightPoint1.lightMesh.releaseShape();
+    lightPoint2.lightMesh.releaseShape();
+    lightPoint3.lightMesh.releaseShape();
+
+    TextureHandle* fileTextures[] = { &objectAlbedo, &objectNormal, &objectAO, &objectRoughMetal, &envMapHDR };
+    Texture* textures[] = { &envMapCube, &envMapIrradiance, &envMapPrefilter, &envMapLUT };
+    GLuint renderTargets[] = { gPosition, gAlbedo, gNormal, gEffects, saoBuffer, saoBlurBuffer, postprocessBuffer, outputBuffer };
+    GLuint renderbuffers[] = { zBuffer, outputDepth, envToCubeRBO, irradianceRBO, prefilterRBO, brdfLUTRBO };
+    GLuint framebuffers[] = { gBuffer, saoFBO, saoBlurFBO, postprocessFBO, outputFBO, envToCubeFBO, irradianceFBO, prefilterFBO, brdfLUTFBO };
+
+    // Dropping the last handles lets the cache free the file textures
+    for (GLuint i = 0; i < sizeof(fileTextures) / sizeof(fileTextures[0]); ++i)
+        fileTextures[i]->reset();
+
+    TextureManager::releaseTextures();
+
+    for (GLuint i = 0; i < sizeof(textures) / sizeof(textures[0]); ++i)
+        textures[i]->releaseTexture();
+
+    for (GLuint i = 0; i < sizeof(renderTargets) / sizeof(renderTargets[0]); ++i)
+    {
+        glDeleteTextures(1, &renderTargets[i]);
+        ResourceRegistry::removeResource(RESOURCE_TEXTURE, renderTargets[i]);
+    }
+
+    for (GLuint i = 0; i < sizeof(renderbuffers) / sizeof(renderbuffers[0]); ++i)
+    {
+        glDeleteRenderbuffers(1, &renderbuffers[i]);
+        ResourceRegistry::removeResource(RESOURCE_RENDERBUFFER, renderbuffers[i]);
+    }
+
+    for (GLuint i = 0; i < sizeof(framebuffers) / sizeof(framebuffers[0]); ++i)
+    {
+        glDeleteFramebuffers(1, &framebuffers[i]);
+        ResourceRegistry::removeResource(RESOURCE_FRAMEBUFFER, framebuffers[i]);
+    }
+
+    frameUBO.releaseUniformBuffer();
+    saoUBO.releaseUniformBuffer();
+
+    Profiler::releaseProfiler();
+}
+
+
 void iblSetup()
 {
+    ProfilerZone iblZone("IBL Setup", true);
+
     // Latlong to Cubemap conversion
-    glGenFramebuffers(1, &envToCubeFBO);
-    glGenRenderbuffers(1, &envToCubeRBO);
+    Profiler::beginZone("IBL Cube Conversion", true);
+    StartupReport::beginPhase("IBL Cube Conversion", envMapHDR->getTexName(), true);
+    if (envToCubeFBO == 0)
+    {
+        glGenFramebuffers(1, &envToCubeFBO);
+        glGenRenderbuffers(1, &envToCubeRBO);
+        ResourceRegistry::addFramebuffer(envToCubeFBO, "IBL Cube Conversion");
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, envToCubeFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, envToCubeRBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, envMapCube.getTexWidth(), envMapCube.getTexHeight());
+    ResourceRegistry::addRenderbuffer(envToCubeRBO, GL_DEPTH_COMPONENT24, envMapCube.getTexWidth(), envMapCube.getTexHeight(), "IBL Cube Conversion");
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, envToCubeRBO);
 
     latlongToCubeShader.useShader();
 
-    glUniformMatrix4fv(glGetUniformLocation(latlongToCubeShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(envMapProjection));
+    latlongToCubeShader.setMat4("projection", envMapProjection);
     glActiveTexture(GL_TEXTURE0);
-    envMapHDR.useTexture();
+    envMapHDR->useTexture();
 
     glViewport(0, 0, envMapCube.getTexWidth(), envMapCube.getTexHeight());
     glBindFramebuffer(GL_FRAMEBUFFER, envToCubeFBO);
 
     for (unsigned int i = 0; i < 6; ++i)
     {
-        glUniformMatrix4fv(glGetUniformLocation(latlongToCubeShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(envMapView[i]));
+        latlongToCubeShader.setMat4("view", envMapView[i]);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envMapCube.getTexID(), 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -1226,17 +1993,27 @@ void iblSetup()
     envMapCube.computeTexMipmap();
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    StartupReport::endPhase();
+    Profiler::endZone();
 
     // Diffuse irradiance capture
-    glGenFramebuffers(1, &irradianceFBO);
-    glGenRenderbuffers(1, &irradianceRBO);
+    Profiler::beginZone("IBL Irradiance", true);
+    StartupReport::beginPhase("IBL Irradiance", envMapHDR->getTexName(), true);
+    if (irradianceFBO == 0)
+    {
+        glGenFramebuffers(1, &irradianceFBO);
+        glGenRenderbuffers(1, &irradianceRBO);
+        ResourceRegistry::addFramebuffer(irradianceFBO, "IBL Irradiance");
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, irradianceFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, irradianceRBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, envMapIrradiance.getTexWidth(), envMapIrradiance.getTexHeight());
+    ResourceRegistry::addRenderbuffer(irradianceRBO, GL_DEPTH_COMPONENT24, envMapIrradiance.getTexWidth(), envMapIrradiance.getTexHeight(), "IBL Irradiance");
 
     irradianceIBLShader.useShader();
 
-    glUniformMatrix4fv(glGetUniformLocation(irradianceIBLShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(envMapProjection));
+    irradianceIBLShader.setMat4("projection", envMapProjection);
     glActiveTexture(GL_TEXTURE0);
     envMapCube.useTexture();
 
@@ -1245,7 +2022,7 @@ void iblSetup()
 
     for (unsigned int i = 0; i < 6; ++i)
     {
-        glUniformMatrix4fv(glGetUniformLocation(irradianceIBLShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(envMapView[i]));
+        irradianceIBLShader.setMat4("view", envMapView[i]);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envMapIrradiance.getTexID(), 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -1253,15 +2030,24 @@ void iblSetup()
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    StartupReport::endPhase();
+    Profiler::endZone();
 
     // Prefilter cubemap
+    Profiler::beginZone("IBL Prefilter", true);
+    StartupReport::beginPhase("IBL Prefilter", envMapHDR->getTexName(), true);
     prefilterIBLShader.useShader();
 
-    glUniformMatrix4fv(glGetUniformLocation(prefilterIBLShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(envMapProjection));
+    prefilterIBLShader.setMat4("projection", envMapProjection);
     envMapCube.useTexture();
 
-    glGenFramebuffers(1, &prefilterFBO);
-    glGenRenderbuffers(1, &prefilterRBO);
+    if (prefilterFBO == 0)
+    {
+        glGenFramebuffers(1, &prefilterFBO);
+        glGenRenderbuffers(1, &prefilterRBO);
+        ResourceRegistry::addFramebuffer(prefilterFBO, "IBL Prefilter");
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, prefilterFBO);
 
     unsigned int maxMipLevels = 5;
@@ -1276,6 +2062,7 @@ void iblSetup()
         // Bind the renderbuffer and set its storage for the current mipmap level
         glBindRenderbuffer(GL_RENDERBUFFER, prefilterRBO);
         glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
+        ResourceRegistry::addRenderbuffer(prefilterRBO, GL_DEPTH_COMPONENT24, mipWidth, mipHeight, "IBL Prefilter");
 
         // Set the viewport size for rendering the current mipmap level
         glViewport(0, 0, mipWidth, mipHeight);
@@ -1284,15 +2071,15 @@ void iblSetup()
         float roughness = static_cast<float>(mip) / static_cast<float>(maxMipLevels - 1);
 
         // Set uniform values for the shader
-        glUniform1f(glGetUniformLocation(prefilterIBLShader.Program, "roughness"), roughness);
-        glUniform1f(glGetUniformLocation(prefilterIBLShader.Program, "cubeResolutionWidth"), envMapPrefilter.getTexWidth());
-        glUniform1f(glGetUniformLocation(prefilterIBLShader.Program, "cubeResolutionHeight"), envMapPrefilter.getTexHeight());
+        prefilterIBLShader.setFloat("roughness", roughness);
+        prefilterIBLShader.setFloat("cubeResolutionWidth", envMapPrefilter.getTexWidth());
+        prefilterIBLShader.setFloat("cubeResolutionHeight", envMapPrefilter.getTexHeight());
 
         // Loop over all six faces of the cubemap
         for (unsigned int i = 0; i < 6; ++i)
         {
             // Set the view matrix for the current face of the cubemap
-            glUniformMatrix4fv(glGetUniformLocation(prefilterIBLShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(envMapView[i]));
+            prefilterIBLShader.setMat4("view", envMapView[i]);
             // Attach the texture for the current mipmap level and face
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envMapPrefilter.getTexID(), mip);
 
@@ -1305,13 +2092,23 @@ void iblSetup()
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    StartupReport::endPhase();
+    Profiler::endZone();
 
     // BRDF LUT
-    glGenFramebuffers(1, &brdfLUTFBO);
-    glGenRenderbuffers(1, &brdfLUTRBO);
+    Profiler::beginZone("IBL BRDF LUT", true);
+    StartupReport::beginPhase("IBL BRDF LUT", envMapHDR->getTexName(), true);
+    if (brdfLUTFBO == 0)
+    {
+        glGenFramebuffers(1, &brdfLUTFBO);
+        glGenRenderbuffers(1, &brdfLUTRBO);
+        ResourceRegistry::addFramebuffer(brdfLUTFBO, "IBL BRDF LUT");
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, brdfLUTFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, brdfLUTRBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, envMapLUT.getTexWidth(), envMapLUT.getTexHeight());
+    ResourceRegistry::addRenderbuffer(brdfLUTRBO, GL_DEPTH_COMPONENT24, envMapLUT.getTexWidth(), envMapLUT.getTexHeight(), "IBL BRDF LUT");
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, envMapLUT.getTexID(), 0);
 
     glViewport(0, 0, envMapLUT.getTexWidth(), envMapLUT.getTexHeight());
@@ -1321,6 +2118,8 @@ void iblSetup()
     quadRender.drawShape();
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    StartupReport::endPhase();
+    Profiler::endZone();
 
     glViewport(0, 0, WIDTH, HEIGHT);
 }
@@ -0,0 +1,387 @@
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+#include <glad/glad.h>
+
+#include "profiler.h"
+#include "glstats.h"
+
+
+// Oldest events are dropped past this point so an always-on profiler stays bounded
+const size_t traceEventCapacity = 200000;
+
+// GPU samples are drained every frame by whoever tabulates them, the rest only needs a little slack
+const size_t gpuSampleCapacity = 4096;
+
+
+void Profiler::setProfiler(GLuint frameLatency)
+{
+    startTime = std::chrono::steady_clock::now();
+    mainThread = std::this_thread::get_id();
+    traceThreads[mainThread] = 1;
+
+    gpuTimer.setTimer(frameLatency);
+
+    // Line the GPU timestamp clock up with the CPU clock for the trace timeline
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    gpuClockOffset = (GLint64)(getTime() * 1000.0) - gpuNow;
+}
+
+
+void Profiler::releaseProfiler()
+{
+    gpuTimer.releaseTimer();
+}
+
+
+void Profiler::beginFrame()
+{
+    gpuTimer.beginFrame();
+
+    frameZones.clear();
+    inFrame = true;
+
+    GLStats::beginFrame();
+    beginZone("Frame", false);
+}
+
+
+void Profiler::endFrame()
+{
+    endZone();
+    GLStats::endFrame();
+
+    inFrame = false;
+    lastFrameZones.swap(frameZones);
+
+    gpuTimer.endFrame();
+
+    emitGPUEvents();
+}
+
+
+void Profiler::resolveGPU()
+{
+    // Picks up frames still in flight, e.g. after a glFinish at the end of a run
+    gpuTimer.resolveFrames();
+
+    emitGPUEvents();
+}
+
+
+void Profiler::emitGPUEvents()
+{
+    // GPU results land a few frames late: every readback is emitted once, oldest frame first
+    GPUTimerSample timerSample;
+
+    while (gpuTimer.popSample(timerSample))
+    {
+        GLfloat gpuTime = timerSample.stopTime < timerSample.startTime ? 0.0f : (timerSample.stopTime - timerSample.startTime) / 1000000.0;
+
+        ProfilerTraceEvent event;
+        event.eventName = gpuTimer.getPassName(timerSample.passID);
+        event.eventStart = (GLint64)(timerSample.startTime + gpuClockOffset) / 1000.0;
+        event.eventDuration = gpuTime * 1000.0;
+        event.eventThread = 0;
+
+        // Kept for per-frame tables as well, bounded when nobody reads them
+        ProfilerGPUSample sample;
+        sample.zoneName = event.eventName;
+        sample.frameIndex = timerSample.frameIndex;
+        sample.gpuTime = gpuTime;
+
+        std::lock_guard<std::mutex> lock(profilerMutex);
+        addTraceEvent(event);
+        gpuSamples.push_back(sample);
+
+        if (gpuSamples.size() > gpuSampleCapacity)
+            gpuSamples.pop_front();
+    }
+}
+
+
+void Profiler::beginZone(const std::string& zoneName, bool zoneGPU)
+{
+    OpenZone zone;
+    zone.zoneRecord.zoneName = zoneName;
+    zone.zoneRecord.zoneDepth = getZoneStack().size();
+    zone.zoneRecord.zoneGPUPass = -1;
+    zone.frameSlot = -1;
+
+    bool frameZone = inFrame && std::this_thread::get_id() == mainThread;
+
+    // GPU zones only make sense inside a frame, where their timer slot gets retired
+    if (zoneGPU && frameZone)
+    {
+        std::map<std::string, GLuint>::iterator pass = gpuPasses.find(zoneName);
+
+        if (pass == gpuPasses.end())
+        {
+            pass = gpuPasses.insert(std::make_pair(zoneName, gpuTimer.addPass(zoneName))).first;
+        }
+
+        zone.zoneRecord.zoneGPUPass = pass->second;
+        gpuTimer.beginPass(pass->second);
+    }
+
+    if (frameZone)
+    {
+        zone.frameSlot = frameZones.size();
+        frameZones.push_back(zone.zoneRecord);
+
+        // GL call counts are broken down by pass, the zones right under the frame
+        if (zone.zoneRecord.zoneDepth == 1)
+            GLStats::beginPass(zoneName);
+    }
+
+    zone.zoneRecord.cpuStart = getTime();
+    getZoneStack().push_back(zone);
+}
+
+
+void Profiler::endZone()
+{
+    std::vector<OpenZone>& zoneStack = getZoneStack();
+
+    if (zoneStack.empty())
+        return;
+
+    OpenZone zone = zoneStack.back();
+    zoneStack.pop_back();
+
+    zone.zoneRecord.cpuStop = getTime();
+
+    if (zone.zoneRecord.zoneGPUPass >= 0)
+        gpuTimer.endPass(zone.zoneRecord.zoneGPUPass);
+
+    if (zone.frameSlot >= 0 && zone.frameSlot < (GLint)frameZones.size())
+        frameZones[zone.frameSlot] = zone.zoneRecord;
+
+    if (zone.frameSlot >= 0 && zone.zoneRecord.zoneDepth == 1)
+        GLStats::endPass();
+
+    ProfilerTraceEvent event;
+    event.eventName = zone.zoneRecord.zoneName;
+    event.eventStart = zone.zoneRecord.cpuStart;
+    event.eventDuration = zone.zoneRecord.cpuStop - zone.zoneRecord.cpuStart;
+
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    event.eventThread = getTraceThread();
+    addTraceEvent(event);
+}
+
+
+bool Profiler::dumpTrace(const std::string& tracePath)
+{
+    std::ofstream traceFile(tracePath.c_str());
+
+    if (!traceFile.is_open())
+    {
+        std::cerr << "PROFILER - FAILED WRITING TRACE : " << tracePath << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profilerMutex);
+
+    traceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    traceFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+    for (std::map<std::thread::id, GLuint>::iterator it = traceThreads.begin(); it != traceThreads.end(); ++it)
+    {
+        traceFile << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << it->second
+                  << ",\"args\":{\"name\":\"" << (it->second == 1 ? "Main" : "Worker") << "\"}}";
+    }
+
+    traceFile.setf(std::ios::fixed);
+    traceFile.precision(3);
+
+    for (size_t i = 0; i < traceEvents.size(); ++i)
+    {
+        const ProfilerTraceEvent& event = traceEvents[i];
+
+        // Zone names are plain identifiers or asset paths, only quotes and backslashes need escaping
+        std::string eventName;
+        for (size_t c = 0; c < event.eventName.size(); ++c)
+        {
+            if (event.eventName[c] == '"' || event.eventName[c] == '\\')
+                eventName += '\\';
+            eventName += event.eventName[c];
+        }
+
+        traceFile << ",\n{\"name\":\"" << eventName << "\",\"cat\":\"" << (event.eventThread == 0 ? "gpu" : "cpu")
+                  << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.eventThread
+                  << ",\"ts\":" << event.eventStart << ",\"dur\":" << event.eventDuration << "}";
+    }
+
+    traceFile << "\n]}\n";
+
+    std::cout << "PROFILER - TRACE WRITTEN : " << tracePath << " (" << traceEvents.size() << " events)" << std::endl;
+
+    return true;
+}
+
+
+double Profiler::getTime()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+
+GLuint64 Profiler::getFrameCount()
+{
+    return gpuTimer.getFrameCount();
+}
+
+
+GLuint Profiler::getGPULatency()
+{
+    // Every GPU zone is read back from the same retired frame, the first one is representative
+    if (gpuTimer.getPassCount() == 0)
+        return 0;
+
+    return gpuTimer.getPassLatency(0);
+}
+
+
+GLuint64 Profiler::getDroppedFrames()
+{
+    return gpuTimer.getDroppedFrames();
+}
+
+
+const std::vector<ProfilerZoneRecord>& Profiler::getFrameZones()
+{
+    return lastFrameZones;
+}
+
+
+GLfloat Profiler::getZoneCPUTime(const std::string& zoneName)
+{
+    // Zones opened several times in a frame add up
+    GLfloat zoneTime = 0.0f;
+
+    for (GLuint i = 0; i < lastFrameZones.size(); ++i)
+    {
+        if (lastFrameZones[i].zoneName == zoneName)
+            zoneTime += (lastFrameZones[i].cpuStop - lastFrameZones[i].cpuStart) / 1000.0;
+    }
+
+    return zoneTime;
+}
+
+
+GLfloat Profiler::getZoneGPUTime(const std::string& zoneName)
+{
+    std::map<std::string, GLuint>::iterator pass = gpuPasses.find(zoneName);
+
+    if (pass == gpuPasses.end())
+        return 0.0f;
+
+    return gpuTimer.getPassTime(pass->second);
+}
+
+
+GLfloat Profiler::getZoneGPUTime(const ProfilerZoneRecord& zone)
+{
+    if (zone.zoneGPUPass < 0)
+        return 0.0f;
+
+    return gpuTimer.getPassTime(zone.zoneGPUPass);
+}
+
+
+bool Profiler::isZoneGPUResolved(const std::string& zoneName)
+{
+    std::map<std::string, GLuint>::iterator pass = gpuPasses.find(zoneName);
+
+    return pass != gpuPasses.end() && gpuTimer.isPassResolved(pass->second);
+}
+
+
+GLuint64 Profiler::getZoneGPUFrame(const std::string& zoneName)
+{
+    std::map<std::string, GLuint>::iterator pass = gpuPasses.find(zoneName);
+
+    if (pass == gpuPasses.end())
+        return 0;
+
+    return gpuTimer.getPassFrame(pass->second);
+}
+
+
+bool Profiler::popGPUSample(ProfilerGPUSample& sample)
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+
+    if (gpuSamples.empty())
+        return false;
+
+    sample = gpuSamples.front();
+    gpuSamples.pop_front();
+
+    return true;
+}
+
+
+std::vector<Profiler::OpenZone>& Profiler::getZoneStack()
+{
+    static thread_local std::vector<OpenZone> zoneStack;
+
+    return zoneStack;
+}
+
+
+GLuint Profiler::getTraceThread()
+{
+    std::map<std::thread::id, GLuint>::iterator thread = traceThreads.find(std::this_thread::get_id());
+
+    if (thread == traceThreads.end())
+        thread = traceThreads.insert(std::make_pair(std::this_thread::get_id(), (GLuint)traceThreads.size() + 2)).first;
+
+    return thread->second;
+}
+
+
+void Profiler::addTraceEvent(const ProfilerTraceEvent& event)
+{
+    traceEvents.push_back(event);
+
+    if (traceEvents.size() > traceEventCapacity)
+        traceEvents.pop_front();
+}
+
+
+ProfilerZone::ProfilerZone(const std::string& zoneName, bool zoneGPU)
+{
+    Profiler::beginZone(zoneName, zoneGPU);
+}
+
+
+ProfilerZone::~ProfilerZone()
+{
+    Profiler::endZone();
+}
+
+
+// Static member initialization
+GPUTimer Profiler::gpuTimer;
+std::map<std::string, GLuint> Profiler::gpuPasses;
+std::deque<ProfilerGPUSample> Profiler::gpuSamples;
+std::vector<ProfilerZoneRecord> Profiler::frameZones;
+std::vector<ProfilerZoneRecord> Profiler::lastFrameZones;
+std::deque<ProfilerTraceEvent> Profiler::traceEvents;
+std::map<std::thread::id, GLuint> Profiler::traceThreads;
+std::chrono::steady_clock::time_point Profiler::startTime = std::chrono::steady_clock::now();
+std::thread::id Profiler::mainThread = std::this_thread::get_id();
+std::mutex Profiler::profilerMutex;
+GLint64 Profiler::gpuClockOffset = 0;
+std::atomic<bool> Profiler::inFrame(false);
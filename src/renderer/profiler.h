@@ -0,0 +1,106 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+#include <glad/glad.h>
+
+#include "gputimer.h"
+
+
+// One zone recorded during the last completed frame, in the order it was opened
+struct ProfilerZoneRecord
+{
+    std::string zoneName;
+    GLuint zoneDepth;
+    GLint zoneGPUPass;          // GPUTimer pass of the zone, -1 for CPU-only zones
+    double cpuStart, cpuStop;   // Microseconds since the profiler was set
+};
+
+
+// Completed zone kept for the trace export
+struct ProfilerTraceEvent
+{
+    std::string eventName;
+    double eventStart, eventDuration;   // Microseconds since the profiler was set
+    GLuint eventThread;                 // 0 is the GPU timeline
+};
+
+
+// GPU time of one zone in the frame that issued it, read back a few frames later
+struct ProfilerGPUSample
+{
+    std::string zoneName;
+    GLuint64 frameIndex;
+    GLfloat gpuTime;                    // Milliseconds
+};
+
+
+// Hierarchical CPU + GPU zone profiler. Zones nest per thread, GPU zones reuse
+// the non-blocking GPUTimer ring, and everything can be dumped as a
+// chrome://tracing / Perfetto JSON file.
+class Profiler
+{
+    public:
+        static void setProfiler(GLuint frameLatency);
+        static void releaseProfiler();
+        static void beginFrame();
+        static void endFrame();
+        static void resolveGPU();
+        static void beginZone(const std::string& zoneName, bool zoneGPU);
+        static void endZone();
+        static bool dumpTrace(const std::string& tracePath);
+        static double getTime();
+        static GLuint64 getFrameCount();
+        static GLuint getGPULatency();
+        static GLuint64 getDroppedFrames();
+        static const std::vector<ProfilerZoneRecord>& getFrameZones();
+        static GLfloat getZoneCPUTime(const std::string& zoneName);
+        static GLfloat getZoneGPUTime(const std::string& zoneName);
+        static GLfloat getZoneGPUTime(const ProfilerZoneRecord& zone);
+        static bool isZoneGPUResolved(const std::string& zoneName);
+        static GLuint64 getZoneGPUFrame(const std::string& zoneName);
+        static bool popGPUSample(ProfilerGPUSample& sample);
+
+    private:
+        struct OpenZone
+        {
+            ProfilerZoneRecord zoneRecord;
+            GLint frameSlot;            // Index into frameZones, -1 when not part of a frame
+        };
+
+        static GPUTimer gpuTimer;
+        static std::map<std::string, GLuint> gpuPasses;
+        static std::deque<ProfilerGPUSample> gpuSamples;
+        static std::vector<ProfilerZoneRecord> frameZones, lastFrameZones;
+        static std::deque<ProfilerTraceEvent> traceEvents;
+        static std::map<std::thread::id, GLuint> traceThreads;
+        static std::chrono::steady_clock::time_point startTime;
+        static std::thread::id mainThread;
+        static std::mutex profilerMutex;
+        static GLint64 gpuClockOffset;
+        static std::atomic<bool> inFrame;     // Read by loader threads opening their own zones
+
+        static std::vector<OpenZone>& getZoneStack();
+        static GLuint getTraceThread();
+        static void addTraceEvent(const ProfilerTraceEvent& event);
+        static void emitGPUEvents();
+};
+
+
+// Scoped zone: opens on construction, closes when it goes out of scope
+class ProfilerZone
+{
+    public:
+        ProfilerZone(const std::string& zoneName, bool zoneGPU = false);
+        ~ProfilerZone();
+};
+
+#endif
@@ -0,0 +1,362 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+
+#include <glad/glad.h>
+
+#include "resourceregistry.h"
+#include "texturecompressor.h"
+
+
+std::map<std::pair<GLuint, GLuint>, ResourceRecord> ResourceRegistry::resources;
+std::vector<std::string> ResourceRegistry::ownerStack;
+
+
+// Largest first, the list is read to find what to trim
+static bool isLargerResource(const ResourceRecord& a, const ResourceRecord& b)
+{
+    return a.deviceBytes + a.hostBytes > b.deviceBytes + b.hostBytes;
+}
+
+
+void ResourceRegistry::addTexture(GLuint texID, GLenum internalFormat, GLuint width, GLuint height, GLuint layers, bool mipmapped, const std::string& owner)
+{
+    ResourceRecord record;
+    record.resourceType = RESOURCE_TEXTURE;
+    record.resourceID = texID;
+    record.resourceFormat = internalFormat;
+    record.resourceWidth = width;
+    record.resourceHeight = height;
+    record.resourceLayers = layers;
+    record.resourceLevels = 1;
+    record.hostBytes = 0;
+
+    // Every level down to 1x1 when mipmapped
+    GLuint levelWidth = width, levelHeight = height;
+
+    while (mipmapped && (levelWidth > 1 || levelHeight > 1))
+    {
+        levelWidth = std::max(levelWidth / 2, 1u);
+        levelHeight = std::max(levelHeight / 2, 1u);
+        record.resourceLevels++;
+    }
+
+    record.deviceBytes = getTextureBytes(internalFormat, width, height, layers, record.resourceLevels);
+
+    addResource(record, owner);
+}
+
+
+void ResourceRegistry::addRenderbuffer(GLuint renderbufferID, GLenum internalFormat, GLuint width, GLuint height, const std::string& owner)
+{
+    ResourceRecord record;
+    record.resourceType = RESOURCE_RENDERBUFFER;
+    record.resourceID = renderbufferID;
+    record.resourceFormat = internalFormat;
+    record.resourceWidth = width;
+    record.resourceHeight = height;
+    record.resourceLayers = 1;
+    record.resourceLevels = 1;
+    record.deviceBytes = (GLuint64)width * height * getTexelBytes(internalFormat);
+    record.hostBytes = 0;
+
+    addResource(record, owner);
+}
+
+
+void ResourceRegistry::addBuffer(GLuint bufferID, GLenum target, GLuint64 bufferBytes, GLuint64 hostBytes, const std::string& owner)
+{
+    ResourceRecord record;
+    record.resourceType = RESOURCE_BUFFER;
+    record.resourceID = bufferID;
+    record.resourceFormat = target;
+    record.resourceWidth = 0;
+    record.resourceHeight = 0;
+    record.resourceLayers = 1;
+    record.resourceLevels = 1;
+    record.deviceBytes = bufferBytes;
+    record.hostBytes = hostBytes;
+
+    addResource(record, owner);
+}
+
+
+void ResourceRegistry::addFramebuffer(GLuint framebufferID, const std::string& owner)
+{
+    // Framebuffers hold no storage of their own, their attachments are counted separately
+    ResourceRecord record;
+    record.resourceType = RESOURCE_FRAMEBUFFER;
+    record.resourceID = framebufferID;
+    record.resourceFormat = GL_NONE;
+    record.resourceWidth = 0;
+    record.resourceHeight = 0;
+    record.resourceLayers = 1;
+    record.resourceLevels = 1;
+    record.deviceBytes = 0;
+    record.hostBytes = 0;
+
+    addResource(record, owner);
+}
+
+
+void ResourceRegistry::removeResource(ResourceType type, GLuint resourceID)
+{
+    resources.erase(std::make_pair((GLuint)type, resourceID));
+}
+
+
+void ResourceRegistry::beginOwner(const std::string& owner)
+{
+    ownerStack.push_back(owner);
+}
+
+
+void ResourceRegistry::endOwner()
+{
+    if (!ownerStack.empty())
+        ownerStack.pop_back();
+}
+
+
+ResourceTotals ResourceRegistry::getTotals(ResourceType type)
+{
+    ResourceTotals totals;
+    totals.resourceCount = 0;
+    totals.deviceBytes = 0;
+    totals.hostBytes = 0;
+
+    for (std::map<std::pair<GLuint, GLuint>, ResourceRecord>::iterator it = resources.begin(); it != resources.end(); ++it)
+    {
+        if (it->second.resourceType != type)
+            continue;
+
+        totals.resourceCount++;
+        totals.deviceBytes += it->second.deviceBytes;
+        totals.hostBytes += it->second.hostBytes;
+    }
+
+    return totals;
+}
+
+
+ResourceTotals ResourceRegistry::getTotals()
+{
+    ResourceTotals totals;
+    totals.resourceCount = resources.size();
+    totals.deviceBytes = 0;
+    totals.hostBytes = 0;
+
+    for (std::map<std::pair<GLuint, GLuint>, ResourceRecord>::iterator it = resources.begin(); it != resources.end(); ++it)
+    {
+        totals.deviceBytes += it->second.deviceBytes;
+        totals.hostBytes += it->second.hostBytes;
+    }
+
+    return totals;
+}
+
+
+GLuint64 ResourceRegistry::getDeviceBytes(ResourceType type, GLuint resourceID)
+{
+    std::map<std::pair<GLuint, GLuint>, ResourceRecord>::iterator record = resources.find(std::make_pair((GLuint)type, resourceID));
+
+    return record != resources.end() ? record->second.deviceBytes : 0;
+}
+
+
+std::vector<ResourceRecord> ResourceRegistry::getResources()
+{
+    std::vector<ResourceRecord> records;
+
+    for (std::map<std::pair<GLuint, GLuint>, ResourceRecord>::iterator it = resources.begin(); it != resources.end(); ++it)
+        records.push_back(it->second);
+
+    std::sort(records.begin(), records.end(), isLargerResource);
+
+    return records;
+}
+
+
+const char* ResourceRegistry::getTypeName(ResourceType type)
+{
+    switch (type)
+    {
+        case RESOURCE_TEXTURE: return "Textures";
+        case RESOURCE_RENDERBUFFER: return "Renderbuffers";
+        case RESOURCE_BUFFER: return "Buffers";
+        case RESOURCE_FRAMEBUFFER: return "Framebuffers";
+        default: return "Unknown";
+    }
+}
+
+
+std::string ResourceRegistry::getFormatName(GLenum format)
+{
+    switch (format)
+    {
+        case GL_RED: return "R8";
+        case GL_RGB: return "RGB8";
+        case GL_RGBA: return "RGBA8";
+        case GL_RGBA8: return "RGBA8";
+        case GL_SRGB8: return "SRGB8";
+        case GL_SRGB8_ALPHA8: return "SRGBA8";
+        case GL_RG16F: return "RG16F";
+        case GL_RGB16F: return "RGB16F";
+        case GL_RGBA16F: return "RGBA16F";
+        case GL_RGB32F: return "RGB32F";
+        case GL_RGBA32F: return "RGBA32F";
+        case GL_R11F_G11F_B10F: return "RG11B10F";
+        case GL_RGB9_E5: return "RGB9E5";
+        case GL_DEPTH_COMPONENT: return "DEPTH";
+        case GL_DEPTH_COMPONENT24: return "DEPTH24";
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return "BC1";
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return "BC3";
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT: return "BC1 SRGB";
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: return "BC3 SRGB";
+        case GL_COMPRESSED_RED_RGTC1: return "BC4";
+        case GL_COMPRESSED_RG_RGTC2: return "BC5";
+        case GL_ARRAY_BUFFER: return "VERTEX";
+        case GL_ELEMENT_ARRAY_BUFFER: return "INDEX";
+        case GL_UNIFORM_BUFFER: return "UNIFORM";
+        case GL_PIXEL_UNPACK_BUFFER: return "UNPACK";
+        case GL_NONE: return "-";
+        default:
+        {
+            char formatName[16];
+            std::snprintf(formatName, sizeof(formatName), "0x%04X", format);
+            return formatName;
+        }
+    }
+}
+
+
+bool ResourceRegistry::getResource(ResourceType type, GLuint resourceID, ResourceRecord& record)
+{
+    std::map<std::pair<GLuint, GLuint>, ResourceRecord>::iterator existing = resources.find(std::make_pair((GLuint)type, resourceID));
+
+    if (existing == resources.end())
+        return false;
+
+    record = existing->second;
+
+    return true;
+}
+
+
+GLuint64 ResourceRegistry::getTextureBytes(GLenum internalFormat, GLuint width, GLuint height, GLuint layers, GLuint levels)
+{
+    // Also prices a texture in a format it does not have, to compare layouts
+    GLuint64 textureBytes = 0;
+    GLuint levelWidth = width, levelHeight = height;
+
+    for (GLuint level = 0; level < levels; ++level)
+    {
+        textureBytes += getLevelBytes(internalFormat, levelWidth, levelHeight) * layers;
+        levelWidth = std::max(levelWidth / 2, 1u);
+        levelHeight = std::max(levelHeight / 2, 1u);
+    }
+
+    return textureBytes;
+}
+
+
+GLuint ResourceRegistry::reportLeaks()
+{
+    std::vector<ResourceRecord> records = getResources();
+
+    if (records.empty())
+    {
+        std::cout << "RESOURCES - NO LEAKS" << std::endl;
+        return 0;
+    }
+
+    ResourceTotals totals = getTotals();
+
+    std::cerr << "RESOURCES - " << records.size() << " LEAKED (" << totals.deviceBytes / 1024 << " KB video, "
+              << totals.hostBytes / 1024 << " KB host)" << std::endl;
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        std::fprintf(stderr, "  %-14s %5u  %-8s %5ux%-5u %10llu B  %s\n", getTypeName(records[i].resourceType), records[i].resourceID,
+                     getFormatName(records[i].resourceFormat).c_str(), records[i].resourceWidth, records[i].resourceHeight,
+                     (unsigned long long)records[i].deviceBytes, records[i].resourceOwner.c_str());
+    }
+
+    return records.size();
+}
+
+
+GLuint ResourceRegistry::getTexelBytes(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+        case GL_RED: return 1;
+        case GL_RGB: return 3;
+        case GL_RGBA: return 4;
+        case GL_RGBA8: return 4;
+        case GL_SRGB8: return 3;
+        case GL_SRGB8_ALPHA8: return 4;
+        case GL_RG16F: return 4;
+        case GL_RGB16F: return 6;
+        case GL_RGBA16F: return 8;
+        case GL_RGB32F: return 12;
+        case GL_RGBA32F: return 16;
+        case GL_R11F_G11F_B10F: return 4;
+        case GL_RGB9_E5: return 4;
+        case GL_DEPTH_COMPONENT: return 4;     // Stored as D24X8 or D32 by every driver we run on
+        case GL_DEPTH_COMPONENT24: return 4;
+        default: return 4;
+    }
+}
+
+
+GLuint64 ResourceRegistry::getLevelBytes(GLenum internalFormat, GLuint width, GLuint height)
+{
+    // Block-compressed formats store 4x4 texel blocks, the small levels still take a whole one
+    switch (internalFormat)
+    {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_RG_RGTC2:
+            return (GLuint64)((width + 3) / 4) * ((height + 3) / 4) * TextureCompressor::getBlockBytes(internalFormat);
+        default:
+            return (GLuint64)width * height * getTexelBytes(internalFormat);
+    }
+}
+
+
+void ResourceRegistry::addResource(ResourceRecord& record, const std::string& owner)
+{
+    std::pair<GLuint, GLuint> key = std::make_pair((GLuint)record.resourceType, record.resourceID);
+    std::map<std::pair<GLuint, GLuint>, ResourceRecord>::iterator existing = resources.find(key);
+
+    // Storage re-specified on a live object keeps its owner unless a new one is given
+    if (!owner.empty())
+        record.resourceOwner = owner;
+    else if (!ownerStack.empty())
+        record.resourceOwner = ownerStack.back();
+    else if (existing != resources.end())
+        record.resourceOwner = existing->second.resourceOwner;
+    else
+        record.resourceOwner = "Unowned";
+
+    resources[key] = record;
+}
+
+
+ResourceOwner::ResourceOwner(const std::string& owner)
+{
+    ResourceRegistry::beginOwner(owner);
+}
+
+
+ResourceOwner::~ResourceOwner()
+{
+    ResourceRegistry::endOwner();
+}
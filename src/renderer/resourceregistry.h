@@ -0,0 +1,83 @@
+#ifndef RESOURCEREGISTRY_H
+#define RESOURCEREGISTRY_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <glad/glad.h>
+
+
+enum ResourceType
+{
+    RESOURCE_TEXTURE,
+    RESOURCE_RENDERBUFFER,
+    RESOURCE_BUFFER,
+    RESOURCE_FRAMEBUFFER,
+    RESOURCE_TYPE_COUNT
+};
+
+
+// One live GL object and the memory it accounts for
+struct ResourceRecord
+{
+    ResourceType resourceType;
+    GLuint resourceID;
+    std::string resourceOwner;
+    GLenum resourceFormat;                      // Internal format of textures and renderbuffers, target of buffers
+    GLuint resourceWidth, resourceHeight;
+    GLuint resourceLayers, resourceLevels;      // 6 layers for cube maps, full chain when mipmapped
+    GLuint64 deviceBytes;                       // Estimated video memory, from the texel or block size of the format
+    GLuint64 hostBytes;                         // CPU copy kept alive next to it (mesh vertices and indices)
+};
+
+
+struct ResourceTotals
+{
+    GLuint resourceCount;
+    GLuint64 deviceBytes, hostBytes;
+};
+
+
+// Bookkeeping of every texture, renderbuffer, buffer and framebuffer the engine
+// creates. Creation sites register what they allocate, deletion sites remove it,
+// so whatever is still registered once everything is released at shutdown leaked.
+class ResourceRegistry
+{
+    public:
+        static void addTexture(GLuint texID, GLenum internalFormat, GLuint width, GLuint height, GLuint layers, bool mipmapped, const std::string& owner = "");
+        static void addRenderbuffer(GLuint renderbufferID, GLenum internalFormat, GLuint width, GLuint height, const std::string& owner = "");
+        static void addBuffer(GLuint bufferID, GLenum target, GLuint64 bufferBytes, GLuint64 hostBytes, const std::string& owner = "");
+        static void addFramebuffer(GLuint framebufferID, const std::string& owner = "");
+        static void removeResource(ResourceType type, GLuint resourceID);
+        static void beginOwner(const std::string& owner);
+        static void endOwner();
+        static ResourceTotals getTotals(ResourceType type);
+        static ResourceTotals getTotals();
+        static GLuint64 getDeviceBytes(ResourceType type, GLuint resourceID);
+        static std::vector<ResourceRecord> getResources();
+        static const char* getTypeName(ResourceType type);
+        static std::string getFormatName(GLenum format);
+        static bool getResource(ResourceType type, GLuint resourceID, ResourceRecord& record);
+        static GLuint64 getTextureBytes(GLenum internalFormat, GLuint width, GLuint height, GLuint layers, GLuint levels);
+        static GLuint getTexelBytes(GLenum internalFormat);
+        static GLuint reportLeaks();
+
+    private:
+        static std::map<std::pair<GLuint, GLuint>, ResourceRecord> resources;
+        static std::vector<std::string> ownerStack;
+
+        static GLuint64 getLevelBytes(GLenum internalFormat, GLuint width, GLuint height);
+        static void addResource(ResourceRecord& record, const std::string& owner);
+};
+
+
+// Scoped owner: resources registered without an explicit owner are attributed to it
+class ResourceOwner
+{
+    public:
+        ResourceOwner(const std::string& owner);
+        ~ResourceOwner();
+};
+
+#endif
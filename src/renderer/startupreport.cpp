@@ -0,0 +1,292 @@
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <thread>
+
+#include <glad/glad.h>
+
+#include "startupreport.h"
+
+
+std::vector<StartupPhaseRecord> StartupReport::phaseRecords;
+std::vector<GLuint> StartupReport::openPhases;
+std::chrono::steady_clock::time_point StartupReport::startTime;
+double StartupReport::firstFrameTime = 0.0;
+double StartupReport::budgetTime = 0.0;
+std::string StartupReport::reportPath = "luminaria_startup.json";
+bool StartupReport::startupActive = false;
+std::thread::id StartupReport::startupThread;
+
+
+// Asset names are file paths, only quotes and backslashes need escaping
+static std::string getJSONString(const std::string& value)
+{
+    std::string escaped;
+
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        if (value[i] == '"' || value[i] == '\\')
+            escaped += '\\';
+        escaped += value[i];
+    }
+
+    return "\"" + escaped + "\"";
+}
+
+
+// Slowest first, whichever of the CPU and GPU sides took longer
+static bool isSlowerPhase(const StartupPhaseRecord& a, const StartupPhaseRecord& b)
+{
+    return std::max(a.cpuTime, a.gpuTime) > std::max(b.cpuTime, b.gpuTime);
+}
+
+
+bool StartupReport::isStartupOption(const std::string& arg)
+{
+    return arg == "--startup-budget" || arg == "--startup-report";
+}
+
+
+bool StartupReport::setStartupReport(int argc, char* argv[])
+{
+    // Only startup options are read here, the benchmark parser handles the rest
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc) && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+
+        if (arg == "--startup-budget" && hasValue)
+            budgetTime = std::atof(argv[++i]);
+        else if (arg == "--startup-report" && hasValue)
+            reportPath = argv[++i];
+    }
+
+    if (budgetTime < 0.0)
+    {
+        std::cerr << "STARTUP - INVALID BUDGET : " << budgetTime << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+void StartupReport::beginStartup()
+{
+    startTime = std::chrono::steady_clock::now();
+    phaseRecords.clear();
+    openPhases.clear();
+    firstFrameTime = 0.0;
+    startupActive = true;
+    startupThread = std::this_thread::get_id();
+}
+
+
+void StartupReport::endStartup()
+{
+    // Called after every presented frame, only the first one closes the report
+    if (!startupActive)
+        return;
+
+    firstFrameTime = getTime();
+    startupActive = false;
+    openPhases.clear();
+
+    resolveGPU();
+    printSummary();
+    writeReport();
+}
+
+
+bool StartupReport::isActive()
+{
+    return startupActive;
+}
+
+
+bool StartupReport::isWithinBudget()
+{
+    return budgetTime <= 0.0 || firstFrameTime <= budgetTime;
+}
+
+
+double StartupReport::getTimeToFirstFrame()
+{
+    return firstFrameTime;
+}
+
+
+void StartupReport::beginPhase(const std::string& phaseName, const std::string& assetName, bool phaseGPU)
+{
+    // Loads triggered once the first frame is out (UI, benchmark scripts) are left to the profiler
+    if (std::this_thread::get_id() != startupThread || !startupActive)
+        return;
+
+    StartupPhaseRecord record;
+    record.phaseName = phaseName;
+    record.assetName = assetName;
+    record.phaseDepth = openPhases.size();
+    record.cpuStart = getTime();
+    record.cpuTime = 0.0;
+    record.gpuQueries[0] = 0;
+    record.gpuQueries[1] = 0;
+    record.gpuTime = 0.0;
+
+    // GPU work is queued, timestamps are only read back once the first frame is presented
+    if (phaseGPU)
+    {
+        glGenQueries(2, record.gpuQueries);
+        glQueryCounter(record.gpuQueries[0], GL_TIMESTAMP);
+    }
+
+    openPhases.push_back(phaseRecords.size());
+    phaseRecords.push_back(record);
+}
+
+
+void StartupReport::endPhase()
+{
+    if (std::this_thread::get_id() != startupThread || openPhases.empty())
+        return;
+
+    StartupPhaseRecord& record = phaseRecords[openPhases.back()];
+    openPhases.pop_back();
+
+    record.cpuTime = getTime() - record.cpuStart;
+
+    if (record.gpuQueries[1] != 0)
+        glQueryCounter(record.gpuQueries[1], GL_TIMESTAMP);
+}
+
+
+double StartupReport::getTime()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+
+void StartupReport::resolveGPU()
+{
+    // The first frame has been swapped, every startup query is at most a few frames from retiring
+    for (size_t i = 0; i < phaseRecords.size(); ++i)
+    {
+        StartupPhaseRecord& record = phaseRecords[i];
+
+        if (record.gpuQueries[0] == 0)
+            continue;
+
+        GLuint64 gpuStart = 0, gpuStop = 0;
+        glGetQueryObjectui64v(record.gpuQueries[0], GL_QUERY_RESULT, &gpuStart);
+        glGetQueryObjectui64v(record.gpuQueries[1], GL_QUERY_RESULT, &gpuStop);
+        glDeleteQueries(2, record.gpuQueries);
+
+        record.gpuTime = gpuStop > gpuStart ? (gpuStop - gpuStart) / 1000000.0 : 0.0;
+    }
+}
+
+
+void StartupReport::printSummary()
+{
+    // Totals per phase, in the order the phases first ran
+    std::vector<std::string> phaseNames;
+    std::vector<GLuint> phaseCounts;
+    std::vector<double> phaseCPUTimes, phaseGPUTimes;
+    double topLevelTime = 0.0;
+
+    for (size_t i = 0; i < phaseRecords.size(); ++i)
+    {
+        const StartupPhaseRecord& record = phaseRecords[i];
+        size_t phase = std::find(phaseNames.begin(), phaseNames.end(), record.phaseName) - phaseNames.begin();
+
+        if (phase == phaseNames.size())
+        {
+            phaseNames.push_back(record.phaseName);
+            phaseCounts.push_back(0);
+            phaseCPUTimes.push_back(0.0);
+            phaseGPUTimes.push_back(0.0);
+        }
+
+        phaseCounts[phase]++;
+        phaseCPUTimes[phase] += record.cpuTime;
+        phaseGPUTimes[phase] += record.gpuTime;
+
+        if (record.phaseDepth == 0)
+            topLevelTime += record.cpuTime;
+    }
+
+    std::cout << "STARTUP - TIME TO FIRST FRAME : " << firstFrameTime << " ms";
+    if (budgetTime > 0.0)
+        std::cout << " (budget " << budgetTime << " ms)";
+    std::cout << std::endl;
+
+    std::printf("  %-22s %6s %10s %10s\n", "Phase", "Count", "CPU (ms)", "GPU (ms)");
+
+    for (size_t i = 0; i < phaseNames.size(); ++i)
+        std::printf("  %-22s %6u %10.3f %10.3f\n", phaseNames[i].c_str(), phaseCounts[i], phaseCPUTimes[i], phaseGPUTimes[i]);
+
+    // Context creation, render target setup and the first frame itself
+    std::printf("  %-22s %6s %10.3f\n", "Untracked", "", std::max(firstFrameTime - topLevelTime, 0.0));
+
+    std::vector<StartupPhaseRecord> slowestPhases = phaseRecords;
+    std::sort(slowestPhases.begin(), slowestPhases.end(), isSlowerPhase);
+
+    std::cout << "STARTUP - SLOWEST ASSETS" << std::endl;
+
+    for (size_t i = 0; i < slowestPhases.size() && i < 10; ++i)
+        std::printf("  %-22s %10.3f %10.3f  %s\n", slowestPhases[i].phaseName.c_str(), slowestPhases[i].cpuTime,
+                    slowestPhases[i].gpuTime, slowestPhases[i].assetName.c_str());
+
+    if (!isWithinBudget())
+        std::cerr << "STARTUP - BUDGET EXCEEDED : " << firstFrameTime << " ms > " << budgetTime << " ms" << std::endl;
+}
+
+
+bool StartupReport::writeReport()
+{
+    std::ofstream reportFile(reportPath.c_str());
+
+    if (!reportFile.is_open())
+    {
+        std::cerr << "STARTUP - FAILED WRITING REPORT : " << reportPath << std::endl;
+        return false;
+    }
+
+    reportFile.setf(std::ios::fixed);
+    reportFile.precision(3);
+
+    reportFile << "{\n\"timeToFirstFrame\":" << firstFrameTime << ",\n";
+    reportFile << "\"budget\":" << budgetTime << ",\n";
+    reportFile << "\"withinBudget\":" << (isWithinBudget() ? "true" : "false") << ",\n";
+    reportFile << "\"phases\":[";
+
+    for (size_t i = 0; i < phaseRecords.size(); ++i)
+    {
+        const StartupPhaseRecord& record = phaseRecords[i];
+
+        reportFile << (i == 0 ? "\n" : ",\n") << "{\"phase\":" << getJSONString(record.phaseName)
+                   << ",\"asset\":" << getJSONString(record.assetName) << ",\"depth\":" << record.phaseDepth
+                   << ",\"start\":" << record.cpuStart << ",\"cpu\":" << record.cpuTime << ",\"gpu\":" << record.gpuTime << "}";
+    }
+
+    reportFile << "\n]\n}\n";
+
+    std::cout << "STARTUP - REPORT WRITTEN : " << reportPath << std::endl;
+
+    return true;
+}
+
+
+StartupPhase::StartupPhase(const std::string& phaseName, const std::string& assetName, bool phaseGPU)
+{
+    StartupReport::beginPhase(phaseName, assetName, phaseGPU);
+}
+
+
+StartupPhase::~StartupPhase()
+{
+    StartupReport::endPhase();
+}
@@ -0,0 +1,64 @@
+#ifndef STARTUPREPORT_H
+#define STARTUPREPORT_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+#include <glad/glad.h>
+
+
+// One timed step of loading an asset: "Decode" of a texture, "Link" of a shader...
+struct StartupPhaseRecord
+{
+    std::string phaseName, assetName;
+    GLuint phaseDepth;
+    double cpuStart, cpuTime;   // Milliseconds since startup began
+    GLuint gpuQueries[2];       // GL_TIMESTAMP pair around the phase, 0 for CPU-only phases
+    double gpuTime;             // Milliseconds, filled in when the first frame is presented
+};
+
+
+// Cold-start breakdown: every loading phase is timed per asset until the first
+// frame is presented, then summarized on the console, written as JSON and
+// checked against the time-to-first-frame budget. Only the thread that started
+// up records phases.
+class StartupReport
+{
+    public:
+        static bool isStartupOption(const std::string& arg);
+        static bool setStartupReport(int argc, char* argv[]);
+        static void beginStartup();
+        static void endStartup();
+        static bool isActive();
+        static bool isWithinBudget();
+        static double getTimeToFirstFrame();
+        static void beginPhase(const std::string& phaseName, const std::string& assetName, bool phaseGPU);
+        static void endPhase();
+
+    private:
+        static std::vector<StartupPhaseRecord> phaseRecords;
+        static std::vector<GLuint> openPhases;
+        static std::chrono::steady_clock::time_point startTime;
+        static double firstFrameTime, budgetTime;
+        static std::string reportPath;
+        static bool startupActive;
+        static std::thread::id startupThread;      // Phases timed on loader threads overlap the startup, they are left out
+
+        static double getTime();
+        static void resolveGPU();
+        static void printSummary();
+        static bool writeReport();
+};
+
+
+// Scoped phase: opens on construction, closes when it goes out of scope
+class StartupPhase
+{
+    public:
+        StartupPhase(const std::string& phaseName, const std::string& assetName, bool phaseGPU = false);
+        ~StartupPhase();
+};
+
+#endif
@@ -39,25 +39,17 @@ void Skybox::renderToShader(Shader& shaderSkybox, glm::mat4& projection, glm::ma
     glActiveTexture(GL_TEXTURE0);
     this->texSkybox.useTexture();
 
-    // Set shader uniforms
-    GLint envMapLoc = glGetUniformLocation(shaderSkybox.Program, "envMap");
-    GLint inverseViewLoc = glGetUniformLocation(shaderSkybox.Program, "inverseView");
-    GLint inverseProjLoc = glGetUniformLocation(shaderSkybox.Program, "inverseProj");
-    GLint apertureLoc = glGetUniformLocation(shaderSkybox.Program, "cameraAperture");
-    GLint shutterSpeedLoc = glGetUniformLocation(shaderSkybox.Program, "cameraShutterSpeed");
-    GLint isoLoc = glGetUniformLocation(shaderSkybox.Program, "cameraISO");
-
     // Pass texture unit to the shader
-    glUniform1i(envMapLoc, 0);
+    shaderSkybox.setInt("envMap", 0);
 
     // Pass matrices to the shader
-    glUniformMatrix4fv(inverseViewLoc, 1, GL_FALSE, glm::value_ptr(glm::transpose(view)));
-    glUniformMatrix4fv(inverseProjLoc, 1, GL_FALSE, glm::value_ptr(glm::inverse(projection)));
+    shaderSkybox.setMat4("inverseView", glm::transpose(view));
+    shaderSkybox.setMat4("inverseProj", glm::inverse(projection));
 
     // Pass camera settings to the shader
-    glUniform1f(apertureLoc, this->cameraAperture);
-    glUniform1f(shutterSpeedLoc, this->cameraShutterSpeed);
-    glUniform1f(isoLoc, this->cameraISO);
+    shaderSkybox.setFloat("cameraAperture", this->cameraAperture);
+    shaderSkybox.setFloat("cameraShutterSpeed", this->cameraShutterSpeed);
+    shaderSkybox.setFloat("cameraISO", this->cameraISO);
 }
 
 void Skybox::setExposure(GLfloat aperture, GLfloat shutterSpeed, GLfloat iso)
@@ -0,0 +1,123 @@
+#include <string>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "filemapping.h"
+
+
+FileMapping::FileMapping()
+{
+    this->mapData = NULL;
+    this->mapSize = 0;
+#ifdef _WIN32
+    this->fileHandle = INVALID_HANDLE_VALUE;
+    this->mappingHandle = NULL;
+#endif
+}
+
+
+FileMapping::~FileMapping()
+{
+    this->unmapFile();
+}
+
+
+bool FileMapping::mapFile(const std::string& filePath)
+{
+    this->unmapFile();
+
+#ifdef _WIN32
+    LARGE_INTEGER fileSize;
+
+    this->fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (this->fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        this->unmapFile();
+        return false;
+    }
+
+    this->mappingHandle = CreateFileMappingA(this->fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    this->mapData = this->mappingHandle != NULL ? (const unsigned char*)MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+    if (this->mapData == NULL)
+    {
+        this->unmapFile();
+        return false;
+    }
+
+    this->mapSize = (size_t)fileSize.QuadPart;
+#else
+    int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    struct stat fileInfo;
+
+    if (fileDescriptor < 0)
+        return false;
+
+    if (fstat(fileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0)
+    {
+        close(fileDescriptor);
+        return false;
+    }
+
+    // The descriptor is not needed once mapped, the pages stay readable until the mapping goes away
+    void* fileData = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+
+    if (fileData == MAP_FAILED)
+        return false;
+
+    // Cooked files are read front to back exactly once, the kernel can read ahead
+    madvise(fileData, fileInfo.st_size, MADV_SEQUENTIAL);
+
+    this->mapData = (const unsigned char*)fileData;
+    this->mapSize = fileInfo.st_size;
+#endif
+
+    return true;
+}
+
+
+void FileMapping::unmapFile()
+{
+#ifdef _WIN32
+    if (this->mapData != NULL)
+        UnmapViewOfFile(this->mapData);
+
+    if (this->mappingHandle != NULL)
+        CloseHandle(this->mappingHandle);
+
+    if (this->fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(this->fileHandle);
+
+    this->fileHandle = INVALID_HANDLE_VALUE;
+    this->mappingHandle = NULL;
+#else
+    if (this->mapData != NULL)
+        munmap((void*)this->mapData, this->mapSize);
+#endif
+
+    this->mapData = NULL;
+    this->mapSize = 0;
+}
+
+
+const unsigned char* FileMapping::getData()
+{
+    return this->mapData;
+}
+
+
+size_t FileMapping::getSize()
+{
+    return this->mapSize;
+}
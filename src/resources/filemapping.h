@@ -0,0 +1,31 @@
+#ifndef FILEMAPPING_H
+#define FILEMAPPING_H
+
+#include <string>
+#include <cstddef>
+
+
+// Read-only mapping of a whole file, its pages are read in as the data is touched
+class FileMapping
+{
+    public:
+        FileMapping();
+        ~FileMapping();
+        bool mapFile(const std::string& filePath);
+        void unmapFile();
+        const unsigned char* getData();
+        size_t getSize();
+
+    private:
+        const unsigned char* mapData;
+        size_t mapSize;
+#ifdef _WIN32
+        void* fileHandle;
+        void* mappingHandle;
+#endif
+
+        FileMapping(const FileMapping&);
+        FileMapping& operator=(const FileMapping&);
+};
+
+#endif
@@ -58,8 +58,7 @@ void Material::renderToShader()
         currentTex.useTexture();
 
         // Set the texture uniform
-        GLint uniformLocation = glGetUniformLocation(this->matShader.Program, currentUniformName.c_str());
-        glUniform1i(uniformLocation, i);
+        this->matShader.setInt(currentUniformName, i);
 
         // Log separator for clarity
         std::cout << "------" << std::endl;
@@ -2,15 +2,151 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 #include "shader.h"
+#include "startupreport.h"
+#include "framestats.h"
+#include "uniformbuffer.h"
 
 
-Shader::Shader()
+// Pastes #include "file" lines in place, paths are relative to the including file
+static std::string resolveIncludes(const std::string& source, const std::string& sourcePath, GLuint includeDepth)
 {
+    std::string directory = sourcePath.substr(0, sourcePath.find_last_of("/\\") + 1);
+    std::istringstream sourceStream(source);
+    std::string line, resolved;
+    GLuint lineNumber = 0;
+
+    while (std::getline(sourceStream, line))
+    {
+        lineNumber++;
+
+        size_t directive = line.find("#include");
+
+        if (directive == std::string::npos || line.find_first_not_of(" \t") != directive)
+        {
+            resolved += line + "\n";
+            continue;
+        }
+
+        size_t nameStart = line.find('"');
+        size_t nameEnd = nameStart == std::string::npos ? nameStart : line.find('"', nameStart + 1);
+        std::string includePath = nameEnd == std::string::npos ? "" : directory + line.substr(nameStart + 1, nameEnd - nameStart - 1);
+        std::ifstream includeFile(includePath.c_str());
+
+        if (includePath.empty() || !includeFile.is_open() || includeDepth >= 8)
+        {
+            std::cerr << "ERROR::SHADER::INCLUDE_FAILED: " << sourcePath << ":" << lineNumber << " " << line << std::endl;
+            resolved += "\n";
+            continue;
+        }
+
+        std::stringstream includeStream;
+        includeStream << includeFile.rdbuf();
+
+        // Compiler messages past the include keep the line numbers of the including file
+        resolved += resolveIncludes(includeStream.str(), includePath, includeDepth + 1);
+        resolved += "#line " + std::to_string(lineNumber + 1) + "\n";
+    }
+
+    return resolved;
+}
+
+
+// Feature defines go right after #version, which has to stay the first line
+static std::string getVariantSource(const std::string& source, const std::vector<std::string>& defines)
+{
+    size_t versionEnd = source.find('\n', source.find("#version"));
+
+    if (defines.empty() || versionEnd == std::string::npos)
+        return source;
+
+    std::string defineLines;
+
+    for (size_t i = 0; i < defines.size(); ++i)
+        defineLines += "#define " + defines[i] + "\n";
+
+    // Compiler messages keep the line numbers of the file
+    return source.substr(0, versionEnd + 1) + defineLines + "#line 2\n" + source.substr(versionEnd + 1);
+}
+
+
+// GL_KHR_parallel_shader_compile is not part of the glad profile, its one entry point is loaded by hand
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+
+// Samplers of different types may not share a texture unit in a draw
+static bool isSamplerType(GLenum uniformType)
+{
+    switch (uniformType)
+    {
+        case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+        case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+bool Shader::binaryCacheEnabled = true;
+std::string Shader::binaryCacheDir = "cache/shaders";
+
+
+// 64-bit FNV-1a, chained through the seed to hash several strings as one key
+static GLuint64 getFNV1aHash(const std::string& data, GLuint64 seed = 14695981039346656037ULL)
+{
+    GLuint64 hash = seed;
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
 
+    return hash;
+}
+
+
+static bool makeDirectory(const std::string& dirPath)
+{
+#ifdef _WIN32
+    _mkdir(dirPath.c_str());
+#else
+    mkdir(dirPath.c_str(), 0755);
+#endif
+
+    // Already existing directories are fine, anything else shows up when writing
+    return true;
+}
+
+
+Shader::Shader()
+{
+    this->Program = 0;
+    this->activeVariant = NULL;
+    this->previousVariant = NULL;
 }
 
 
@@ -20,17 +156,18 @@ Shader::~Shader()
 }
 
 
-void Shader::setShader(const GLchar* vertexPath, const GLchar* fragmentPath)
+void Shader::setShader(const GLchar* vertexPath, const GLchar* fragmentPath, const std::vector<std::string>& defines)
 {
     // Shaders reading
-    std::string vertexCode;
-    std::string fragmentCode;
     std::ifstream vShaderFile;
     std::ifstream fShaderFile;
 
     vShaderFile.exceptions(std::ifstream::badbit);
     fShaderFile.exceptions(std::ifstream::badbit);
 
+    // Programs are named after their fragment shader, vertex shaders are shared between them
+    StartupReport::beginPhase("Shader Read", fragmentPath, false);
+
     try
     {
         // Open vertex and fragment shader files
@@ -52,9 +189,9 @@ void Shader::setShader(const GLchar* vertexPath, const GLchar* fragmentPath)
         vShaderFile.close();
         fShaderFile.close();
 
-        // Convert the string streams to string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        // Convert the string streams to string, shared declarations are included in place
+        this->vertexCode = resolveIncludes(vShaderStream.str(), vertexPath, 0);
+        this->fragmentCode = resolveIncludes(fShaderStream.str(), fragmentPath, 0);
     }
     catch (std::ifstream::failure& e)
     {
@@ -62,61 +199,650 @@ void Shader::setShader(const GLchar* vertexPath, const GLchar* fragmentPath)
         std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
     }
 
-    // Convert the shader code strings to C-style strings
-    const GLchar* vShaderCode = vertexCode.c_str();
-    const GLchar* fShaderCode = fragmentCode.c_str();
+    StartupReport::endPhase();
 
-    // Shaders compilation
-    GLuint vertex, fragment;
-    GLint success;
-    GLchar infoLog[512];
+    this->vertexPath = vertexPath;
+    this->fragmentPath = fragmentPath;
+
+    // Variants of a previous load were built from stale sources
+    for (std::map<std::string, ShaderVariant>::iterator it = this->variants.begin(); it != this->variants.end(); ++it)
+        glDeleteProgram(it->second.variantProgram);
+
+    this->variants.clear();
+    this->pendingUniforms.clear();
+    this->activeVariant = NULL;
+    this->previousVariant = NULL;
+    this->Program = 0;
+
+    // Only the variant asked for is submitted, others follow on their first setVariant.
+    // Nothing waits on the driver here, the status is read when the program is first used.
+    setVariant(defines);
+}
 
-    // Compile Vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
 
-    // Check for compilation errors
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success)
+void Shader::setVariant(const std::vector<std::string>& defines)
+{
+    // Callers always list the defines in the same order, the joined list is the key
+    std::string variantKey;
+
+    for (size_t i = 0; i < defines.size(); ++i)
+        variantKey += (i == 0 ? "" : " ") + defines[i];
+
+    std::map<std::string, ShaderVariant>::iterator variant = this->variants.find(variantKey);
+
+    if (variant != this->variants.end() && &variant->second == this->activeVariant)
+        return;
+
+    // The variant switched away from has to be usable as a source of uniform values
+    if (this->activeVariant && this->activeVariant->variantPending)
+        finishVariant();
+
+    this->previousVariant = this->activeVariant;
+
+    if (variant != this->variants.end())
     {
-        glGetShaderInfoLog(vertex, sizeof(infoLog), NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        this->activeVariant = &variant->second;
+        this->Program = variant->second.variantProgram;
+        return;
     }
 
-    // Compile Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
+    buildVariant(variantKey, defines);
+}
+
+
+void Shader::useShader()
+{
+    if (this->activeVariant && this->activeVariant->variantPending)
+        finishVariant();
+
+    glUseProgram(this->Program);
+}
+
+
+bool Shader::hasUniform(const std::string& uniformName) const
+{
+    return this->activeVariant && this->activeVariant->uniformIndices.find(uniformName) != this->activeVariant->uniformIndices.end();
+}
+
+
+GLint Shader::getUniformLocation(const std::string& uniformName) const
+{
+    if (!this->activeVariant)
+        return -1;
+
+    std::unordered_map<std::string, GLuint>::const_iterator index = this->activeVariant->uniformIndices.find(uniformName);
+
+    return index != this->activeVariant->uniformIndices.end() ? this->activeVariant->uniforms[index->second].uniformLocation : -1;
+}
+
+
+void Shader::buildVariant(const std::string& variantKey, const std::vector<std::string>& defines)
+{
+    std::string vertexSource = getVariantSource(this->vertexCode, defines);
+    std::string fragmentSource = getVariantSource(this->fragmentCode, defines);
+    std::string variantName = this->fragmentPath + (variantKey.empty() ? "" : " [" + variantKey + "]");
 
-    // Check for compilation errors
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success)
+    // Binaries are only valid for the exact sources and driver they were built with
+    std::string cachePath;
+
+    if (isBinaryCacheSupported())
     {
-        glGetShaderInfoLog(fragment, sizeof(infoLog), NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        const char* driverStrings[] = { (const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION) };
+        GLuint64 cacheKey = getFNV1aHash(vertexSource, getFNV1aHash(fragmentSource));
+
+        for (GLuint i = 0; i < 3; ++i)
+            cacheKey = getFNV1aHash(driverStrings[i] ? driverStrings[i] : "", cacheKey);
+
+        char cacheName[32];
+        std::snprintf(cacheName, sizeof(cacheName), "/%016llx.bin", (unsigned long long)cacheKey);
+        cachePath = binaryCacheDir + cacheName;
     }
 
+    ShaderVariant& variant = this->variants[variantKey];
+    variant.variantShaders[0] = 0;
+    variant.variantShaders[1] = 0;
+    variant.variantPending = true;
+    variant.variantName = variantName;
+    variant.variantDefines = defines;
+    variant.variantCachePath = cachePath;
 
-    // Shader Program
     this->Program = glCreateProgram();
+    variant.variantProgram = this->Program;
+    this->activeVariant = &variant;
+
+    variant.variantBinary = !cachePath.empty() && loadProgramBinary(cachePath, variantName.c_str());
+
+    if (!variant.variantBinary)
+        submitProgram(variant, vertexSource, fragmentSource);
+}
+
+
+void Shader::finishVariant()
+{
+    ShaderVariant& variant = *this->activeVariant;
+    variant.variantPending = false;
+
+    // Blocks until the driver is done compiling and linking, whatever ran since the
+    // submission (other shaders, texture decoding, model import) overlapped with it
+    GLint success = 0;
+
+    StartupReport::beginPhase("Shader Wait", variant.variantName, false);
+    glGetProgramiv(this->Program, GL_LINK_STATUS, &success);
+    StartupReport::endPhase();
+
+    // A driver update or a corrupted file is rejected at load, the program is rebuilt from source
+    if (!success && variant.variantBinary)
+    {
+        glDeleteProgram(this->Program);
+        this->Program = glCreateProgram();
+        variant.variantProgram = this->Program;
+        variant.variantBinary = false;
+
+        submitProgram(variant, getVariantSource(this->vertexCode, variant.variantDefines), getVariantSource(this->fragmentCode, variant.variantDefines));
+
+        StartupReport::beginPhase("Shader Wait", variant.variantName, false);
+        glGetProgramiv(this->Program, GL_LINK_STATUS, &success);
+        StartupReport::endPhase();
+    }
+
+    if (!variant.variantBinary && checkProgram(variant, success) && !variant.variantCachePath.empty())
+        saveProgramBinary(variant.variantCachePath);
+
+    reflectUniforms();
+
+    // Values set once at load (sampler units...) carry over, callers see a single shader
+    copyUniforms();
+
+    warmUpShader(variant.variantName.c_str());
+
+    // Toggling a feature for the first time compiles in the middle of a frame
+    if (!StartupReport::isActive())
+        FrameStats::addEvent("Shader variant " + variant.variantName);
+}
+
+
+void Shader::copyUniforms()
+{
+    const ShaderVariant* previousVariant = this->previousVariant;
+
+    glUseProgram(this->Program);
+
+    // Values the active variant could not take are the most recent ones for their name
+    for (std::unordered_map<std::string, ShaderUniform>::iterator it = this->pendingUniforms.begin(); it != this->pendingUniforms.end(); ++it)
+        copyUniform(it->first, it->second);
+
+    // Then the last active variant, the others fill in what its linker dropped
+    if (previousVariant)
+    {
+        for (std::unordered_map<std::string, GLuint>::const_iterator it = previousVariant->uniformIndices.begin(); it != previousVariant->uniformIndices.end(); ++it)
+            copyUniform(it->first, previousVariant->uniforms[it->second]);
+    }
+
+    for (std::map<std::string, ShaderVariant>::iterator variant = this->variants.begin(); variant != this->variants.end(); ++variant)
+    {
+        if (&variant->second == previousVariant || &variant->second == this->activeVariant)
+            continue;
+
+        for (std::unordered_map<std::string, GLuint>::iterator it = variant->second.uniformIndices.begin(); it != variant->second.uniformIndices.end(); ++it)
+            copyUniform(it->first, variant->second.uniforms[it->second]);
+    }
+
+    glUseProgram(0);
+}
+
+
+void Shader::copyUniform(const std::string& uniformName, const ShaderUniform& sourceUniform)
+{
+    std::unordered_map<std::string, GLuint>::iterator index = this->activeVariant->uniformIndices.find(uniformName);
+
+    if (!sourceUniform.uniformSet || index == this->activeVariant->uniformIndices.end())
+        return;
+
+    // Array names alias their first element, each uniform is only uploaded once.
+    // Pending values were never reflected, their type is taken from the new variant.
+    ShaderUniform& uniform = this->activeVariant->uniforms[index->second];
+
+    if (uniform.uniformSet || (sourceUniform.uniformType != GL_NONE && uniform.uniformType != sourceUniform.uniformType))
+        return;
+
+    std::memcpy(uniform.uniformValue, sourceUniform.uniformValue, sizeof(uniform.uniformValue));
+    uniform.uniformSet = true;
+
+    switch (uniform.uniformType)
+    {
+        case GL_FLOAT: glUniform1fv(uniform.uniformLocation, 1, uniform.uniformValue); break;
+        case GL_FLOAT_VEC2: glUniform2fv(uniform.uniformLocation, 1, uniform.uniformValue); break;
+        case GL_FLOAT_VEC3: glUniform3fv(uniform.uniformLocation, 1, uniform.uniformValue); break;
+        case GL_FLOAT_VEC4: glUniform4fv(uniform.uniformLocation, 1, uniform.uniformValue); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(uniform.uniformLocation, 1, GL_FALSE, uniform.uniformValue); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(uniform.uniformLocation, 1, GL_FALSE, uniform.uniformValue); break;
+        default:
+        {
+            // Integers, booleans and samplers, stored bitwise by setInt
+            GLint intValue;
+            std::memcpy(&intValue, uniform.uniformValue, sizeof(intValue));
+            glUniform1i(uniform.uniformLocation, intValue);
+            break;
+        }
+    }
+}
+
+
+void Shader::setBool(const std::string& uniformName, bool value)
+{
+    setInt(uniformName, value ? 1 : 0);
+}
+
+
+void Shader::setInt(const std::string& uniformName, GLint value)
+{
+    ShaderUniform* uniform = getChangedUniform(uniformName, &value, sizeof(value));
+
+    if (uniform)
+        glUniform1i(uniform->uniformLocation, value);
+}
+
+
+void Shader::setFloat(const std::string& uniformName, GLfloat value)
+{
+    ShaderUniform* uniform = getChangedUniform(uniformName, &value, sizeof(value));
+
+    if (uniform)
+        glUniform1f(uniform->uniformLocation, value);
+}
+
+
+void Shader::setVec2(const std::string& uniformName, const glm::vec2& value)
+{
+    ShaderUniform* uniform = getChangedUniform(uniformName, glm::value_ptr(value), sizeof(value));
+
+    if (uniform)
+        glUniform2f(uniform->uniformLocation, value.x, value.y);
+}
+
+
+void Shader::setVec3(const std::string& uniformName, const glm::vec3& value)
+{
+    ShaderUniform* uniform = getChangedUniform(uniformName, glm::value_ptr(value), sizeof(value));
+
+    if (uniform)
+        glUniform3f(uniform->uniformLocation, value.x, value.y, value.z);
+}
+
+
+void Shader::setVec4(const std::string& uniformName, const glm::vec4& value)
+{
+    ShaderUniform* uniform = getChangedUniform(uniformName, glm::value_ptr(value), sizeof(value));
+
+    if (uniform)
+        glUniform4f(uniform->uniformLocation, value.x, value.y, value.z, value.w);
+}
+
+
+void Shader::setMat3(const std::string& uniformName, const glm::mat3& value)
+{
+    ShaderUniform* uniform = getChangedUniform(uniformName, glm::value_ptr(value), sizeof(value));
+
+    if (uniform)
+        glUniformMatrix3fv(uniform->uniformLocation, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+
+void Shader::setMat4(const std::string& uniformName, const glm::mat4& value)
+{
+    ShaderUniform* uniform = getChangedUniform(uniformName, glm::value_ptr(value), sizeof(value));
+
+    if (uniform)
+        glUniformMatrix4fv(uniform->uniformLocation, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+
+void Shader::reflectUniforms()
+{
+    // Locations are looked up once per link, setters only go through the table afterwards
+    std::vector<ShaderUniform>& uniforms = this->activeVariant->uniforms;
+    std::unordered_map<std::string, GLuint>& uniformIndices = this->activeVariant->uniformIndices;
+
+    uniforms.clear();
+    uniformIndices.clear();
+
+    GLint uniformCount = 0, maxNameLength = 0;
+    glGetProgramiv(this->Program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(this->Program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<GLchar> nameBuffer(std::max(maxNameLength, 1));
+
+    for (GLint i = 0; i < uniformCount; ++i)
+    {
+        GLint arraySize = 0;
+        GLenum uniformType = GL_NONE;
+        glGetActiveUniform(this->Program, i, nameBuffer.size(), NULL, &arraySize, &uniformType, &nameBuffer[0]);
+
+        std::string uniformName = &nameBuffer[0];
+        GLint uniformLocation = glGetUniformLocation(this->Program, uniformName.c_str());
+
+        // Uniform block members have no location of their own, they are fed by the shared buffers
+        if (uniformLocation < 0)
+            continue;
+
+        // Arrays are reported as "name[0]", every element gets its own entry and "name" aliases the first one
+        std::string baseName = uniformName;
+        if (arraySize > 1 || (baseName.size() > 3 && baseName.compare(baseName.size() - 3, 3, "[0]") == 0))
+            baseName = baseName.substr(0, baseName.size() - 3);
+
+        for (GLint element = 0; element < arraySize; ++element)
+        {
+            ShaderUniform uniform;
+            uniform.uniformLocation = uniformLocation + element;
+            uniform.uniformType = uniformType;
+            uniform.uniformSet = false;
+            std::memset(uniform.uniformValue, 0, sizeof(uniform.uniformValue));
+
+            if (baseName != uniformName)
+                uniformIndices[baseName + "[" + std::to_string(element) + "]"] = uniforms.size();
+            if (element == 0)
+                uniformIndices[baseName] = uniforms.size();
+
+            uniforms.push_back(uniform);
+        }
+    }
+
+    // Shared blocks are pointed at their fixed binding point, the buffers stay bound there
+    GLint blockCount = 0, maxBlockNameLength = 0;
+    glGetProgramiv(this->Program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    glGetProgramiv(this->Program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+
+    std::vector<GLchar> blockNameBuffer(std::max(maxBlockNameLength, 1));
+
+    for (GLint i = 0; i < blockCount; ++i)
+    {
+        glGetActiveUniformBlockName(this->Program, i, blockNameBuffer.size(), NULL, &blockNameBuffer[0]);
+
+        GLint blockBinding = UniformBuffer::getBlockBinding(&blockNameBuffer[0]);
+
+        if (blockBinding < 0)
+        {
+            std::cerr << "ERROR::SHADER::UNKNOWN_UNIFORM_BLOCK: " << &blockNameBuffer[0] << std::endl;
+            continue;
+        }
+
+        glUniformBlockBinding(this->Program, i, blockBinding);
+    }
+}
+
+
+ShaderUniform* Shader::getChangedUniform(const std::string& uniformName, const void* value, size_t valueBytes)
+{
+    std::unordered_map<std::string, GLuint>::iterator index = this->activeVariant->uniformIndices.find(uniformName);
+
+    // Names the linker dropped are not uploaded, as glUniform* does with location -1,
+    // but are kept for the variants that do use them
+    if (index == this->activeVariant->uniformIndices.end())
+    {
+        ShaderUniform& pending = this->pendingUniforms[uniformName];
+        pending.uniformLocation = -1;
+        pending.uniformType = GL_NONE;
+        pending.uniformSet = true;
+        std::memset(pending.uniformValue, 0, sizeof(pending.uniformValue));
+        std::memcpy(pending.uniformValue, value, valueBytes);
+
+        return NULL;
+    }
+
+    ShaderUniform& uniform = this->activeVariant->uniforms[index->second];
+
+    if (uniform.uniformSet && std::memcmp(uniform.uniformValue, value, valueBytes) == 0)
+        return NULL;
+
+    std::memcpy(uniform.uniformValue, value, valueBytes);
+    uniform.uniformSet = true;
+
+    // A newer value than the one kept aside
+    if (!this->pendingUniforms.empty())
+        this->pendingUniforms.erase(uniformName);
+
+    return &uniform;
+}
+
+
+bool Shader::isShaderOption(const std::string& arg)
+{
+    return arg == "--shader-cache";
+}
+
+
+bool Shader::setShaderOptions(int argc, char* argv[])
+{
+    // Only shader cache options are read here, the benchmark parser handles the rest
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc) && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+
+        // Either the cache directory or "off" to always build from source
+        if (arg == "--shader-cache" && hasValue)
+        {
+            binaryCacheDir = argv[++i];
+            binaryCacheEnabled = binaryCacheDir != "off";
+        }
+    }
+
+    return true;
+}
+
+
+bool Shader::isBinaryCacheSupported()
+{
+    if (!binaryCacheEnabled || !glGetProgramBinary || !glProgramBinary || !glProgramParameteri)
+        return false;
+
+    // Some drivers expose the entry points without a single binary format
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+    return formatCount > 0;
+}
+
+
+void Shader::setParallelCompile()
+{
+    // Compiles and links then return right away, only the status queries wait on the driver threads
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = NULL;
+
+    if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+        maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+    else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+        maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+
+    if (!maxShaderCompilerThreads)
+    {
+        std::cout << "STARTUP - PARALLEL SHADER COMPILE : UNAVAILABLE" << std::endl;
+        return;
+    }
+
+    // All ones lets the driver pick its own thread count
+    maxShaderCompilerThreads(0xFFFFFFFF);
+
+    std::cout << "STARTUP - PARALLEL SHADER COMPILE : ENABLED" << std::endl;
+}
+
+
+void Shader::submitProgram(ShaderVariant& variant, const std::string& vertexSource, const std::string& fragmentSource)
+{
+    // Convert the shader code strings to C-style strings
+    const GLchar* vShaderCode = vertexSource.c_str();
+    const GLchar* fShaderCode = fragmentSource.c_str();
+
+    // Compile Vertex Shader, the status is checked once the program is needed
+    StartupReport::beginPhase("Shader Compile", this->vertexPath, false);
+    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &vShaderCode, NULL);
+    glCompileShader(vertex);
+    StartupReport::endPhase();
+
+    // Compile Fragment Shader
+    StartupReport::beginPhase("Shader Compile", variant.variantName, false);
+    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment, 1, &fShaderCode, NULL);
+    glCompileShader(fragment);
+    StartupReport::endPhase();
+
+
+    // Shader Program
+    StartupReport::beginPhase("Shader Link", variant.variantName, false);
     glAttachShader(this->Program, vertex);
     glAttachShader(this->Program, fragment);
+
+    // Has to be set before linking for the binary to be retrievable afterwards
+    if (glProgramParameteri)
+        glProgramParameteri(this->Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     glLinkProgram(this->Program);
-    glGetProgramiv(this->Program, GL_LINK_STATUS, &success);
+    StartupReport::endPhase();
+
+    variant.variantShaders[0] = vertex;
+    variant.variantShaders[1] = fragment;
+}
+
+
+bool Shader::checkProgram(ShaderVariant& variant, GLint linkStatus)
+{
+    // The link status has been read, the compile logs are available without waiting
+    const char* stageNames[2] = { "VERTEX", "FRAGMENT" };
+    GLint success;
+    GLchar infoLog[512];
+
+    for (GLuint i = 0; i < 2; ++i)
+    {
+        // Check for compilation errors
+        glGetShaderiv(variant.variantShaders[i], GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(variant.variantShaders[i], sizeof(infoLog), NULL, infoLog);
+            std::cerr << "ERROR::SHADER::" << stageNames[i] << "::COMPILATION_FAILED\n" << variant.variantName << "\n" << infoLog << std::endl;
+        }
+
+        glDetachShader(this->Program, variant.variantShaders[i]);
+        glDeleteShader(variant.variantShaders[i]);
+        variant.variantShaders[i] = 0;
+    }
 
-    if (!success)
+    if (!linkStatus)
     {
         glGetProgramInfoLog(this->Program, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    return linkStatus != 0;
 }
 
 
-void Shader::useShader()
+bool Shader::loadProgramBinary(const std::string& cachePath, const GLchar* fragmentPath)
+{
+    std::ifstream cacheFile(cachePath.c_str(), std::ios::binary);
+
+    if (!cacheFile.is_open())
+        return false;
+
+    StartupReport::beginPhase("Shader Cache Load", fragmentPath, false);
+
+    // Binary format enum followed by the driver blob
+    GLenum binaryFormat = 0;
+    cacheFile.read((char*)&binaryFormat, sizeof(binaryFormat));
+
+    std::vector<char> binary((std::istreambuf_iterator<char>(cacheFile)), std::istreambuf_iterator<char>());
+    bool submitted = false;
+
+    if (cacheFile.bad() || binary.empty())
+        std::cerr << "ERROR::SHADER::CACHE_READ_FAILED: " << cachePath << std::endl;
+    else
+    {
+        // Whether the driver accepts it is only known once the link status is read
+        glProgramBinary(this->Program, binaryFormat, &binary[0], binary.size());
+        submitted = true;
+    }
+
+    StartupReport::endPhase();
+
+    return submitted;
+}
+
+
+void Shader::saveProgramBinary(const std::string& cachePath)
+{
+    GLint binaryLength = 0;
+    glGetProgramiv(this->Program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+
+    if (binaryLength <= 0)
+        return;
+
+    std::vector<char> binary(binaryLength);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(this->Program, binaryLength, NULL, &binaryFormat, &binary[0]);
+
+    // Every level of the cache directory, "cache" then "cache/shaders"
+    for (size_t separator = binaryCacheDir.find('/', 1); separator != std::string::npos; separator = binaryCacheDir.find('/', separator + 1))
+        makeDirectory(binaryCacheDir.substr(0, separator));
+    makeDirectory(binaryCacheDir);
+
+    std::ofstream cacheFile(cachePath.c_str(), std::ios::binary);
+
+    if (!cacheFile.is_open())
+    {
+        std::cerr << "ERROR::SHADER::CACHE_WRITE_FAILED: " << cachePath << std::endl;
+        return;
+    }
+
+    cacheFile.write((const char*)&binaryFormat, sizeof(binaryFormat));
+    cacheFile.write(&binary[0], binary.size());
+}
+
+
+void Shader::warmUpShader(const GLchar* fragmentPath)
 {
+    // Drivers finish compiling on the first draw using a program, a degenerate
+    // triangle gets that done at load time without touching any pixel
+    StartupReport::beginPhase("Shader Warm-up", fragmentPath, false);
+
+    GLuint warmUpVAO;
+    glGenVertexArrays(1, &warmUpVAO);
+    glBindVertexArray(warmUpVAO);
     glUseProgram(this->Program);
+
+    // Sampler units are usually only assigned after the first use, until then they all
+    // point at unit 0 and a 2D and a cube sampler together would reject the draw
+    std::vector<ShaderUniform>& uniforms = this->activeVariant->uniforms;
+    GLint textureUnit = 0;
+
+    for (size_t i = 0; i < uniforms.size(); ++i)
+    {
+        if (isSamplerType(uniforms[i].uniformType))
+            glUniform1i(uniforms[i].uniformLocation, textureUnit++);
+    }
+
+    GLint validateStatus = 0;
+    glValidateProgram(this->Program);
+    glGetProgramiv(this->Program, GL_VALIDATE_STATUS, &validateStatus);
+
+    if (validateStatus)
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Units set before the warm-up, or the default one, are what the caller sees afterwards
+    for (size_t i = 0; i < uniforms.size(); ++i)
+    {
+        if (!isSamplerType(uniforms[i].uniformType))
+            continue;
+
+        GLint unitValue = 0;
+        if (uniforms[i].uniformSet)
+            std::memcpy(&unitValue, uniforms[i].uniformValue, sizeof(unitValue));
+
+        glUniform1i(uniforms[i].uniformLocation, unitValue);
+    }
+
+    glUseProgram(0);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &warmUpVAO);
+
+    StartupReport::endPhase();
 }
@@ -5,8 +5,37 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <map>
+#include <unordered_map>
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+
+
+// Active uniform of a linked program and the last value uploaded to it
+struct ShaderUniform
+{
+    GLint uniformLocation;
+    GLenum uniformType;
+    bool uniformSet;                // Nothing is assumed about the value until the first upload
+    GLfloat uniformValue[16];       // Integers are kept bitwise, a mat4 is the largest value
+};
+
+
+// One linked permutation of a shader, built for a set of #define feature flags
+struct ShaderVariant
+{
+    GLuint variantProgram;
+    GLuint variantShaders[2];               // Vertex and fragment, kept until the link status is read
+    bool variantPending;                    // Link submitted, the status is only read on first use
+    bool variantBinary;                     // Submitted from the binary cache rather than from source
+    std::string variantName;
+    std::vector<std::string> variantDefines;
+    std::string variantCachePath;
+    std::vector<ShaderUniform> uniforms;
+    std::unordered_map<std::string, GLuint> uniformIndices;
+};
 
 
 class Shader
@@ -16,8 +45,48 @@ class Shader
 
         Shader();
         ~Shader();
-        void setShader(const GLchar* vertexPath, const GLchar* fragmentPath);
+        static bool isShaderOption(const std::string& arg);
+        static bool setShaderOptions(int argc, char* argv[]);
+        static void setParallelCompile();
+        void setShader(const GLchar* vertexPath, const GLchar* fragmentPath, const std::vector<std::string>& defines = std::vector<std::string>());
+        void setVariant(const std::vector<std::string>& defines);
         void useShader();
+        bool hasUniform(const std::string& uniformName) const;
+        GLint getUniformLocation(const std::string& uniformName) const;
+
+        // The program has to be in use, uploads of the value already held are skipped
+        void setBool(const std::string& uniformName, bool value);
+        void setInt(const std::string& uniformName, GLint value);
+        void setFloat(const std::string& uniformName, GLfloat value);
+        void setVec2(const std::string& uniformName, const glm::vec2& value);
+        void setVec3(const std::string& uniformName, const glm::vec3& value);
+        void setVec4(const std::string& uniformName, const glm::vec4& value);
+        void setMat3(const std::string& uniformName, const glm::mat3& value);
+        void setMat4(const std::string& uniformName, const glm::mat4& value);
+
+    private:
+        static bool binaryCacheEnabled;
+        static std::string binaryCacheDir;      // Linked program binaries, keyed by source and driver
+
+        std::string vertexPath, fragmentPath;
+        std::string vertexCode, fragmentCode;   // Sources with includes resolved, defines are added per variant
+        std::map<std::string, ShaderVariant> variants;
+        ShaderVariant* activeVariant;           // Program and uniform tables the setters work on
+        ShaderVariant* previousVariant;         // Active before the last switch, first source of carried over values
+        std::unordered_map<std::string, ShaderUniform> pendingUniforms;     // Set while inactive in the current variant
+
+        static bool isBinaryCacheSupported();
+        void buildVariant(const std::string& variantKey, const std::vector<std::string>& defines);
+        void finishVariant();
+        void copyUniforms();
+        void copyUniform(const std::string& uniformName, const ShaderUniform& sourceUniform);
+        void submitProgram(ShaderVariant& variant, const std::string& vertexSource, const std::string& fragmentSource);
+        bool checkProgram(ShaderVariant& variant, GLint linkStatus);
+        bool loadProgramBinary(const std::string& cachePath, const GLchar* fragmentPath);
+        void saveProgramBinary(const std::string& cachePath);
+        void warmUpShader(const GLchar* fragmentPath);
+        void reflectUniforms();
+        ShaderUniform* getChangedUniform(const std::string& uniformName, const void* value, size_t valueBytes);
 };
 
 #endif
@@ -10,6 +10,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "shape.h"
+#include "resourceregistry.h"
 
 
 GLfloat cubeVertices[] =
@@ -110,6 +111,9 @@ void Shape::setShape(std::string type, glm::vec3 position)
     else if (type == "quad")
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
+    GLuint64 vertexBytes = type == "cube" ? sizeof(cubeVertices) : type == "plane" ? sizeof(planeVertices) : type == "quad" ? sizeof(quadVertices) : 0;
+    ResourceRegistry::addBuffer(this->shapeVBO, GL_ARRAY_BUFFER, vertexBytes, 0, "Shape " + type);
+
     // Set vertex attribute pointers
     glBindVertexArray(this->shapeVAO);
 
@@ -136,25 +140,17 @@ void Shape::setShape(std::string type, glm::vec3 position)
 }
 
 
-void Shape::drawShape(Shader& lightingShader, glm::mat4& view, glm::mat4& projection, Camera& camera)
+void Shape::drawShape(Shader& lightingShader)
 {
-    // Use the shader program
+    // Use the shader program, view and projection come from the frame uniform block
     lightingShader.useShader();
 
-    // Set shader uniforms for view, projection, and model matrices
-    GLint modelLoc = glGetUniformLocation(lightingShader.Program, "model");
-    GLint viewLoc = glGetUniformLocation(lightingShader.Program, "view");
-    GLint projLoc = glGetUniformLocation(lightingShader.Program, "projection");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform3f(glGetUniformLocation(lightingShader.Program, "viewPos"), camera.cameraPosition.x, camera.cameraPosition.y, camera.cameraPosition.z);
-
     // Compute model matrix and set it in the shader
     glm::mat4 model;
     model = glm::translate(model, this->shapePosition);
     model = glm::scale(model, this->shapeScale);
     model = glm::rotate(model, this->shapeAngle, this->shapeRotationAxis);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    lightingShader.setMat4("model", model);
 
     // Bind VAO and draw the shape based on its type
     glBindVertexArray(this->shapeVAO);
@@ -187,6 +183,17 @@ void Shape::drawShape()
 
 
 
+void Shape::releaseShape()
+{
+    glDeleteVertexArrays(1, &this->shapeVAO);
+    glDeleteBuffers(1, &this->shapeVBO);
+    ResourceRegistry::removeResource(RESOURCE_BUFFER, this->shapeVBO);
+
+    this->shapeVAO = 0;
+    this->shapeVBO = 0;
+}
+
+
 std::string Shape::getShapeType()
 {
     return this->shapeType;
@@ -29,8 +29,9 @@ class Shape
         Shape();
         ~Shape();
         void setShape(std::string type, glm::vec3 position);
-        void drawShape(Shader& lightingShader, glm::mat4& view, glm::mat4& projection, Camera& camera);
+        void drawShape(Shader& lightingShader);
         void drawShape();
+        void releaseShape();
         std::string getShapeType();
         glm::vec3 getShapePosition();
         GLfloat getShapeAngle();
@@ -2,168 +2,671 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include "stb_image.h"
 #include "texture.h"
+#include "texturecontainer.h"
+#include "profiler.h"
+#include "startupreport.h"
+#include "resourceregistry.h"
 
 
-Texture::Texture()
+// Whole file in memory, so reading and decoding are timed separately at startup
+static bool readTextureFile(const std::string& texPath, std::vector<unsigned char>& fileData)
+{
+    StartupPhase readPhase("Texture Read", texPath);
+
+    std::ifstream texFile(texPath.c_str(), std::ios::binary);
+
+    if (!texFile.is_open())
+        return false;
+
+    fileData.assign(std::istreambuf_iterator<char>(texFile), std::istreambuf_iterator<char>());
+
+    return !fileData.empty();
+}
+
+
+// stb_image flips through a global flag, loader threads flip their own images instead
+static void flipImageRows(void* imageData, size_t rowBytes, GLuint rowCount)
+{
+    unsigned char* rows = (unsigned char*)imageData;
+    std::vector<unsigned char> row(rowBytes);
+
+    for (GLuint top = 0, bottom = rowCount - 1; top < bottom; ++top, --bottom)
+    {
+        std::memcpy(&row[0], rows + top * rowBytes, rowBytes);
+        std::memcpy(rows + top * rowBytes, rows + bottom * rowBytes, rowBytes);
+        std::memcpy(rows + bottom * rowBytes, &row[0], rowBytes);
+    }
+}
+
+
+static void copyImageRows(unsigned char* dest, const unsigned char* src, size_t rowBytes, GLuint rowCount, bool flip)
+{
+    if (!flip)
+    {
+        std::memcpy(dest, src, rowBytes * rowCount);
+        return;
+    }
+
+    for (GLuint row = 0; row < rowCount; ++row)
+        std::memcpy(dest + row * rowBytes, src + (rowCount - 1 - row) * rowBytes, rowBytes);
+}
+
+
+// Decoded to the requested number of channels, 0 keeps what the file holds
+static bool decodeTextureFile(const std::string& texPath, bool texFlip, GLuint requiredComponents, std::vector<unsigned char>& pixelData,
+                              GLuint& width, GLuint& height, GLuint& components)
+{
+    int fileWidth = 0, fileHeight = 0, numComponents = 0;
+    unsigned char* texData = NULL;
+    std::vector<unsigned char> fileData;
+
+    if (!readTextureFile(texPath, fileData))
+        return false;
+
+    {
+        StartupPhase decodePhase("Texture Decode", texPath);
+        texData = stbi_load_from_memory(&fileData[0], fileData.size(), &fileWidth, &fileHeight, &numComponents, requiredComponents);
+    }
+
+    if (!texData)
+        return false;
+
+    width = fileWidth;
+    height = fileHeight;
+    components = requiredComponents != 0 ? requiredComponents : numComponents;
+    pixelData.resize((size_t)width * height * components);
+    copyImageRows(&pixelData[0], texData, width * components, height, texFlip);
+
+    stbi_image_free(texData);
+
+    return true;
+}
+
+
+// 2x2 box filter like the 8 bit mips, the last row and column are repeated on odd sizes
+static void buildMipLevelHDR(const std::vector<GLfloat>& srcLevel, GLuint srcWidth, GLuint srcHeight, GLuint components, std::vector<GLfloat>& dstLevel)
+{
+    GLuint dstWidth = std::max(srcWidth / 2, 1u), dstHeight = std::max(srcHeight / 2, 1u);
+    dstLevel.assign((size_t)dstWidth * dstHeight * components, 0.0f);
+
+    for (GLuint y = 0; y < dstHeight; ++y)
+    {
+        GLuint srcY[2] = { std::min(y * 2, srcHeight - 1), std::min(y * 2 + 1, srcHeight - 1) };
+
+        for (GLuint x = 0; x < dstWidth; ++x)
+        {
+            GLfloat* dstTexel = &dstLevel[((size_t)y * dstWidth + x) * components];
+
+            for (GLuint i = 0; i < 4; ++i)
+            {
+                const GLfloat* srcTexel = &srcLevel[((size_t)srcY[i / 2] * srcWidth + std::min(x * 2 + i % 2, srcWidth - 1)) * components];
+
+                for (GLuint c = 0; c < components; ++c)
+                    dstTexel[c] += srcTexel[c] * 0.25f;
+            }
+        }
+    }
+}
+
+
+// RGB9_E5 texel as GL_UNSIGNED_INT_5_9_9_9_REV takes it, rounded the way EXT_texture_shared_exponent
+// specifies: the largest channel picks the exponent, the others lose their low bits to it
+static GLuint packSharedExponent(const GLfloat* rgbTexel)
+{
+    const GLint mantissaBits = 9, exponentBias = 15;
+    const GLfloat sharedMax = 511.0f / 512.0f * 65536.0f;
+    GLfloat channels[3];
+
+    for (GLuint c = 0; c < 3; ++c)
+        channels[c] = rgbTexel[c] > 0.0f ? std::min(rgbTexel[c], sharedMax) : 0.0f;     // Negatives and NaNs go to 0
+
+    GLfloat maxChannel = std::max(channels[0], std::max(channels[1], channels[2]));
+
+    if (maxChannel <= 0.0f)
+        return 0;
+
+    int maxExponent;
+    std::frexp(maxChannel, &maxExponent);
+
+    GLint sharedExponent = std::max(-exponentBias - 1, maxExponent - 1) + 1 + exponentBias;
+
+    if (std::floor(maxChannel / std::ldexp(1.0f, sharedExponent - exponentBias - mantissaBits) + 0.5f) == (GLfloat)(1 << mantissaBits))
+        ++sharedExponent;
+
+    GLfloat texelScale = std::ldexp(1.0f, sharedExponent - exponentBias - mantissaBits);
+    GLuint packedTexel = (GLuint)sharedExponent << 27;
+
+    for (GLuint c = 0; c < 3; ++c)
+        packedTexel |= std::min((GLuint)std::floor(channels[c] / texelScale + 0.5f), 511u) << (c * 9);
+
+    return packedTexel;
+}
+
+
+// Red channel filtered the way the repeating sampler of the single map did, for maps smaller than the packed image
+static unsigned char sampleChannel(const std::vector<unsigned char>& rgbaData, GLuint width, GLuint height, GLfloat u, GLfloat v)
+{
+    GLfloat x = u * width - 0.5f, y = v * height - 0.5f;
+    GLfloat fracX = x - std::floor(x), fracY = y - std::floor(y);
+    GLint x0 = (GLint)std::floor(x), y0 = (GLint)std::floor(y);
+    GLint texelX[2] = { (x0 % (GLint)width + (GLint)width) % (GLint)width, ((x0 + 1) % (GLint)width + (GLint)width) % (GLint)width };
+    GLint texelY[2] = { (y0 % (GLint)height + (GLint)height) % (GLint)height, ((y0 + 1) % (GLint)height + (GLint)height) % (GLint)height };
+
+    GLfloat top = rgbaData[((size_t)texelY[0] * width + texelX[0]) * 4] * (1.0f - fracX) + rgbaData[((size_t)texelY[0] * width + texelX[1]) * 4] * fracX;
+    GLfloat bottom = rgbaData[((size_t)texelY[1] * width + texelX[0]) * 4] * (1.0f - fracX) + rgbaData[((size_t)texelY[1] * width + texelX[1]) * 4] * fracX;
+
+    return (unsigned char)std::min(top * (1.0f - fracY) + bottom * fracY + 0.5f, 255.0f);
+}
+
+
+// Roughness and metalness maps packed into red and green at the size of the largest one
+static bool packChannelImages(const std::vector<std::string>& sourcePaths, bool texFlip, std::vector<unsigned char>& rgbaData, GLuint& width, GLuint& height)
+{
+    // A missing map reads as fully rough or dielectric
+    const unsigned char channelDefaults[2] = { 255, 0 };
+    std::vector<unsigned char> channelData[2];
+    GLuint channelWidth[2] = { 0, 0 }, channelHeight[2] = { 0, 0 };
+
+    width = 0;
+    height = 0;
+
+    for (GLuint c = 0; c < 2 && c < sourcePaths.size(); ++c)
+    {
+        GLuint channelComponents = 0;
+
+        if (decodeTextureFile(sourcePaths[c], texFlip, 4, channelData[c], channelWidth[c], channelHeight[c], channelComponents))
+        {
+            width = std::max(width, channelWidth[c]);
+            height = std::max(height, channelHeight[c]);
+        }
+        else
+            std::cerr << "TEXTURES - PACKING WITHOUT : " + sourcePaths[c] + "\n" << std::flush;
+    }
+
+    if (width == 0 || height == 0)
+        return false;
+
+    StartupPhase packPhase("Texture Pack", sourcePaths[0]);
+    rgbaData.resize((size_t)width * height * 4);
+
+    for (GLuint y = 0; y < height; ++y)
+    {
+        for (GLuint x = 0; x < width; ++x)
+        {
+            unsigned char* texel = &rgbaData[((size_t)y * width + x) * 4];
+
+            for (GLuint c = 0; c < 2; ++c)
+            {
+                if (channelWidth[c] == 0)
+                    texel[c] = channelDefaults[c];
+                else if (channelWidth[c] == width && channelHeight[c] == height)
+                    texel[c] = channelData[c][((size_t)y * width + x) * 4];
+                else
+                    texel[c] = sampleChannel(channelData[c], channelWidth[c], channelHeight[c], (x + 0.5f) / width, (y + 0.5f) / height);
+            }
+
+            texel[2] = 0;
+            texel[3] = 255;
+        }
+    }
+
+    return true;
+}
+
+
+TextureImage::TextureImage()
+{
+    this->imageWidth = 0;
+    this->imageHeight = 0;
+    this->imageComponents = 0;
+    this->imageFormat = GL_NONE;
+    this->imageInternalFormat = GL_NONE;
+    this->imageType = GL_UNSIGNED_BYTE;
+    this->imageCompressed = false;
+    this->imageMappedData = NULL;
+}
+
+
+const unsigned char* TextureImage::getData() const
+{
+    return this->imageMapping ? this->imageMappedData : this->imageData.empty() ? NULL : &this->imageData[0];
+}
+
+
+size_t TextureImage::getSize() const
 {
+    size_t imageBytes = 0;
+
+    for (size_t level = 0; level < this->levelSizes.size(); ++level)
+        imageBytes += this->levelSizes[level];
 
+    return imageBytes;
+}
+
+
+Texture::Texture()
+{
+    this->texID = 0;
+    this->texWidth = 0;
+    this->texHeight = 0;
+    this->texComponents = 0;
+    this->texType = GL_TEXTURE_2D;
+    this->texInternalFormat = GL_NONE;
+    this->texFormat = GL_NONE;
+    this->texReady = true;
+    this->texPlaceholderID = 0;
 }
 
 
 Texture::~Texture()
 {
+    this->releaseTexture();
+}
+
+
+void Texture::releaseTexture()
+{
+    if (this->texID == 0)
+        return;
+
     glDeleteTextures(1, &this->texID);
+    ResourceRegistry::removeResource(RESOURCE_TEXTURE, this->texID);
+
+    this->texID = 0;
+    this->texWidth = 0;
+    this->texHeight = 0;
+    this->texComponents = 0;
 }
 
 
-void Texture::setTexture(const char* texPath, std::string texName, bool texFlip)
+void Texture::setTexture(const char* texPath, std::string texName, bool texFlip, TextureUsage texUsage)
 {
-    // Set texture type to 2D
-    this->texType = GL_TEXTURE_2D;
+    ProfilerZone textureZone("setTexture " + std::string(texPath));
 
     // Convert texture path to a string
     std::string tempPath = std::string(texPath);
 
-    // Flip texture vertically if required
-    if (texFlip)
-        stbi_set_flip_vertically_on_load(true);
+    TextureImage image;
+
+    if (loadTextureImage(tempPath, texFlip, texUsage, image))
+        this->setTextureImage(image, tempPath, texName, image.getData());
     else
-        stbi_set_flip_vertically_on_load(false);
+    {
+        // Log error if texture loading fails
+        this->releaseTexture();
+        this->texName = texName;
+        std::cerr << "TEXTURE FAILED - LOADING : " << texPath << std::endl;
+    }
+}
 
-    // Generate and bind texture
-    glGenTextures(1, &this->texID);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, this->texID);
 
-    // Set anisotropic filtering for better texture quality
-    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisoFilterLevel);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, this->anisoFilterLevel);
+bool Texture::loadTextureImage(const std::string& texPath, bool texFlip, TextureUsage texUsage, TextureImage& image)
+{
+    std::string containerPath = TextureContainer::getContainerPath(texPath, texFlip, texUsage);
 
-    // Load texture data
-    int width, height, numComponents;
-    unsigned char* texData = stbi_load(tempPath.c_str(), &width, &height, &numComponents, 0);
+    // Converted before, the levels are uploaded straight from the mapped container. One
+    // imported with compression in the other state is converted again
+    if (TextureContainer::isContainerFresh(containerPath, TextureCompressor::getSourcePaths(texPath, texUsage)))
+    {
+        StartupPhase mapPhase("Texture Map", containerPath);
 
-    // Store texture properties
-    this->texWidth = width;
-    this->texHeight = height;
-    this->texComponents = numComponents;
-    this->texName = texName;
+        if (TextureContainer::loadContainer(containerPath, texFlip, texUsage, image) && image.imageCompressed == TextureCompressor::isUsageCompressed(texUsage))
+            return true;
+    }
+
+    return convertTextureImage(texPath, texFlip, texUsage, image);
+}
+
+
+bool Texture::loadTextureImageHDR(const std::string& texPath, bool texFlip, TextureImage& image)
+{
+    std::string containerPath = TextureContainer::getContainerPath(texPath, texFlip, TEXTURE_USAGE_NONE);
+
+    if (TextureContainer::isContainerFresh(containerPath, std::vector<std::string>(1, texPath)))
+    {
+        StartupPhase mapPhase("Texture Map", containerPath);
+
+        // Converted with the other HDR format setting, it is converted again like a compression change
+        if (TextureContainer::loadContainer(containerPath, texFlip, TEXTURE_USAGE_NONE, image) && image.imageType != GL_UNSIGNED_BYTE &&
+            image.imageInternalFormat == TextureCompressor::getHDRFormat(image.imageComponents))
+            return true;
+    }
+
+    return convertTextureImageHDR(texPath, texFlip, image);
+}
+
+
+bool Texture::convertTextureImage(const std::string& texPath, bool texFlip, TextureUsage texUsage, TextureImage& image)
+{
+    std::vector<unsigned char> pixelData;
+    GLuint width = 0, height = 0, numComponents = 0;
+    bool texCompressed = TextureCompressor::isUsageCompressed(texUsage);
 
-    // If texture data is loaded correctly
-    if (texData)
+    // Block compression and packing work on four channels, anything else keeps what the file holds
+    if (texUsage == TEXTURE_USAGE_ROUGH_METAL)
     {
+        if (!packChannelImages(TextureCompressor::getSourcePaths(texPath, texUsage), texFlip, pixelData, width, height))
+            return false;
+
+        numComponents = 4;
+    }
+    else if (!decodeTextureFile(texPath, texFlip, texCompressed ? 4 : 0, pixelData, width, height, numComponents))
+        return false;
+
+    CompressedImage compressedImage;
+
+    if (texCompressed)
+    {
+        StartupPhase compressPhase("Texture Compress", texPath);
+        texCompressed = TextureCompressor::compressImage(&pixelData[0], width, height, texUsage, compressedImage);
+    }
+
+    image.imageWidth = width;
+    image.imageHeight = height;
+    image.imageType = GL_UNSIGNED_BYTE;
+    image.imageCompressed = texCompressed;
+    image.imageMapping.reset();
+    image.imageMappedData = NULL;
+    image.imageData.clear();
+    image.levelSizes.clear();
+
+    if (texCompressed)
+    {
+        image.imageInternalFormat = compressedImage.imageFormat;
+
+        if (compressedImage.imageFormat == GL_COMPRESSED_RED_RGTC1)
+            image.imageFormat = GL_RED;
+        else if (compressedImage.imageFormat == GL_COMPRESSED_RG_RGTC2)
+            image.imageFormat = GL_RG;
+        else if (compressedImage.imageFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || compressedImage.imageFormat == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT)
+            image.imageFormat = GL_RGB;
+        else
+            image.imageFormat = GL_RGBA;
+
+        image.imageComponents = image.imageFormat == GL_RED ? 1 : image.imageFormat == GL_RG ? 2 : image.imageFormat == GL_RGB ? 3 : 4;
+
+        // Every level back to back, so the whole chain is staged and uploaded in one go
+        for (GLuint level = 0; level < compressedImage.imageLevels.size(); ++level)
+        {
+            image.levelSizes.push_back(compressedImage.imageLevels[level].size());
+            image.imageData.insert(image.imageData.end(), compressedImage.imageLevels[level].begin(), compressedImage.imageLevels[level].end());
+        }
+    }
+    else
+    {
+        // Packed maps only use red and green, and stay RG when they are not compressed
+        if (texUsage == TEXTURE_USAGE_ROUGH_METAL)
+        {
+            for (size_t i = 0; i < (size_t)width * height; ++i)
+                std::memmove(&pixelData[i * 2], &pixelData[i * 4], 2);
+
+            numComponents = 2;
+            pixelData.resize((size_t)width * height * 2);
+        }
+
         // Determine texture format based on the number of components
         if (numComponents == 1)
-            this->texFormat = GL_RED;
+            image.imageFormat = GL_RED;
+        else if (numComponents == 2)
+            image.imageFormat = GL_RG;
         else if (numComponents == 3)
-            this->texFormat = GL_RGB;
-        else if (numComponents == 4)
-            this->texFormat = GL_RGBA;
+            image.imageFormat = GL_RGB;
+        else
+            image.imageFormat = GL_RGBA;
+
+        image.imageComponents = numComponents;
+        image.imageInternalFormat = TextureCompressor::isUsageSRGB(texUsage) ? TextureCompressor::getSRGBFormat(image.imageFormat) : image.imageFormat;
+
+        // The mips are built here rather than on upload, the container carries them too
+        StartupPhase mipmapPhase("Texture Mipmaps", texPath);
+        std::vector<unsigned char> nextLevel;
+        GLuint levelWidth = width, levelHeight = height;
 
-        this->texInternalFormat = this->texFormat;
+        while (true)
+        {
+            image.levelSizes.push_back(pixelData.size());
+            image.imageData.insert(image.imageData.end(), pixelData.begin(), pixelData.end());
 
-        // Create texture
-        glTexImage2D(GL_TEXTURE_2D, 0, this->texInternalFormat, this->texWidth, this->texHeight, 0, this->texFormat, GL_UNSIGNED_BYTE, texData);
+            if (levelWidth <= 1 && levelHeight <= 1)
+                break;
 
-        // Set texture parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // Enable mipmaps and linear filtering
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            TextureCompressor::buildMipLevel(pixelData, levelWidth, levelHeight, numComponents, texUsage, nextLevel);
+            pixelData.swap(nextLevel);
 
-        // Generate mipmaps
-        glGenerateMipmap(GL_TEXTURE_2D);
+            levelWidth = std::max(levelWidth / 2, 1u);
+            levelHeight = std::max(levelHeight / 2, 1u);
+        }
     }
+
+    // Loader threads share the console, each message goes out in one piece
+    std::string containerPath = TextureContainer::getContainerPath(texPath, texFlip, texUsage);
+
+    if (TextureContainer::saveContainer(containerPath, TextureCompressor::getSourcePaths(texPath, texUsage), texFlip, texUsage, image))
+        std::cout << "TEXTURES - CONVERTED : " + texPath + " -> " + containerPath + "\n" << std::flush;
     else
-    {
-        // Log error if texture loading fails
-        std::cerr << "TEXTURE FAILED - LOADING : " << texPath << std::endl;
-    }
+        std::cerr << "TEXTURES - FAILED WRITING CONTAINER : " + containerPath + "\n" << std::flush;
 
-    // Free texture data and unbind texture
-    stbi_image_free(texData);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
 }
 
 
-void Texture::setTextureHDR(const char* texPath, std::string texName, bool texFlip)
+bool Texture::convertTextureImageHDR(const std::string& texPath, bool texFlip, TextureImage& image)
 {
-    // Set texture type to 2D
-    this->texType = GL_TEXTURE_2D;
+    std::vector<unsigned char> fileData;
 
-    // Convert texture path to a string
-    std::string tempPath = std::string(texPath);
+    // Check if the file is an HDR image
+    if (!readTextureFile(texPath, fileData) || !stbi_is_hdr_from_memory(&fileData[0], fileData.size()))
+    {
+        std::cerr << "HDR TEXTURE - FILE IS NOT HDR : " + texPath + "\n" << std::flush;
+        return false;
+    }
 
-    // Flip texture vertically if required
-    if (texFlip)
-        stbi_set_flip_vertically_on_load(true);
-    else
-        stbi_set_flip_vertically_on_load(false);
+    int width = 0, height = 0, numComponents = 0;
+    float* texData = NULL;
 
-    // Generate and bind texture
-    glGenTextures(1, &this->texID);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, this->texID);
+    {
+        StartupPhase decodePhase("Texture Decode", texPath);
 
-    // Check if the file is an HDR image
-    if (stbi_is_hdr(tempPath.c_str()))
+        // Grey and grey-alpha images are expanded, the texture is RGB or RGBA
+        stbi_info_from_memory(&fileData[0], fileData.size(), &width, &height, &numComponents);
+        numComponents = numComponents == 4 ? 4 : 3;
+        texData = stbi_loadf_from_memory(&fileData[0], fileData.size(), &width, &height, NULL, numComponents);
+    }
+
+    if (!texData)
     {
-        int width, height, numComponents;
-        float* texData = stbi_loadf(tempPath.c_str(), &width, &height, &numComponents, 0);
+        std::cerr << "HDR TEXTURE - FAILED LOADING : " + texPath + "\n" << std::flush;
+        return false;
+    }
 
-        // Store texture properties
-        this->texWidth = width;
-        this->texHeight = height;
-        this->texComponents = numComponents;
-        this->texName = texName;
+    image.imageWidth = width;
+    image.imageHeight = height;
+    image.imageComponents = numComponents;
+    image.imageFormat = numComponents == 4 ? GL_RGBA : GL_RGB;
+    image.imageInternalFormat = TextureCompressor::getHDRFormat(numComponents);
+    image.imageType = image.imageInternalFormat == GL_RGB9_E5 ? GL_UNSIGNED_INT_5_9_9_9_REV : GL_HALF_FLOAT;
+    image.imageCompressed = false;
+    image.imageMapping.reset();
+    image.imageMappedData = NULL;
+    image.imageData.clear();
+    image.levelSizes.clear();
+
+    // Shared exponents or half floats keep the range in a third or half of the memory, the mips are averaged at full precision
+    {
+        StartupPhase mipmapPhase("Texture Mipmaps", texPath);
+        std::vector<GLfloat> levelData((size_t)width * height * numComponents), nextLevel;
+        GLuint levelWidth = width, levelHeight = height;
 
-        // If texture data is loaded correctly
-        if (texData)
+        copyImageRows((unsigned char*)&levelData[0], (const unsigned char*)texData, width * numComponents * sizeof(GLfloat), height, texFlip);
+
+        while (true)
         {
-            // Set internal and external formats based on the number of components
-            if (numComponents == 3)
+            size_t levelOffset = image.imageData.size();
+            image.levelSizes.push_back(TextureContainer::getLevelBytes(image, levelWidth, levelHeight));
+            image.imageData.resize(levelOffset + image.levelSizes.back());
+
+            if (image.imageType == GL_UNSIGNED_INT_5_9_9_9_REV)
             {
-                this->texInternalFormat = GL_RGB32F;
-                this->texFormat = GL_RGB;
+                for (size_t i = 0; i < levelData.size() / 3; ++i)
+                {
+                    GLuint packedValue = packSharedExponent(&levelData[i * 3]);
+                    std::memcpy(&image.imageData[levelOffset + i * sizeof(GLuint)], &packedValue, sizeof(GLuint));
+                }
             }
-            else if (numComponents == 4)
+            else
             {
-                this->texInternalFormat = GL_RGBA32F;
-                this->texFormat = GL_RGBA;
+                for (size_t i = 0; i < levelData.size(); ++i)
+                {
+                    GLushort halfValue = glm::packHalf1x16(levelData[i]);
+                    std::memcpy(&image.imageData[levelOffset + i * sizeof(GLushort)], &halfValue, sizeof(GLushort));
+                }
             }
 
-            // Create HDR texture
-            glTexImage2D(GL_TEXTURE_2D, 0, this->texInternalFormat, this->texWidth, this->texHeight, 0, this->texFormat, GL_FLOAT, texData);
+            if (levelWidth <= 1 && levelHeight <= 1)
+                break;
 
-            // Set texture parameters
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            buildMipLevelHDR(levelData, levelWidth, levelHeight, numComponents, nextLevel);
+            levelData.swap(nextLevel);
 
-            // Generate mipmaps
-            glGenerateMipmap(GL_TEXTURE_2D);
-        }
-        else
-        {
-            // Log error if HDR texture loading fails
-            std::cerr << "HDR TEXTURE - FAILED LOADING : " << texPath << std::endl;
+            levelWidth = std::max(levelWidth / 2, 1u);
+            levelHeight = std::max(levelHeight / 2, 1u);
         }
-
-        // Free texture data
-        stbi_image_free(texData);
     }
+
+    stbi_image_free(texData);
+
+    std::string containerPath = TextureContainer::getContainerPath(texPath, texFlip, TEXTURE_USAGE_NONE);
+
+    if (TextureContainer::saveContainer(containerPath, std::vector<std::string>(1, texPath), texFlip, TEXTURE_USAGE_NONE, image))
+        std::cout << "TEXTURES - CONVERTED : " + texPath + " -> " + containerPath + "\n" << std::flush;
     else
+        std::cerr << "TEXTURES - FAILED WRITING CONTAINER : " + containerPath + "\n" << std::flush;
+
+    return true;
+}
+
+
+void Texture::setTextureImage(const TextureImage& image, const std::string& texPath, std::string texName, const GLvoid* imageData)
+{
+    // Set texture type to 2D
+    this->texType = GL_TEXTURE_2D;
+
+    // Setting a texture again replaces its previous GL object
+    this->releaseTexture();
+
+    // Generate and bind texture
+    glGenTextures(1, &this->texID);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->texID);
+
+    // Set anisotropic filtering for better texture quality
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisoFilterLevel);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, this->anisoFilterLevel);
+
+    // Store texture properties, the format is what sampling the texture returns
+    this->texWidth = image.imageWidth;
+    this->texHeight = image.imageHeight;
+    this->texComponents = image.imageComponents;
+    this->texFormat = image.imageFormat;
+    this->texInternalFormat = image.imageInternalFormat;
+    this->texName = texName;
+
+    this->uploadTextureLevels(image, texPath, imageData);
+
+    // Set texture parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // Enable mipmaps and linear filtering
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    ResourceRegistry::addTexture(this->texID, this->texInternalFormat, this->texWidth, this->texHeight, 1, true, texPath);
+
+    // Unbind texture
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void Texture::uploadTextureLevels(const TextureImage& image, const std::string& texPath, const GLvoid* imageData)
+{
+    // Create texture level by level, rows of the small uncompressed levels are not padded
+    StartupReport::beginPhase("Texture Upload", texPath, true);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    GLuint levelWidth = image.imageWidth, levelHeight = image.imageHeight;
+    const GLubyte* levelData = (const GLubyte*)imageData;
+
+    for (GLuint level = 0; level < image.levelSizes.size(); ++level)
     {
-        // Log error if the file is not HDR
-        std::cerr << "HDR TEXTURE - FILE IS NOT HDR : " << texPath << std::endl;
+        if (image.imageCompressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, image.imageInternalFormat, levelWidth, levelHeight, 0, image.levelSizes[level], levelData);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, image.imageInternalFormat, levelWidth, levelHeight, 0, image.imageFormat, image.imageType, levelData);
+
+        levelData += image.levelSizes[level];
+        levelWidth = std::max(levelWidth / 2, 1u);
+        levelHeight = std::max(levelHeight / 2, 1u);
     }
 
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levelSizes.size() - 1);
+    StartupReport::endPhase();
+}
+
+
+void Texture::setTextureHDR(const char* texPath, std::string texName, bool texFlip)
+{
+    ProfilerZone textureZone("setTextureHDR " + std::string(texPath));
+
+    // Set texture type to 2D
+    this->texType = GL_TEXTURE_2D;
+
+    // Convert texture path to a string
+    std::string tempPath = std::string(texPath);
+
+    // Setting a texture again replaces its previous GL object
+    this->releaseTexture();
+    this->texName = texName;
+
+    TextureImage image;
+
+    if (!loadTextureImageHDR(tempPath, texFlip, image))
+        return;
+
+    // Generate and bind texture
+    glGenTextures(1, &this->texID);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->texID);
+
+    // Store texture properties
+    this->texWidth = image.imageWidth;
+    this->texHeight = image.imageHeight;
+    this->texComponents = image.imageComponents;
+    this->texInternalFormat = image.imageInternalFormat;
+    this->texFormat = image.imageFormat;
+
+    // Create HDR texture with its mips, straight from the mapped container when it has one
+    this->uploadTextureLevels(image, tempPath, image.getData());
+
+    // Set texture parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    ResourceRegistry::addTexture(this->texID, this->texInternalFormat, this->texWidth, this->texHeight, 1, true, tempPath);
+
     // Unbind texture
     glBindTexture(GL_TEXTURE_2D, 0);
 }
@@ -173,6 +676,9 @@ void Texture::setTextureHDR(GLuint width, GLuint height, GLenum format, GLenum i
 {
     this->texType = GL_TEXTURE_2D;
 
+    // Setting a texture again replaces its previous GL object
+    this->releaseTexture();
+
     // Generate and bind the texture
     glGenTextures(1, &this->texID);
     glActiveTexture(GL_TEXTURE0);
@@ -206,6 +712,8 @@ void Texture::setTextureHDR(GLuint width, GLuint height, GLenum format, GLenum i
     // Generate mipmaps for the texture
     glGenerateMipmap(GL_TEXTURE_2D);
 
+    ResourceRegistry::addTexture(this->texID, this->texInternalFormat, this->texWidth, this->texHeight, 1, true);
+
     // Unbind the texture
     glBindTexture(GL_TEXTURE_2D, 0);
 }
@@ -224,11 +732,8 @@ void Texture::setTextureCube(std::vector<const char*>& faces, bool texFlip)
         cubemapFaces.push_back(tempPath);
     }
 
-    // Set vertical flip based on the texFlip flag
-    if (texFlip)
-        stbi_set_flip_vertically_on_load(true);
-    else
-        stbi_set_flip_vertically_on_load(false);
+    // Setting a texture again replaces its previous GL object
+    this->releaseTexture();
 
     // Generate and bind the cube map texture
     glGenTextures(1, &this->texID);
@@ -243,6 +748,10 @@ void Texture::setTextureCube(std::vector<const char*>& faces, bool texFlip)
     {
         texData = stbi_load(cubemapFaces[i].c_str(), &width, &height, &numComponents, 0);
 
+        // Set vertical flip based on the texFlip flag
+        if (texData && texFlip)
+            flipImageRows(texData, width * numComponents, height);
+
         // If texture dimensions and components are not set, initialize them
         if (this->texWidth == NULL && this->texHeight == NULL && this->texComponents == NULL)
         {
@@ -284,6 +793,8 @@ void Texture::setTextureCube(std::vector<const char*>& faces, bool texFlip)
         stbi_image_free(texData);
     }
 
+    ResourceRegistry::addTexture(this->texID, this->texInternalFormat, this->texWidth, this->texHeight, 6, true, cubemapFaces[0]);
+
     // Set cube map specific wrapping options
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -300,6 +811,9 @@ void Texture::setTextureCube(GLuint width, GLenum format, GLenum internalFormat,
 {
     this->texType = GL_TEXTURE_CUBE_MAP;
 
+    // Setting a texture again replaces its previous GL object
+    this->releaseTexture();
+
     // Generate and bind the cube map texture
     glGenTextures(1, &this->texID);
     glActiveTexture(GL_TEXTURE0);
@@ -329,6 +843,8 @@ void Texture::setTextureCube(GLuint width, GLenum format, GLenum internalFormat,
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, this->texInternalFormat, this->texWidth, this->texHeight, 0, this->texFormat, type, nullptr);
     }
 
+    ResourceRegistry::addTexture(this->texID, this->texInternalFormat, this->texWidth, this->texHeight, 6, false);
+
     // Set texture parameters for filtering and wrapping
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, minFilter);
@@ -346,6 +862,10 @@ void Texture::computeTexMipmap()
 {
     glBindTexture(this->texType, this->texID);
     glGenerateMipmap(this->texType);
+
+    // The full chain is allocated now
+    ResourceRegistry::addTexture(this->texID, this->texInternalFormat, this->texWidth, this->texHeight,
+                                 this->texType == GL_TEXTURE_CUBE_MAP ? 6 : 1, true);
 }
 
 
@@ -373,7 +893,13 @@ std::string Texture::getTexName()
 }
 
 
+bool Texture::isTextureReady()
+{
+    return this->texReady;
+}
+
+
 void Texture::useTexture()
 {
-    glBindTexture(this->texType, this->texID);
+    glBindTexture(this->texType, this->texReady ? this->texID : this->texPlaceholderID);
 }
@@ -6,9 +6,31 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <memory>
 
 #include <glad/glad.h>
 
+#include "texturecompressor.h"
+#include "texturecontainer.h"
+
+
+// CPU side of a file texture, ready to upload: its whole mip chain, decoded or block-compressed,
+// either converted in memory or read straight from the mapped .ltex container
+struct TextureImage
+{
+    GLuint imageWidth, imageHeight, imageComponents;
+    GLenum imageFormat, imageInternalFormat, imageType;
+    bool imageCompressed;
+    std::vector<unsigned char> imageData;           // Every level back to back
+    std::shared_ptr<FileMapping> imageMapping;   // Or mapped, imageData then stays empty
+    const unsigned char* imageMappedData;           // First level inside the mapping
+    std::vector<GLuint> levelSizes;
+
+    TextureImage();
+    const unsigned char* getData() const;
+    size_t getSize() const;
+};
+
 
 class Texture
 {
@@ -17,20 +39,33 @@ class Texture
         GLfloat anisoFilterLevel;
         GLenum texType, texInternalFormat, texFormat;
         std::string texName;
+        bool texReady;                  // Cleared while the texture loader streams it in
+        GLuint texPlaceholderID;        // Bound in its place until then
 
         Texture();
         ~Texture();
-        void setTexture(const char* texPath, std::string texName, bool texFlip);
+        void setTexture(const char* texPath, std::string texName, bool texFlip, TextureUsage texUsage = TEXTURE_USAGE_NONE);
+        void setTextureImage(const TextureImage& image, const std::string& texPath, std::string texName, const GLvoid* imageData);
         void setTextureHDR(const char* texPath, std::string texName, bool texFlip);
 		void setTextureHDR(GLuint width, GLuint height, GLenum format, GLenum internalFormat, GLenum type, GLenum minFilter);
         void setTextureCube(std::vector<const char*>& faces, bool texFlip);
         void setTextureCube(GLuint width, GLenum format, GLenum internalFormat, GLenum type, GLenum minFilter);
         void computeTexMipmap();
+        void releaseTexture();
         GLuint getTexID();
         GLuint getTexWidth();
         GLuint getTexHeight();
         std::string getTexName();
+        bool isTextureReady();
         void useTexture();
+
+        static bool loadTextureImage(const std::string& texPath, bool texFlip, TextureUsage texUsage, TextureImage& image);
+        static bool loadTextureImageHDR(const std::string& texPath, bool texFlip, TextureImage& image);
+        static bool convertTextureImage(const std::string& texPath, bool texFlip, TextureUsage texUsage, TextureImage& image);
+        static bool convertTextureImageHDR(const std::string& texPath, bool texFlip, TextureImage& image);
+
+    private:
+        void uploadTextureLevels(const TextureImage& image, const std::string& texPath, const GLvoid* imageData);
 };
 
 #endif
@@ -0,0 +1,366 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <mutex>
+
+#include <glad/glad.h>
+
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
+#include "texturecompressor.h"
+
+
+bool TextureCompressor::compressionEnabled = true;
+bool TextureCompressor::compactHDR = true;
+
+
+// Single channel block (BC4): the DXT5 alpha block encodes exactly the same way,
+// the colour part left constant takes the compressor's fast path
+static void compressChannelBlock(unsigned char* dest, const unsigned char* rgbaBlock, GLuint channel)
+{
+    unsigned char channelBlock[64] = {0};
+    unsigned char dxtBlock[16];
+
+    for (GLuint i = 0; i < 16; ++i)
+        channelBlock[i * 4 + 3] = rgbaBlock[i * 4 + channel];
+
+    stb_compress_dxt_block(dxtBlock, channelBlock, 1, STB_DXT_HIGHQUAL);
+    std::memcpy(dest, dxtBlock, 8);
+}
+
+
+// sRGB transfer functions, colour mips are averaged in linear space the way the sampler filters them
+static GLfloat decodeSRGB(unsigned char value)
+{
+    static GLfloat decodeTable[256];
+    static std::once_flag tableBuilt;
+
+    std::call_once(tableBuilt, []()
+    {
+        for (GLuint i = 0; i < 256; ++i)
+        {
+            GLfloat encoded = i / 255.0f;
+            decodeTable[i] = encoded <= 0.04045f ? encoded / 12.92f : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+        }
+    });
+
+    return decodeTable[value];
+}
+
+
+static unsigned char encodeSRGB(GLfloat linear)
+{
+    GLfloat encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+
+    return (unsigned char)std::min(std::max(encoded * 255.0f + 0.5f, 0.0f), 255.0f);
+}
+
+
+// stb_dxt builds its tables on the first block, loader threads must not race on them
+static void initCompressorTables()
+{
+    unsigned char rgbaBlock[64] = {0};
+    unsigned char dxtBlock[16];
+
+    stb_compress_dxt_block(dxtBlock, rgbaBlock, 1, STB_DXT_NORMAL);
+}
+
+
+void TextureCompressor::setCompression(bool enabled)
+{
+    compressionEnabled = enabled;
+}
+
+
+bool TextureCompressor::isCompressionEnabled()
+{
+    return compressionEnabled;
+}
+
+
+void TextureCompressor::setCompactHDR(bool enabled)
+{
+    compactHDR = enabled;
+}
+
+
+bool TextureCompressor::isCompactHDR()
+{
+    return compactHDR;
+}
+
+
+GLenum TextureCompressor::getHDRFormat(GLuint components)
+{
+    // Shared exponent keeps a 9 bit mantissa per channel in 4 bytes, it can be sampled but not rendered to
+    if (components == 4)
+        return GL_RGBA16F;
+
+    return compactHDR ? GL_RGB9_E5 : GL_RGB16F;
+}
+
+
+GLenum TextureCompressor::getHDRTargetFormat(GLenum floatFormat)
+{
+    // Packed floats are renderable, no sign and no alpha but 6 and 5 bit mantissas are enough for lighting
+    return compactHDR ? GL_R11F_G11F_B10F : floatFormat;
+}
+
+
+bool TextureCompressor::isUsageCompressed(TextureUsage texUsage)
+{
+    // Albedo ends up as sRGB BC1 or BC3 and needs S3TC, the linear maps use the core RGTC formats
+    switch (texUsage)
+    {
+        case TEXTURE_USAGE_COLOR: return compressionEnabled && isFormatSupported(GL_COMPRESSED_SRGB_S3TC_DXT1_EXT);
+        case TEXTURE_USAGE_MASK:
+        case TEXTURE_USAGE_ROUGH_METAL:
+        case TEXTURE_USAGE_NORMAL: return compressionEnabled;
+        default: return false;
+    }
+}
+
+
+bool TextureCompressor::isUsageSRGB(TextureUsage texUsage)
+{
+    // Only colours are authored in sRGB, masks, normals and packed maps hold linear data
+    return texUsage == TEXTURE_USAGE_COLOR;
+}
+
+
+bool TextureCompressor::isFormatSupported(GLenum format)
+{
+    // RGTC is core since 3.0, S3TC still has to be advertised by the driver, and its sRGB
+    // formats come with EXT_texture_sRGB. The first call has to come from the GL thread,
+    // loader threads then only read the answer
+    if (format == GL_COMPRESSED_RED_RGTC1 || format == GL_COMPRESSED_RG_RGTC2)
+        return true;
+
+    static GLint s3tcSupported = -1, s3tcSRGBSupported = -1;
+
+    if (s3tcSupported < 0)
+    {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        s3tcSupported = 0;
+        s3tcSRGBSupported = 0;
+
+        for (GLint i = 0; i < extensionCount; ++i)
+        {
+            const char* extensionName = (const char*)glGetStringi(GL_EXTENSIONS, i);
+
+            if (std::strcmp(extensionName, "GL_EXT_texture_compression_s3tc") == 0)
+                s3tcSupported = 1;
+            else if (std::strcmp(extensionName, "GL_EXT_texture_sRGB") == 0 || std::strcmp(extensionName, "GL_EXT_texture_compression_s3tc_srgb") == 0)
+                s3tcSRGBSupported = 1;
+        }
+    }
+
+    if (format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT)
+        return s3tcSupported == 1 && s3tcSRGBSupported == 1;
+
+    return s3tcSupported == 1 && (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+}
+
+
+bool TextureCompressor::isFormatSRGB(GLenum format)
+{
+    return format == GL_SRGB8 || format == GL_SRGB8_ALPHA8 || format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+}
+
+
+GLenum TextureCompressor::getSRGBFormat(GLenum format)
+{
+    // Same texel or block layout, the sampler decodes the colour channels to linear, alpha stays as is
+    switch (format)
+    {
+        case GL_RGB: return GL_SRGB8;
+        case GL_RGBA: return GL_SRGB8_ALPHA8;
+        case GL_RGBA8: return GL_SRGB8_ALPHA8;
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+        default: return format;
+    }
+}
+
+
+std::vector<std::string> TextureCompressor::getSourcePaths(const std::string& texPath, TextureUsage texUsage)
+{
+    // resources/textures/pbr/shiny/shiny_rm.png -> shiny_roughness.png, shiny_metalness.png
+    std::vector<std::string> sourcePaths;
+    size_t suffix = texPath.rfind("_rm");
+
+    if (texUsage != TEXTURE_USAGE_ROUGH_METAL || suffix == std::string::npos)
+    {
+        sourcePaths.push_back(texPath);
+        return sourcePaths;
+    }
+
+    std::string basePath = texPath.substr(0, suffix), extension = texPath.substr(suffix + 3);
+    sourcePaths.push_back(basePath + "_roughness" + extension);
+    sourcePaths.push_back(basePath + "_metalness" + extension);
+
+    return sourcePaths;
+}
+
+
+bool TextureCompressor::compressImage(const unsigned char* rgbaData, GLuint width, GLuint height, TextureUsage texUsage, CompressedImage& image)
+{
+    GLenum format = GL_NONE;
+
+    if (texUsage == TEXTURE_USAGE_COLOR)
+    {
+        // Opaque albedo fits in half the memory with BC1
+        bool hasAlpha = false;
+
+        for (GLuint64 i = 0; i < (GLuint64)width * height && !hasAlpha; ++i)
+            hasAlpha = rgbaData[i * 4 + 3] != 255;
+
+        format = getSRGBFormat(hasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+    }
+    else if (texUsage == TEXTURE_USAGE_MASK)
+        format = GL_COMPRESSED_RED_RGTC1;
+    else if (texUsage == TEXTURE_USAGE_NORMAL || texUsage == TEXTURE_USAGE_ROUGH_METAL)
+        format = GL_COMPRESSED_RG_RGTC2;
+
+    if (format == GL_NONE || !isFormatSupported(format) || width == 0 || height == 0)
+        return false;
+
+    static std::once_flag tablesBuilt;
+    std::call_once(tablesBuilt, initCompressorTables);
+
+    image.imageFormat = format;
+    image.imageWidth = width;
+    image.imageHeight = height;
+    image.imageLevels.clear();
+
+    std::vector<unsigned char> rgbaLevel(rgbaData, rgbaData + (size_t)width * height * 4), nextLevel;
+    GLuint levelWidth = width, levelHeight = height;
+
+    while (true)
+    {
+        image.imageLevels.push_back(std::vector<unsigned char>());
+        compressLevel(rgbaLevel, levelWidth, levelHeight, format, image.imageLevels.back());
+
+        if (levelWidth <= 1 && levelHeight <= 1)
+            break;
+
+        buildMipLevel(rgbaLevel, levelWidth, levelHeight, 4, texUsage, nextLevel);
+        rgbaLevel.swap(nextLevel);
+
+        levelWidth = std::max(levelWidth / 2, 1u);
+        levelHeight = std::max(levelHeight / 2, 1u);
+    }
+
+    return true;
+}
+
+
+GLuint TextureCompressor::getBlockBytes(GLenum format)
+{
+    switch (format)
+    {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return 8;
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT: return 8;
+        case GL_COMPRESSED_RED_RGTC1: return 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return 16;
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: return 16;
+        case GL_COMPRESSED_RG_RGTC2: return 16;
+        default: return 16;
+    }
+}
+
+
+void TextureCompressor::buildMipLevel(const std::vector<unsigned char>& srcLevel, GLuint srcWidth, GLuint srcHeight, GLuint components, TextureUsage texUsage,
+                                       std::vector<unsigned char>& dstLevel)
+{
+    // 2x2 box filter, the last row and column are repeated on odd sizes
+    GLuint dstWidth = std::max(srcWidth / 2, 1u), dstHeight = std::max(srcHeight / 2, 1u);
+    bool texSRGB = isUsageSRGB(texUsage) && components >= 3;
+    dstLevel.resize((size_t)dstWidth * dstHeight * components);
+
+    for (GLuint y = 0; y < dstHeight; ++y)
+    {
+        GLuint srcY[2] = { std::min(y * 2, srcHeight - 1), std::min(y * 2 + 1, srcHeight - 1) };
+
+        for (GLuint x = 0; x < dstWidth; ++x)
+        {
+            GLuint srcX[2] = { std::min(x * 2, srcWidth - 1), std::min(x * 2 + 1, srcWidth - 1) };
+            unsigned char* dstTexel = &dstLevel[((size_t)y * dstWidth + x) * components];
+            GLuint channelSums[4] = {0, 0, 0, 0};
+            GLfloat linearSums[3] = {0.0f, 0.0f, 0.0f};
+
+            for (GLuint i = 0; i < 4; ++i)
+            {
+                const unsigned char* srcTexel = &srcLevel[((size_t)srcY[i / 2] * srcWidth + srcX[i % 2]) * components];
+
+                for (GLuint c = 0; c < components; ++c)
+                    channelSums[c] += srcTexel[c];
+
+                for (GLuint c = 0; c < 3 && texSRGB; ++c)
+                    linearSums[c] += decodeSRGB(srcTexel[c]);
+            }
+
+            for (GLuint c = 0; c < components; ++c)
+                dstTexel[c] = (texSRGB && c < 3) ? encodeSRGB(linearSums[c] * 0.25f) : (channelSums[c] + 2) / 4;
+
+            // Averaged normals get shorter, they are brought back to unit length
+            if (texUsage == TEXTURE_USAGE_NORMAL && components >= 3)
+            {
+                GLfloat normal[3], length = 0.0f;
+
+                for (GLuint c = 0; c < 3; ++c)
+                {
+                    normal[c] = channelSums[c] / (4.0f * 255.0f) * 2.0f - 1.0f;
+                    length += normal[c] * normal[c];
+                }
+
+                length = std::sqrt(length);
+
+                for (GLuint c = 0; c < 3 && length > 0.0f; ++c)
+                    dstTexel[c] = (unsigned char)std::min(std::max((normal[c] / length * 0.5f + 0.5f) * 255.0f + 0.5f, 0.0f), 255.0f);
+            }
+        }
+    }
+}
+
+
+void TextureCompressor::compressLevel(const std::vector<unsigned char>& rgbaLevel, GLuint width, GLuint height, GLenum format, std::vector<unsigned char>& blockLevel)
+{
+    GLuint blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    GLuint blockBytes = getBlockBytes(format);
+    blockLevel.resize((size_t)blocksX * blocksY * blockBytes);
+
+    for (GLuint by = 0; by < blocksY; ++by)
+    {
+        for (GLuint bx = 0; bx < blocksX; ++bx)
+        {
+            // Partial blocks on the border repeat the last texels
+            unsigned char rgbaBlock[64];
+
+            for (GLuint i = 0; i < 16; ++i)
+            {
+                GLuint x = std::min(bx * 4 + i % 4, width - 1), y = std::min(by * 4 + i / 4, height - 1);
+                std::memcpy(&rgbaBlock[i * 4], &rgbaLevel[((size_t)y * width + x) * 4], 4);
+            }
+
+            unsigned char* dest = &blockLevel[((size_t)by * blocksX + bx) * blockBytes];
+
+            // sRGB blocks are encoded like the others, endpoints and indices stay in the stored space
+            if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT)
+                stb_compress_dxt_block(dest, rgbaBlock, 0, STB_DXT_HIGHQUAL);
+            else if (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT)
+                stb_compress_dxt_block(dest, rgbaBlock, 1, STB_DXT_HIGHQUAL);
+            else if (format == GL_COMPRESSED_RED_RGTC1)
+                compressChannelBlock(dest, rgbaBlock, 0);
+            else if (format == GL_COMPRESSED_RG_RGTC2)
+            {
+                compressChannelBlock(dest, rgbaBlock, 0);
+                compressChannelBlock(dest + 8, rgbaBlock, 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef TEXTURECOMPRESSOR_H
+#define TEXTURECOMPRESSOR_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+// S3TC is an extension on desktop GL, glad was generated without it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+
+// What a file texture holds, picks the block format it is compressed to
+enum TextureUsage
+{
+    TEXTURE_USAGE_NONE,         // Uploaded as decoded, no compression
+    TEXTURE_USAGE_COLOR,        // Albedo, sRGB encoded, BC1 or BC3 when the alpha channel is used
+    TEXTURE_USAGE_MASK,         // Single channel maps (AO), BC4 from red
+    TEXTURE_USAGE_NORMAL,       // Tangent space normals, BC5 from red and green, Z is rebuilt in the shader
+    TEXTURE_USAGE_ROUGH_METAL,  // Roughness and metalness packed from their own maps into RG, BC5 keeps both channels apart
+    TEXTURE_USAGE_COUNT
+};
+
+
+// Block-compressed image with its whole mip chain
+struct CompressedImage
+{
+    GLenum imageFormat;                                     // GL_COMPRESSED_* internal format
+    GLuint imageWidth, imageHeight;
+    std::vector<std::vector<unsigned char> > imageLevels;   // Largest level first, down to 1x1
+};
+
+
+// Import step for file textures: decoded images get their mips built on the CPU and
+// every level block-compressed, the result is stored in the texture's .ltex container.
+// Packed roughness/metalness textures have no file of their own, they are built from
+// the _roughness and _metalness maps next to the _rm path they are requested with.
+// Colour maps are tagged sRGB, the sampler decodes them to linear before filtering.
+// HDR images and targets use the packed RGB9_E5 and R11F_G11F_B10F formats unless
+// --hdr-format float asks for the half and full float ones.
+class TextureCompressor
+{
+    public:
+        static void setCompression(bool enabled);
+        static bool isCompressionEnabled();
+        static void setCompactHDR(bool enabled);
+        static bool isCompactHDR();
+        static GLenum getHDRFormat(GLuint components);
+        static GLenum getHDRTargetFormat(GLenum floatFormat);
+        static bool isUsageCompressed(TextureUsage texUsage);
+        static bool isUsageSRGB(TextureUsage texUsage);
+        static bool isFormatSupported(GLenum format);
+        static bool isFormatSRGB(GLenum format);
+        static GLenum getSRGBFormat(GLenum format);
+        static std::vector<std::string> getSourcePaths(const std::string& texPath, TextureUsage texUsage);
+        static bool compressImage(const unsigned char* rgbaData, GLuint width, GLuint height, TextureUsage texUsage, CompressedImage& image);
+        static void buildMipLevel(const std::vector<unsigned char>& srcLevel, GLuint srcWidth, GLuint srcHeight, GLuint components, TextureUsage texUsage,
+                                  std::vector<unsigned char>& dstLevel);
+        static GLuint getBlockBytes(GLenum format);
+
+    private:
+        static bool compressionEnabled;
+        static bool compactHDR;
+
+        static void compressLevel(const std::vector<unsigned char>& rgbaLevel, GLuint width, GLuint height, GLenum format, std::vector<unsigned char>& blockLevel);
+};
+
+#endif
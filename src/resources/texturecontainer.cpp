@@ -0,0 +1,260 @@
+#include <string>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+
+#include <sys/stat.h>
+
+#include <glad/glad.h>
+
+#include "texturecontainer.h"
+#include "texture.h"
+
+
+// Header of a .ltex file, the level table follows it
+struct ContainerHeader
+{
+    GLuint texMagic, texVersion;
+    GLuint texFlags;
+    GLuint texUsage;                        // What the texture was imported as, compression and packing depend on it
+    GLuint texWidth, texHeight, texComponents, texLevels;
+    GLuint texInternalFormat, texFormat, texType;
+    GLuint texReserved;
+    GLuint64 texSourceStamp;                // Size and modification time of the sources it was converted from
+};
+
+
+struct ContainerLevel
+{
+    GLuint64 levelOffset, levelSize;        // From the start of the file
+};
+
+
+static const GLuint CONTAINER_MAGIC = 0x5845544C;           // "LTEX"
+static const GLuint CONTAINER_VERSION = 2;
+static const GLuint CONTAINER_FLIPPED = 0x1;                // Flipped vertically on import
+static const GLuint CONTAINER_COMPRESSED = 0x2;
+static const GLuint CONTAINER_SRGB = 0x4;                   // Colour channels are sRGB encoded, sampled through an sRGB format
+static const GLuint CONTAINER_ALIGNMENT = 64;               // The first level starts on a cache line
+static const GLuint CONTAINER_MAX_LEVELS = 32;
+
+
+// Loader threads converting the same texture each write their own temporary file
+static std::atomic<GLuint> containerWrites(0);
+
+
+std::string TextureContainer::getContainerPath(const std::string& texPath, bool texFlip, TextureUsage texUsage)
+{
+    // resources/textures/pbr/shiny/shiny_albedo.png -> resources/textures/pbr/shiny/shiny_albedo.color.ltex
+    // Each way of loading a source gets its own container, like its own texture cache entry
+    static const char* usageSuffixes[] = { "", ".color", ".mask", ".normal", ".rm" };
+    std::string containerSuffix = std::string(usageSuffixes[texUsage]) + (texFlip ? ".flipped" : "") + ".ltex";
+
+    size_t extension = texPath.find_last_of('.');
+    size_t directory = texPath.find_last_of("/\\");
+
+    if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+        return texPath + containerSuffix;
+
+    return texPath.substr(0, extension) + containerSuffix;
+}
+
+
+// FNV-1a over the size and modification time of every source, false when none of them exists
+static bool getSourceStamp(const std::vector<std::string>& sourcePaths, GLuint64& sourceStamp)
+{
+    GLuint64 hash = 14695981039346656037ULL;
+    bool sourceFound = false;
+
+    for (size_t i = 0; i < sourcePaths.size(); ++i)
+    {
+        struct stat sourceInfo;
+        GLuint64 sourceFields[3] = { 0, 0, 0 };
+
+        // Nanoseconds where the platform has them, an edit within the same second still changes the stamp
+        if (stat(sourcePaths[i].c_str(), &sourceInfo) == 0)
+        {
+            sourceFields[0] = (GLuint64)sourceInfo.st_size + 1;
+            sourceFields[1] = (GLuint64)sourceInfo.st_mtime;
+#if defined(__APPLE__)
+            sourceFields[2] = (GLuint64)sourceInfo.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+            sourceFields[2] = (GLuint64)sourceInfo.st_mtim.tv_nsec;
+#endif
+            sourceFound = true;
+        }
+
+        const unsigned char* fieldBytes = (const unsigned char*)sourceFields;
+
+        for (size_t byte = 0; byte < sizeof(sourceFields); ++byte)
+        {
+            hash ^= fieldBytes[byte];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    sourceStamp = hash;
+
+    return sourceFound;
+}
+
+
+bool TextureContainer::isContainerFresh(const std::string& containerPath, const std::vector<std::string>& sourcePaths)
+{
+    // Sources that changed in any way since the conversion are converted again, even when they were
+    // replaced by older files. A container without its sources is still used
+    std::ifstream containerFile(containerPath.c_str(), std::ios::binary);
+    ContainerHeader header;
+    GLuint64 sourceStamp;
+
+    if (!containerFile.is_open() || !containerFile.read((char*)&header, sizeof(header)) || header.texMagic != CONTAINER_MAGIC ||
+        header.texVersion != CONTAINER_VERSION)
+        return false;
+
+    return !getSourceStamp(sourcePaths, sourceStamp) || header.texSourceStamp == sourceStamp;
+}
+
+
+bool TextureContainer::loadContainer(const std::string& containerPath, bool texFlip, TextureUsage texUsage, TextureImage& image)
+{
+    std::shared_ptr<FileMapping> mapping = std::make_shared<FileMapping>();
+
+    if (!mapping->mapFile(containerPath) || mapping->getSize() < sizeof(ContainerHeader))
+        return false;
+
+    ContainerHeader header;
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+
+    if (header.texMagic != CONTAINER_MAGIC || header.texVersion != CONTAINER_VERSION || header.texLevels == 0 || header.texLevels > CONTAINER_MAX_LEVELS ||
+        header.texWidth == 0 || header.texHeight == 0 || mapping->getSize() < sizeof(header) + header.texLevels * sizeof(ContainerLevel))
+        return false;
+
+    // Converted for the other orientation, for another kind of texture or colour space, or to a format this driver cannot sample
+    bool texCompressed = (header.texFlags & CONTAINER_COMPRESSED) != 0;
+    bool texSRGB = (header.texFlags & CONTAINER_SRGB) != 0;
+
+    if (((header.texFlags & CONTAINER_FLIPPED) != 0) != texFlip || header.texUsage != (GLuint)texUsage ||
+        texSRGB != TextureCompressor::isFormatSRGB(header.texInternalFormat) || (texSRGB != TextureCompressor::isUsageSRGB(texUsage) && header.texComponents >= 3) ||
+        (texCompressed && !TextureCompressor::isFormatSupported(header.texInternalFormat)))
+        return false;
+
+    // Level sizes are checked against the format, it has to describe the data the way GL reads it
+    GLuint formatComponents = header.texFormat == GL_RED ? 1 : header.texFormat == GL_RG ? 2 : header.texFormat == GL_RGB ? 3 : header.texFormat == GL_RGBA ? 4 : 0;
+
+    if (!texCompressed && (formatComponents != header.texComponents || (header.texType != GL_UNSIGNED_BYTE && header.texType != GL_HALF_FLOAT &&
+        (header.texType != GL_UNSIGNED_INT_5_9_9_9_REV || header.texComponents != 3))))
+        return false;
+
+    image.imageWidth = header.texWidth;
+    image.imageHeight = header.texHeight;
+    image.imageComponents = header.texComponents;
+    image.imageFormat = header.texFormat;
+    image.imageInternalFormat = header.texInternalFormat;
+    image.imageType = header.texType;
+    image.imageCompressed = texCompressed;
+    image.imageData.clear();
+    image.levelSizes.clear();
+
+    // Uploads walk the levels back to back, any gap or truncation means the file is not ours to trust
+    std::vector<ContainerLevel> levels(header.texLevels);
+    std::memcpy(&levels[0], mapping->getData() + sizeof(header), levels.size() * sizeof(ContainerLevel));
+
+    GLuint levelWidth = header.texWidth, levelHeight = header.texHeight;
+
+    for (GLuint level = 0; level < levels.size(); ++level)
+    {
+        if (levels[level].levelSize != getLevelBytes(image, levelWidth, levelHeight) || levels[level].levelOffset + levels[level].levelSize > mapping->getSize() ||
+            (level > 0 && levels[level].levelOffset != levels[level - 1].levelOffset + levels[level - 1].levelSize))
+            return false;
+
+        image.levelSizes.push_back(levels[level].levelSize);
+        levelWidth = std::max(levelWidth / 2, 1u);
+        levelHeight = std::max(levelHeight / 2, 1u);
+    }
+
+    image.imageMappedData = mapping->getData() + levels[0].levelOffset;
+    image.imageMapping = mapping;
+
+    return true;
+}
+
+
+bool TextureContainer::saveContainer(const std::string& containerPath, const std::vector<std::string>& sourcePaths, bool texFlip, TextureUsage texUsage,
+                                     const TextureImage& image)
+{
+    if (image.levelSizes.empty() || image.levelSizes.size() > CONTAINER_MAX_LEVELS)
+        return false;
+
+    ContainerHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.texMagic = CONTAINER_MAGIC;
+    header.texVersion = CONTAINER_VERSION;
+    header.texFlags = (texFlip ? CONTAINER_FLIPPED : 0) | (image.imageCompressed ? CONTAINER_COMPRESSED : 0) |
+                      (TextureCompressor::isFormatSRGB(image.imageInternalFormat) ? CONTAINER_SRGB : 0);
+    header.texUsage = texUsage;
+    header.texWidth = image.imageWidth;
+    header.texHeight = image.imageHeight;
+    header.texComponents = image.imageComponents;
+    header.texLevels = image.levelSizes.size();
+    header.texInternalFormat = image.imageInternalFormat;
+    header.texFormat = image.imageFormat;
+    header.texType = image.imageType;
+    getSourceStamp(sourcePaths, header.texSourceStamp);
+
+    std::vector<ContainerLevel> levels(header.texLevels);
+    GLuint64 levelOffset = (sizeof(header) + levels.size() * sizeof(ContainerLevel) + CONTAINER_ALIGNMENT - 1) / CONTAINER_ALIGNMENT * CONTAINER_ALIGNMENT;
+
+    for (GLuint level = 0; level < levels.size(); ++level)
+    {
+        levels[level].levelOffset = levelOffset;
+        levels[level].levelSize = image.levelSizes[level];
+        levelOffset += image.levelSizes[level];
+    }
+
+    // Written aside and renamed over the old one, a texture still mapped from it keeps its pages
+    // and a reader never sees a file another thread is still writing
+    std::string tempPath = containerPath + "." + std::to_string(containerWrites++) + ".tmp";
+    std::ofstream containerFile(tempPath.c_str(), std::ios::binary);
+
+    if (!containerFile.is_open())
+        return false;
+
+    std::vector<char> padding(levels[0].levelOffset - sizeof(header) - levels.size() * sizeof(ContainerLevel), 0);
+
+    containerFile.write((const char*)&header, sizeof(header));
+    containerFile.write((const char*)&levels[0], levels.size() * sizeof(ContainerLevel));
+
+    if (!padding.empty())
+        containerFile.write(&padding[0], padding.size());
+
+    containerFile.write((const char*)image.getData(), image.getSize());
+    containerFile.close();
+
+    if (!containerFile)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(containerPath.c_str());
+#endif
+
+    return std::rename(tempPath.c_str(), containerPath.c_str()) == 0;
+}
+
+
+GLuint64 TextureContainer::getLevelBytes(const TextureImage& image, GLuint width, GLuint height)
+{
+    if (image.imageCompressed)
+        return (GLuint64)((width + 3) / 4) * ((height + 3) / 4) * TextureCompressor::getBlockBytes(image.imageInternalFormat);
+
+    // Shared exponent texels pack their three channels into one word
+    if (image.imageType == GL_UNSIGNED_INT_5_9_9_9_REV)
+        return (GLuint64)width * height * 4;
+
+    return (GLuint64)width * height * image.imageComponents * (image.imageType == GL_HALF_FLOAT ? 2 : image.imageType == GL_FLOAT ? 4 : 1);
+}
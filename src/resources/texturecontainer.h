@@ -0,0 +1,34 @@
+#ifndef TEXTURECONTAINER_H
+#define TEXTURECONTAINER_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "texturecompressor.h"
+#include "filemapping.h"
+
+
+struct TextureImage;
+
+
+// .ltex files: a small header, the offset and size of every mip level, then the levels
+// back to back in the exact layout glTexImage2D / glCompressedTexImage2D take them.
+// Block-compressed, 8 bit, shared exponent and half-float images keep their whole mip chain,
+// so loading one is a file mapping and one upload per level, with no decoding and no
+// mipmap generation. They are written next to their source when it is first imported,
+// one per orientation and usage the source is loaded with, and stamped with the size and
+// modification time of the sources so any edit converts them again.
+class TextureContainer
+{
+    public:
+        static std::string getContainerPath(const std::string& texPath, bool texFlip, TextureUsage texUsage);
+        static bool isContainerFresh(const std::string& containerPath, const std::vector<std::string>& sourcePaths);
+        static bool loadContainer(const std::string& containerPath, bool texFlip, TextureUsage texUsage, TextureImage& image);
+        static bool saveContainer(const std::string& containerPath, const std::vector<std::string>& sourcePaths, bool texFlip, TextureUsage texUsage,
+                                  const TextureImage& image);
+        static GLuint64 getLevelBytes(const TextureImage& image, GLuint width, GLuint height);
+};
+
+#endif
@@ -0,0 +1,432 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "textureloader.h"
+#include "framestats.h"
+#include "resourceregistry.h"
+
+
+std::vector<std::thread> TextureLoader::loaderThreads;
+std::mutex TextureLoader::loaderMutex;
+std::condition_variable TextureLoader::queuedCondition;
+std::condition_variable TextureLoader::finishedCondition;
+std::deque<std::unique_ptr<TextureLoadJob> > TextureLoader::queuedJobs;
+std::deque<std::unique_ptr<TextureLoadJob> > TextureLoader::finishedJobs;
+std::deque<std::unique_ptr<TextureLoadJob> > TextureLoader::uploadingJobs;
+std::vector<std::vector<unsigned char> > TextureLoader::stagingPool;
+GLuint TextureLoader::activeJobs = 0;
+bool TextureLoader::stopRequested = false;
+GLuint TextureLoader::ringBuffer = 0;
+GLubyte* TextureLoader::ringData = NULL;
+GLuint TextureLoader::ringSize = 32 * 1024 * 1024;
+GLuint TextureLoader::ringHead = 0;
+GLuint TextureLoader::placeholderTextures[TEXTURE_USAGE_COUNT] = { 0, 0, 0, 0, 0 };
+GLuint64 TextureLoader::uploadedCount = 0;
+GLuint64 TextureLoader::uploadedBytes = 0;
+
+
+static const GLuint ringAlignment = 256;       // Slice offsets, comfortably above any unpack alignment
+static const GLuint stagingPoolSize = 8;       // Staging buffers kept around for the next loads
+
+
+void TextureLoader::startLoader(GLuint threadCount)
+{
+    if (isStarted())
+        return;
+
+    // Format support is a GL query, it has to be answered before loader threads ask for it
+    TextureCompressor::isFormatSupported(GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+
+    setPlaceholders();
+
+    // Persistently mapped ring, staged texels are written once and never mapped again
+    if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage)
+    {
+        GLbitfield ringFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &ringBuffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ringBuffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, ringSize, NULL, ringFlags);
+        ringData = (GLubyte*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, ringSize, ringFlags);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        ResourceRegistry::addBuffer(ringBuffer, GL_PIXEL_UNPACK_BUFFER, ringSize, 0, "Texture Upload Ring");
+    }
+
+    if (ringData != NULL)
+        std::cout << "TEXTURES - LOADER : " << threadCount << " THREADS, " << ringSize / (1024 * 1024) << " MB UPLOAD RING" << std::endl;
+    else
+        std::cout << "TEXTURES - LOADER : " << threadCount << " THREADS, UPLOAD RING UNAVAILABLE" << std::endl;
+
+    stopRequested = false;
+    ringHead = 0;
+
+    for (GLuint i = 0; i < threadCount; ++i)
+        loaderThreads.push_back(std::thread(runLoader));
+}
+
+
+void TextureLoader::stopLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        stopRequested = true;
+    }
+
+    queuedCondition.notify_all();
+
+    for (GLuint i = 0; i < loaderThreads.size(); ++i)
+        loaderThreads[i].join();
+
+    loaderThreads.clear();
+
+    // Whatever did not land is dropped, its textures go back to being empty
+    std::deque<std::unique_ptr<TextureLoadJob> >* pendingJobs[] = { &queuedJobs, &finishedJobs, &uploadingJobs };
+
+    for (GLuint i = 0; i < 3; ++i)
+    {
+        for (GLuint j = 0; j < pendingJobs[i]->size(); ++j)
+        {
+            TextureLoadJob& job = *(*pendingJobs[i])[j];
+
+            if (job.uploadFence != 0)
+                glDeleteSync(job.uploadFence);
+
+            job.texture->texReady = true;
+        }
+
+        pendingJobs[i]->clear();
+    }
+
+    if (ringBuffer != 0)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ringBuffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        glDeleteBuffers(1, &ringBuffer);
+        ResourceRegistry::removeResource(RESOURCE_BUFFER, ringBuffer);
+
+        ringBuffer = 0;
+        ringData = NULL;
+    }
+
+    for (GLuint i = 0; i < TEXTURE_USAGE_COUNT; ++i)
+    {
+        glDeleteTextures(1, &placeholderTextures[i]);
+        ResourceRegistry::removeResource(RESOURCE_TEXTURE, placeholderTextures[i]);
+        placeholderTextures[i] = 0;
+    }
+
+    stagingPool.clear();
+}
+
+
+bool TextureLoader::isStarted()
+{
+    return !loaderThreads.empty();
+}
+
+
+void TextureLoader::loadTexture(const std::shared_ptr<Texture>& texture, const std::string& texPath, const std::string& texName, bool texFlip, TextureUsage texUsage)
+{
+    std::unique_ptr<TextureLoadJob> job(new TextureLoadJob());
+    job->texture = texture;
+    job->texPath = texPath;
+    job->texName = texName;
+    job->texFlip = texFlip;
+    job->texUsage = texUsage;
+    job->loadSucceeded = false;
+    job->ringOffset = 0;
+    job->ringBytes = 0;
+    job->uploadFence = 0;
+
+    // Decoded into a recycled buffer, its capacity usually fits the image already
+    if (!stagingPool.empty())
+    {
+        job->texImage.imageData.swap(stagingPool.back());
+        stagingPool.pop_back();
+    }
+
+    // Sampled as the placeholder of its kind until it is resident
+    texture->texName = texName;
+    texture->texPlaceholderID = placeholderTextures[texUsage];
+    texture->texReady = false;
+
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        queuedJobs.push_back(std::move(job));
+    }
+
+    queuedCondition.notify_one();
+}
+
+
+void TextureLoader::pump()
+{
+    if (!isStarted())
+        return;
+
+    retireUploads(false);
+
+    // Oldest first, what does not fit in the ring this frame waits for the next one
+    std::deque<std::unique_ptr<TextureLoadJob> > readyJobs;
+
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        readyJobs.swap(finishedJobs);
+    }
+
+    bool fenceAdded = false;
+
+    while (!readyJobs.empty())
+    {
+        TextureLoadJob& job = *readyJobs.front();
+
+        if (!job.loadSucceeded)
+        {
+            std::cerr << "TEXTURE FAILED - LOADING : " << job.texPath << std::endl;
+
+            job.texture->releaseTexture();
+            job.texture->texReady = true;
+            recycleStaging(job.texImage.imageData);
+            readyJobs.pop_front();
+            continue;
+        }
+
+        GLuint imageBytes = job.texImage.getSize();
+
+        if (ringData != NULL && imageBytes <= ringSize)
+        {
+            if (!allocateRing(imageBytes, job.ringOffset))
+                break;
+
+            job.ringBytes = (imageBytes + ringAlignment - 1) / ringAlignment * ringAlignment;
+            std::memcpy(ringData + job.ringOffset, job.texImage.getData(), imageBytes);
+
+            uploadTexture(job);
+            fenceAdded = true;
+        }
+        else
+        {
+            // Larger than the whole ring, or no ring at all: uploaded straight from staging memory or the mapped container
+            job.texture->setTextureImage(job.texImage, job.texPath, job.texName, job.texImage.getData());
+            job.texture->texReady = true;
+        }
+
+        FrameStats::addEvent("Texture " + job.texName);
+        uploadedCount++;
+        uploadedBytes += imageBytes;
+
+        recycleStaging(job.texImage.imageData);
+        job.texImage.imageMapping.reset();
+
+        if (job.uploadFence != 0)
+            uploadingJobs.push_back(std::move(readyJobs.front()));
+
+        readyJobs.pop_front();
+    }
+
+    // Fences only signal once the commands before them are submitted
+    if (fenceAdded)
+        glFlush();
+
+    if (!readyJobs.empty())
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+
+        while (!readyJobs.empty())
+        {
+            finishedJobs.push_front(std::move(readyJobs.back()));
+            readyJobs.pop_back();
+        }
+    }
+}
+
+
+void TextureLoader::finishLoads()
+{
+    // Blocks until every requested texture is resident, for runs that compare images
+    while (!isIdle())
+    {
+        pump();
+
+        if (!uploadingJobs.empty())
+            retireUploads(true);
+        else
+        {
+            std::unique_lock<std::mutex> lock(loaderMutex);
+            finishedCondition.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+}
+
+
+bool TextureLoader::isIdle()
+{
+    std::lock_guard<std::mutex> lock(loaderMutex);
+
+    return queuedJobs.empty() && finishedJobs.empty() && activeJobs == 0 && uploadingJobs.empty();
+}
+
+
+TextureLoaderStats TextureLoader::getStats()
+{
+    std::lock_guard<std::mutex> lock(loaderMutex);
+
+    TextureLoaderStats stats;
+    stats.queuedCount = queuedJobs.size() + activeJobs + finishedJobs.size();
+    stats.uploadingCount = uploadingJobs.size();
+    stats.threadCount = loaderThreads.size();
+    stats.ringBytes = ringData != NULL ? ringSize : 0;
+    stats.ringUsedBytes = 0;
+    stats.stagingBytes = 0;
+    stats.uploadedCount = uploadedCount;
+    stats.uploadedBytes = uploadedBytes;
+
+    for (GLuint i = 0; i < uploadingJobs.size(); ++i)
+        stats.ringUsedBytes += uploadingJobs[i]->ringBytes;
+
+    for (GLuint i = 0; i < stagingPool.size(); ++i)
+        stats.stagingBytes += stagingPool[i].capacity();
+
+    return stats;
+}
+
+
+void TextureLoader::runLoader()
+{
+    while (true)
+    {
+        std::unique_ptr<TextureLoadJob> job;
+
+        {
+            std::unique_lock<std::mutex> lock(loaderMutex);
+
+            while (!stopRequested && queuedJobs.empty())
+                queuedCondition.wait(lock);
+
+            if (stopRequested)
+                return;
+
+            job = std::move(queuedJobs.front());
+            queuedJobs.pop_front();
+            activeJobs++;
+        }
+
+        // Container mapping, or the file read, decode and conversion when there is no up to date container
+        job->loadSucceeded = Texture::loadTextureImage(job->texPath, job->texFlip, job->texUsage, job->texImage);
+
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+            finishedJobs.push_back(std::move(job));
+            activeJobs--;
+        }
+
+        finishedCondition.notify_all();
+    }
+}
+
+
+bool TextureLoader::allocateRing(GLuint bytes, GLuint& offset)
+{
+    // Slices are retired in the order they were staged, the live part runs from the oldest one to the head
+    bytes = (bytes + ringAlignment - 1) / ringAlignment * ringAlignment;
+
+    if (uploadingJobs.empty())
+        offset = 0;
+    else
+    {
+        GLuint ringTail = uploadingJobs.front()->ringOffset;
+
+        if (ringHead >= ringTail && ringHead + bytes <= ringSize)
+            offset = ringHead;
+        else if (ringHead >= ringTail && bytes < ringTail)
+            offset = 0;
+        else if (ringHead < ringTail && ringHead + bytes < ringTail)
+            offset = ringHead;
+        else
+            return false;
+    }
+
+    ringHead = offset + bytes;
+
+    return true;
+}
+
+
+void TextureLoader::uploadTexture(TextureLoadJob& job)
+{
+    // Level pointers become offsets into the ring while it is bound for unpacking
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ringBuffer);
+    job.texture->setTextureImage(job.texImage, job.texPath, job.texName, (const GLvoid*)(uintptr_t)job.ringOffset);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    job.uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+void TextureLoader::retireUploads(bool waitForOldest)
+{
+    while (!uploadingJobs.empty())
+    {
+        TextureLoadJob& job = *uploadingJobs.front();
+        GLenum waitStatus = glClientWaitSync(job.uploadFence, waitForOldest ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, waitForOldest ? 1000000000 : 0);
+
+        if (waitStatus == GL_TIMEOUT_EXPIRED)
+            break;
+
+        // Copied and mipmapped, the texture replaces its placeholder and its ring slice is free again
+        glDeleteSync(job.uploadFence);
+        job.texture->texReady = true;
+        uploadingJobs.pop_front();
+    }
+}
+
+
+void TextureLoader::recycleStaging(std::vector<unsigned char>& stagingData)
+{
+    if (stagingPool.size() < stagingPoolSize)
+    {
+        stagingPool.push_back(std::vector<unsigned char>());
+        stagingPool.back().swap(stagingData);
+    }
+    else
+        std::vector<unsigned char>().swap(stagingData);
+}
+
+
+void TextureLoader::setPlaceholders()
+{
+    // Neutral 1x1 texels per usage: grey albedo, unoccluded masks, a flat normal and a half rough dielectric.
+    // The albedo one is sRGB like the textures it stands in for
+    const GLubyte placeholderTexels[TEXTURE_USAGE_COUNT][4] = { { 128, 128, 128, 255 }, { 128, 128, 128, 255 }, { 255, 255, 255, 255 },
+                                                                { 128, 128, 255, 255 }, { 128, 0, 0, 255 } };
+
+    glGenTextures(TEXTURE_USAGE_COUNT, placeholderTextures);
+
+    for (GLuint i = 0; i < TEXTURE_USAGE_COUNT; ++i)
+    {
+        GLenum placeholderFormat = TextureCompressor::isUsageSRGB((TextureUsage)i) ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+
+        glBindTexture(GL_TEXTURE_2D, placeholderTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, placeholderFormat, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholderTexels[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        ResourceRegistry::addTexture(placeholderTextures[i], placeholderFormat, 1, 1, 1, false, "Texture Placeholders");
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,82 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <glad/glad.h>
+
+#include "texture.h"
+
+
+// One texture on its way in, from the queue through a loader thread to the upload ring
+struct TextureLoadJob
+{
+    std::shared_ptr<Texture> texture;
+    std::string texPath, texName;
+    bool texFlip;
+    TextureUsage texUsage;
+    TextureImage texImage;          // Filled by the loader thread, mapped from its container or converted into pooled staging memory
+    bool loadSucceeded;
+    GLuint ringOffset, ringBytes;   // Slice of the upload ring the texture was staged in
+    GLsync uploadFence;             // Signaled once the GPU has copied the slice into the texture
+};
+
+
+struct TextureLoaderStats
+{
+    GLuint queuedCount, uploadingCount;     // Waiting for or inside a loader thread, and staged but not resident yet
+    GLuint threadCount;
+    GLuint64 ringBytes, ringUsedBytes;
+    GLuint64 stagingBytes;                  // Pooled staging memory held for reuse
+    GLuint64 uploadedCount, uploadedBytes;
+};
+
+
+// Asynchronous file texture loading. Loader threads map the converted containers (or
+// read, decode and convert the sources into pooled staging memory) in parallel, pump()
+// then streams the results through a persistently mapped pixel unpack buffer ring on the GL thread.
+// A texture binds a placeholder until the fence after its upload is signaled, so a
+// material becomes usable texture by texture instead of stalling a frame for the set.
+class TextureLoader
+{
+    public:
+        static void startLoader(GLuint threadCount);
+        static void stopLoader();
+        static bool isStarted();
+        static void loadTexture(const std::shared_ptr<Texture>& texture, const std::string& texPath, const std::string& texName, bool texFlip, TextureUsage texUsage);
+        static void pump();
+        static void finishLoads();
+        static bool isIdle();
+        static TextureLoaderStats getStats();
+
+    private:
+        static std::vector<std::thread> loaderThreads;
+        static std::mutex loaderMutex;
+        static std::condition_variable queuedCondition, finishedCondition;
+        static std::deque<std::unique_ptr<TextureLoadJob> > queuedJobs, finishedJobs;
+        static std::deque<std::unique_ptr<TextureLoadJob> > uploadingJobs;
+        static std::vector<std::vector<unsigned char> > stagingPool;
+        static GLuint activeJobs;
+        static bool stopRequested;
+
+        static GLuint ringBuffer;
+        static GLubyte* ringData;
+        static GLuint ringSize, ringHead;
+        static GLuint placeholderTextures[TEXTURE_USAGE_COUNT];
+        static GLuint64 uploadedCount, uploadedBytes;
+
+        static void runLoader();
+        static bool allocateRing(GLuint bytes, GLuint& offset);
+        static void uploadTexture(TextureLoadJob& job);
+        static void retireUploads(bool waitForOldest);
+        static void recycleStaging(std::vector<unsigned char>& stagingData);
+        static void setPlaceholders();
+};
+
+#endif
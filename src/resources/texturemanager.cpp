@@ -0,0 +1,306 @@
+#include <string>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+#include <glad/glad.h>
+
+#include "texturemanager.h"
+#include "texturecompressor.h"
+#include "resourceregistry.h"
+
+
+std::map<std::string, TextureCacheEntry> TextureManager::textureEntries;
+GLuint64 TextureManager::budgetBytes = 512ULL * 1024 * 1024;
+GLuint64 TextureManager::requestCount = 0;
+GLuint64 TextureManager::cacheHits = 0;
+GLuint64 TextureManager::cacheMisses = 0;
+GLuint64 TextureManager::cacheEvictions = 0;
+GLint TextureManager::loaderThreads = -1;
+bool TextureManager::convertRequested = false;
+
+
+bool TextureManager::isTextureOption(const std::string& arg)
+{
+    return arg == "--texture-budget" || arg == "--texture-compression" || arg == "--texture-threads" || arg == "--hdr-format" ||
+           arg == "--convert-textures";
+}
+
+
+bool TextureManager::setTextureOptions(int argc, char* argv[])
+{
+    // Only texture cache options are read here, the benchmark parser handles the rest
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc) && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+
+        if (arg == "--texture-budget" && hasValue)
+        {
+            int budgetMB = std::atoi(argv[++i]);
+
+            if (budgetMB < 0)
+            {
+                std::cerr << "TEXTURES - INVALID BUDGET : " << budgetMB << " MB" << std::endl;
+                return false;
+            }
+
+            budgetBytes = (GLuint64)budgetMB * 1024 * 1024;
+        }
+        else if (arg == "--texture-compression" && hasValue)
+        {
+            std::string mode = argv[++i];
+
+            if (mode != "on" && mode != "off")
+            {
+                std::cerr << "TEXTURES - INVALID COMPRESSION MODE : " << mode << std::endl;
+                return false;
+            }
+
+            TextureCompressor::setCompression(mode == "on");
+        }
+        else if (arg == "--hdr-format" && hasValue)
+        {
+            std::string format = argv[++i];
+
+            if (format != "compact" && format != "float")
+            {
+                std::cerr << "TEXTURES - INVALID HDR FORMAT : " << format << std::endl;
+                return false;
+            }
+
+            TextureCompressor::setCompactHDR(format == "compact");
+        }
+        else if (arg == "--texture-threads" && hasValue)
+        {
+            loaderThreads = std::atoi(argv[++i]);
+
+            if (loaderThreads < 0)
+            {
+                std::cerr << "TEXTURES - INVALID THREAD COUNT : " << loaderThreads << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--convert-textures")
+            convertRequested = true;
+    }
+
+    return true;
+}
+
+
+bool TextureManager::isConvertRequested()
+{
+    return convertRequested;
+}
+
+
+TextureHandle TextureManager::getTexture(const std::string& texPath, const std::string& texName, bool texFlip, TextureUsage texUsage)
+{
+    return getCachedTexture(texPath, texName, texFlip, false, texUsage, false);
+}
+
+
+TextureHandle TextureManager::requestTexture(const std::string& texPath, const std::string& texName, bool texFlip, TextureUsage texUsage)
+{
+    return getCachedTexture(texPath, texName, texFlip, false, texUsage, TextureLoader::isStarted());
+}
+
+
+TextureHandle TextureManager::getTextureHDR(const std::string& texPath, const std::string& texName, bool texFlip)
+{
+    return getCachedTexture(texPath, texName, texFlip, true, TEXTURE_USAGE_NONE, false);
+}
+
+
+void TextureManager::startLoading()
+{
+    // Half the cores, the GL thread and the driver keep the rest
+    GLuint threadCount = loaderThreads >= 0 ? loaderThreads : std::max(std::min(std::thread::hardware_concurrency() / 2, 4u), 1u);
+
+    if (threadCount > 0)
+        TextureLoader::startLoader(threadCount);
+}
+
+
+void TextureManager::stopLoading()
+{
+    TextureLoader::stopLoader();
+    updateEntries();
+}
+
+
+void TextureManager::pumpTextures()
+{
+    TextureLoader::pump();
+
+    if (updateEntries())
+        trimTextures();
+}
+
+
+void TextureManager::finishLoads()
+{
+    TextureLoader::finishLoads();
+
+    if (updateEntries())
+        trimTextures();
+}
+
+
+void TextureManager::trimTextures()
+{
+    // Textures still held outside the cache cannot be freed, they only count towards the total
+    GLuint64 totalBytes = 0;
+
+    for (std::map<std::string, TextureCacheEntry>::iterator it = textureEntries.begin(); it != textureEntries.end(); ++it)
+        totalBytes += it->second.texBytes;
+
+    while (totalBytes > budgetBytes)
+    {
+        std::map<std::string, TextureCacheEntry>::iterator oldest = textureEntries.end();
+
+        for (std::map<std::string, TextureCacheEntry>::iterator it = textureEntries.begin(); it != textureEntries.end(); ++it)
+        {
+            if (it->second.texture.use_count() == 1 && (oldest == textureEntries.end() || it->second.lastUse < oldest->second.lastUse))
+                oldest = it;
+        }
+
+        if (oldest == textureEntries.end())
+            break;
+
+        // Last handle, the texture releases its GL object
+        totalBytes -= oldest->second.texBytes;
+        textureEntries.erase(oldest);
+        cacheEvictions++;
+    }
+}
+
+
+void TextureManager::releaseTextures()
+{
+    // Handles still held elsewhere keep their texture alive until they are reset
+    textureEntries.clear();
+}
+
+
+void TextureManager::setBudget(GLuint64 bytes)
+{
+    budgetBytes = bytes;
+    trimTextures();
+}
+
+
+GLuint64 TextureManager::getBudget()
+{
+    return budgetBytes;
+}
+
+
+TextureCacheStats TextureManager::getStats()
+{
+    TextureCacheStats stats;
+    stats.textureCount = textureEntries.size();
+    stats.idleCount = 0;
+    stats.textureBytes = 0;
+    stats.idleBytes = 0;
+    stats.cacheHits = cacheHits;
+    stats.cacheMisses = cacheMisses;
+    stats.cacheEvictions = cacheEvictions;
+
+    for (std::map<std::string, TextureCacheEntry>::iterator it = textureEntries.begin(); it != textureEntries.end(); ++it)
+    {
+        stats.textureBytes += it->second.texBytes;
+
+        if (it->second.texture.use_count() == 1)
+        {
+            stats.idleCount++;
+            stats.idleBytes += it->second.texBytes;
+        }
+    }
+
+    return stats;
+}
+
+
+TextureHandle TextureManager::getCachedTexture(const std::string& texPath, const std::string& texName, bool texFlip, bool texHDR, TextureUsage texUsage, bool texAsync)
+{
+    // The same file loaded flipped, as HDR or compressed for another usage is a different texture
+    static const char* usageKeys[] = { "", "|color", "|mask", "|normal", "|orm" };
+    std::string cacheKey = texPath + (texHDR ? "|hdr" : "|ldr") + (texFlip ? "|flip" : "") + usageKeys[texUsage];
+    std::map<std::string, TextureCacheEntry>::iterator entry = textureEntries.find(cacheKey);
+
+    requestCount++;
+
+    if (entry != textureEntries.end())
+    {
+        cacheHits++;
+        entry->second.lastUse = requestCount;
+
+        return entry->second.texture;
+    }
+
+    cacheMisses++;
+
+    TextureHandle texture = std::make_shared<Texture>();
+
+    // Cached right away, its size is known once it lands
+    if (texAsync)
+    {
+        TextureLoader::loadTexture(texture, texPath, texName, texFlip, texUsage);
+
+        TextureCacheEntry& newEntry = textureEntries[cacheKey];
+        newEntry.texture = texture;
+        newEntry.texBytes = 0;
+        newEntry.lastUse = requestCount;
+
+        return texture;
+    }
+
+    if (texHDR)
+        texture->setTextureHDR(texPath.c_str(), texName, texFlip);
+    else
+        texture->setTexture(texPath.c_str(), texName, texFlip, texUsage);
+
+    // Failed loads are not kept, the next request tries the file again
+    if (texture->getTexWidth() == 0)
+        return texture;
+
+    TextureCacheEntry& newEntry = textureEntries[cacheKey];
+    newEntry.texture = texture;
+    newEntry.texBytes = ResourceRegistry::getDeviceBytes(RESOURCE_TEXTURE, texture->getTexID());
+    newEntry.lastUse = requestCount;
+
+    trimTextures();
+
+    return texture;
+}
+
+
+bool TextureManager::updateEntries()
+{
+    // Streamed textures that landed get their size, failed ones are dropped so the next request tries the file again
+    bool sizesChanged = false;
+    std::map<std::string, TextureCacheEntry>::iterator it = textureEntries.begin();
+
+    while (it != textureEntries.end())
+    {
+        Texture& texture = *it->second.texture;
+
+        if (!texture.isTextureReady() || it->second.texBytes != 0)
+            ++it;
+        else if (texture.getTexWidth() == 0)
+            textureEntries.erase(it++);
+        else
+        {
+            it->second.texBytes = ResourceRegistry::getDeviceBytes(RESOURCE_TEXTURE, texture.getTexID());
+            sizesChanged = true;
+            ++it;
+        }
+    }
+
+    return sizesChanged;
+}
@@ -0,0 +1,72 @@
+#ifndef TEXTUREMANAGER_H
+#define TEXTUREMANAGER_H
+
+#include <string>
+#include <map>
+#include <memory>
+
+#include <glad/glad.h>
+
+#include "texture.h"
+#include "textureloader.h"
+
+
+// Shared handle to a cached texture, the GL object goes away with the last handle
+typedef std::shared_ptr<Texture> TextureHandle;
+
+
+struct TextureCacheEntry
+{
+    TextureHandle texture;
+    GLuint64 texBytes;          // Estimated video memory, mip chain included
+    GLuint64 lastUse;           // Request counter at the last lookup, the lowest is evicted first
+};
+
+
+struct TextureCacheStats
+{
+    GLuint textureCount, idleCount;         // Idle textures are only held by the cache
+    GLuint64 textureBytes, idleBytes;
+    GLuint64 cacheHits, cacheMisses, cacheEvictions;
+};
+
+
+// File textures shared by path and load parameters. Loading the same file again
+// returns the texture already in memory, textures nobody holds anymore stay
+// resident until the cache goes over its memory budget, least recently used first.
+// Textures given a usage are block-compressed on import unless compression is off.
+// Requested textures are streamed in by the texture loader, loaded ones right away.
+// Every file texture is loaded from its .ltex container, converted on first use or
+// ahead of time with --convert-textures.
+class TextureManager
+{
+    public:
+        static bool isTextureOption(const std::string& arg);
+        static bool setTextureOptions(int argc, char* argv[]);
+        static bool isConvertRequested();
+        static TextureHandle getTexture(const std::string& texPath, const std::string& texName, bool texFlip, TextureUsage texUsage = TEXTURE_USAGE_NONE);
+        static TextureHandle requestTexture(const std::string& texPath, const std::string& texName, bool texFlip, TextureUsage texUsage = TEXTURE_USAGE_NONE);
+        static TextureHandle getTextureHDR(const std::string& texPath, const std::string& texName, bool texFlip);
+        static void startLoading();
+        static void stopLoading();
+        static void pumpTextures();
+        static void finishLoads();
+        static void trimTextures();
+        static void releaseTextures();
+        static void setBudget(GLuint64 bytes);
+        static GLuint64 getBudget();
+        static TextureCacheStats getStats();
+
+    private:
+        static std::map<std::string, TextureCacheEntry> textureEntries;
+        static GLuint64 budgetBytes;
+        static GLuint64 requestCount;
+        static GLuint64 cacheHits, cacheMisses, cacheEvictions;
+        static GLint loaderThreads;             // -1 picks from the core count, 0 loads every texture on the spot
+        static bool convertRequested;
+
+        static TextureHandle getCachedTexture(const std::string& texPath, const std::string& texName, bool texFlip, bool texHDR, TextureUsage texUsage, bool texAsync);
+        static bool updateEntries();
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include "uniformbuffer.h"
+#include "resourceregistry.h"
+
+
+UniformBuffer::UniformBuffer()
+{
+    this->uboID = 0;
+    this->uboBinding = 0;
+    this->uboSize = 0;
+}
+
+
+UniformBuffer::~UniformBuffer()
+{
+    this->releaseUniformBuffer();
+}
+
+
+void UniformBuffer::setUniformBuffer(const std::string& blockName, GLuint binding, GLuint size)
+{
+    this->releaseUniformBuffer();
+
+    this->uboName = blockName;
+    this->uboBinding = binding;
+    this->uboSize = size;
+    this->uboData.clear();
+
+    glGenBuffers(1, &this->uboID);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->uboID);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // The binding point stays attached to the buffer, programs only need to be pointed at it
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, this->uboID);
+
+    ResourceRegistry::addBuffer(this->uboID, GL_UNIFORM_BUFFER, size, 0, "Uniforms " + blockName);
+}
+
+
+void UniformBuffer::updateUniformBuffer(const void* data)
+{
+    if (this->uboID == 0)
+        return;
+
+    if (!this->uboData.empty() && std::memcmp(&this->uboData[0], data, this->uboSize) == 0)
+        return;
+
+    this->uboData.assign((const unsigned char*)data, (const unsigned char*)data + this->uboSize);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->uboID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, this->uboSize, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+
+void UniformBuffer::releaseUniformBuffer()
+{
+    if (this->uboID == 0)
+        return;
+
+    glDeleteBuffers(1, &this->uboID);
+    ResourceRegistry::removeResource(RESOURCE_BUFFER, this->uboID);
+
+    this->uboID = 0;
+    this->uboData.clear();
+}
+
+
+GLint UniformBuffer::getBlockBinding(const std::string& blockName)
+{
+    if (blockName == "FrameData")
+        return UNIFORM_BLOCK_FRAME;
+    if (blockName == "SAOData")
+        return UNIFORM_BLOCK_SAO;
+
+    return -1;
+}
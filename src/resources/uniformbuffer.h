@@ -0,0 +1,58 @@
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+
+// Fixed binding points of the shared blocks in resources/shaders/uniformBlocks.glsl.
+// GLSL 400 has no layout(binding), programs are pointed at them after link.
+enum UniformBlockBinding
+{
+    UNIFORM_BLOCK_FRAME = 0,
+    UNIFORM_BLOCK_SAO = 1
+};
+
+
+// std140 mirrors of the shared blocks, members are kept in 16 byte rows
+struct FrameUniforms
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 inverseView;
+    glm::mat4 inverseProj;
+    glm::vec2 viewportSize;
+    glm::vec2 texelSize;
+    GLfloat cameraAperture, cameraShutterSpeed, cameraISO, motionBlurScale;
+    GLint motionBlurMaxSamples, padding[3];
+};
+
+
+struct SAOUniforms
+{
+    GLint saoSamples, saoTurns;
+    GLfloat saoRadius, saoBias, saoScale, saoContrast, padding[2];
+};
+
+
+class UniformBuffer
+{
+    public:
+        GLuint uboID, uboBinding, uboSize;
+        std::string uboName;
+
+        UniformBuffer();
+        ~UniformBuffer();
+        void setUniformBuffer(const std::string& blockName, GLuint binding, GLuint size);
+        void updateUniformBuffer(const void* data);
+        void releaseUniformBuffer();
+        static GLint getBlockBinding(const std::string& blockName);
+
+    private:
+        std::vector<unsigned char> uboData;     // Last uploaded content, identical updates are skipped
+};
+
+#endif